@@ -0,0 +1,746 @@
+// hypr-grid-bench: end-to-end keypress-to-placement latency against
+// hypr-grid-mock-hyprland. Every apply cycles through the preset positions
+// and is measured from the "keypress" until the placement returns, either
+// in-process or by launching the binaries the way a keybinding does.
+//
+// Usage:
+//   hypr-grid-bench [options]
+//
+// Options:
+//   --mode MODE          inprocess (default), cli (hypr-grid-manager -a) or
+//                        client (hypr-grid-client with a running daemon)
+//   --transport T        socket (default) or hyprctl, which hides the socket
+//                        so every request goes through the hyprctl fallback
+//   --iterations N       measured applies (default 200)
+//   --warmup N           unmeasured applies first (default 5)
+//   --latency MS         injected delay per Hyprland reply (default 0)
+//   --clients N          windows in the mock (default 4)
+//   --monitors SPEC      mock monitors, see hypr-grid-mock-hyprland
+//   --preset NAME        only this preset (default: all)
+//   --mirror             inprocess only: enable the event-driven state mirror
+//   --snapshot           cli only: run a daemon alongside, so the launched
+//                        processes read its shared-memory state snapshot
+//   --burst K            cli and client: launch K applies at once per
+//                        iteration, like a held-down key; measured until all
+//                        of them exit
+//   --burst-gap MS       delay between the launches of a burst (default 0)
+//   --cold-monitors      drop the monitor cache before every measured
+//                        apply, so each one queries the monitors again
+//   --check-breaker      inprocess only: instead of measuring, check that the
+//                        circuit breaker opens after "breakerThreshold"
+//                        applies time out and then fails applies fast; give
+//                        --latency above "applyBudgetMs"
+//   --user-config        use ~/.config instead of the built-in defaults
+//   --bin-dir DIR        where the binaries are (default: next to this one)
+//   --output FILE        write the JSON result here instead of stdout
+//   --verbose            keep the application's debug output
+//
+// Reports p50/p90/p99/max wall time, Hyprland requests and commands per
+// apply (counted by the mock) and processes spawned per apply (through
+// logging stand-ins for hyprctl, notify-send and zenity; in the cli
+// and client modes the launched binary counts too). With --burst the apply
+// queue counters (dropped, cancelled, deepest queue, settle time) are
+// reported as well, and every burst is checked to leave the window where
+// its last launch puts it. The cli and client modes also report the time
+// from each launch until the mock gets its first request (startup to first
+// IPC; in client mode that request comes from the daemon). Requests are ordered by when they reach the
+// queue, so without a gap racing launches can make a few bursts miss.
+//
+// Notifications never reach the desktop: when dbus-daemon is available the
+// benchmark runs a private session bus with its own
+// org.freedesktop.Notifications that counts calls and bubbles. Otherwise
+// the session bus is hidden and the notify-send stand-in is used.
+
+#include "gridmanager.h"
+#include "config.h"
+#include "applyqueue.h"
+#include "daemonprotocol.h"
+#include "hyprlandipc.h"
+#include "monitorcache.h"
+
+#include <QCoreApplication>
+#include <QDBusConnection>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+const char *const MockSignature = "hypr-grid-bench";
+
+struct Options {
+    QString mode = "inprocess";
+    QString transport = "socket";
+    int iterations = 200;
+    int warmup = 5;
+    int latencyMs = 0;
+    int clients = 4;
+    QString monitors = "DP-1:2560x1440";
+    QString preset;
+    bool mirror = false;
+    bool snapshot = false;
+    int burst = 1;
+    int burstGapMs = 0;
+    bool coldMonitors = false;
+    bool checkBreaker = false;
+    bool userConfig = false;
+    bool verbose = false;
+    QString binDir;
+    QString output;
+};
+
+struct Counters {
+    long requests = 0;
+    long commands = 0;
+    long spawns = 0;
+    long long firstRequestUs = -1;  // CLOCK_MONOTONIC, since the previous read
+};
+
+bool g_verbose = false;
+
+void messageHandler(QtMsgType type, const QMessageLogContext &, const QString &message)
+{
+    if (g_verbose || type >= QtWarningMsg) {
+        fprintf(stderr, "%s\n", qPrintable(message));
+    }
+}
+
+int usage(const char *program)
+{
+    fprintf(stderr, "Usage: %s [--mode inprocess|cli|client] [--transport socket|hyprctl] [--iterations N]\n"
+                    "          [--warmup N] [--latency MS] [--clients N] [--monitors SPEC] [--preset NAME]\n"
+                    "          [--mirror] [--snapshot] [--burst K] [--burst-gap MS] [--cold-monitors] [--check-breaker]\n"
+                    "          [--user-config] [--bin-dir DIR] [--output FILE] [--verbose]\n",
+            program);
+    return 2;
+}
+
+bool parseOptions(const QStringList &args, Options &options)
+{
+    for (int i = 1; i < args.size(); ++i) {
+        const QString &arg = args[i];
+        const bool hasValue = i + 1 < args.size();
+        if (arg == "--mirror") {
+            options.mirror = true;
+        } else if (arg == "--snapshot") {
+            options.snapshot = true;
+        } else if (arg == "--cold-monitors") {
+            options.coldMonitors = true;
+        } else if (arg == "--check-breaker") {
+            options.checkBreaker = true;
+        } else if (arg == "--user-config") {
+            options.userConfig = true;
+        } else if (arg == "--verbose") {
+            options.verbose = true;
+        } else if (!hasValue) {
+            return false;
+        } else if (arg == "--mode") {
+            options.mode = args[++i];
+        } else if (arg == "--transport") {
+            options.transport = args[++i];
+        } else if (arg == "--iterations") {
+            options.iterations = args[++i].toInt();
+        } else if (arg == "--warmup") {
+            options.warmup = args[++i].toInt();
+        } else if (arg == "--latency") {
+            options.latencyMs = args[++i].toInt();
+        } else if (arg == "--clients") {
+            options.clients = args[++i].toInt();
+        } else if (arg == "--monitors") {
+            options.monitors = args[++i];
+        } else if (arg == "--burst") {
+            options.burst = args[++i].toInt();
+        } else if (arg == "--burst-gap") {
+            options.burstGapMs = args[++i].toInt();
+        } else if (arg == "--preset") {
+            options.preset = args[++i];
+        } else if (arg == "--bin-dir") {
+            options.binDir = args[++i];
+        } else if (arg == "--output") {
+            options.output = args[++i];
+        } else {
+            return false;
+        }
+    }
+    
+    return (options.mode == "inprocess" || options.mode == "cli" || options.mode == "client") &&
+           (options.transport == "socket" || options.transport == "hyprctl") &&
+           options.iterations > 0 && options.warmup >= 0 &&
+           options.burst > 0 && (options.burst == 1 || options.mode != "inprocess") &&
+           (!options.snapshot || options.mode == "cli") &&
+           (!options.checkBreaker || options.mode == "inprocess");
+}
+
+bool writeScript(const QString &path, const QString &body)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    file.write("#!/bin/sh\n" + body.toUtf8() + "\n");
+    file.close();
+    return file.setPermissions(file.permissions() | QFileDevice::ExeOwner);
+}
+
+// Stand-ins that log every launch; hyprctl forwards to the mock
+bool installStubs(const QString &dir, const QString &log, const QString &mock, const QString &runtimeDir)
+{
+    const QString logLine = QString("echo \"$(basename \"$0\")\" >> '%1'\n").arg(log);
+    return writeScript(dir + "/hyprctl", logLine +
+                       QString("XDG_RUNTIME_DIR='%1' HYPRLAND_INSTANCE_SIGNATURE='%2' exec '%3' --hyprctl \"$@\"")
+                           .arg(runtimeDir, MockSignature, mock)) &&
+           writeScript(dir + "/notify-send", logLine + "exit 0") &&
+           writeScript(dir + "/zenity", logLine + "exit 0");
+}
+
+bool waitForFile(const QString &path, int timeoutMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!QFileInfo::exists(path)) {
+        if (timer.elapsed() > timeoutMs) {
+            return false;
+        }
+        QThread::msleep(5);
+    }
+    return true;
+}
+
+QByteArray queryMock(const QString &socketPath, const QByteArray &request)
+{
+    int fd = HyprlandIPC::connectSocket(socketPath);
+    if (fd < 0) {
+        return QByteArray();
+    }
+    
+    QByteArray reply;
+    if (::write(fd, request.constData(), request.size()) == request.size()) {
+        char buffer[256];
+        ssize_t n;
+        while ((n = ::read(fd, buffer, sizeof(buffer))) > 0) {
+            reply.append(buffer, n);
+        }
+    }
+    ::close(fd);
+    return reply;
+}
+
+// Ask the mock how much it has served; the query itself is not counted
+bool readMockStats(const QString &socketPath, Counters &counters)
+{
+    QJsonObject stats = QJsonDocument::fromJson(queryMock(socketPath, "j/mockstats")).object();
+    if (stats.isEmpty()) {
+        return false;
+    }
+    counters.requests = stats["requests"].toInteger();
+    counters.commands = stats["commands"].toInteger();
+    counters.firstRequestUs = stats["firstRequestUs"].toInteger(-1);
+    return true;
+}
+
+// Same clock the mock stamps requests with
+long long monotonicUs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<long long>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Position and size of the focused window, for comparing outcomes
+QJsonArray activeGeometry(const QString &socketPath)
+{
+    QJsonObject window = QJsonDocument::fromJson(queryMock(socketPath, "j/activewindow")).object();
+    return QJsonArray() << window["at"] << window["size"];
+}
+
+long countLines(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    return file.readAll().count('\n');
+}
+
+double percentile(const std::vector<double> &sorted, double p)
+{
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+// Start a private session bus, returning its address or an empty string
+QString startSessionBus(QProcess &daemon)
+{
+    daemon.start("dbus-daemon", QStringList() << "--session" << "--nofork" << "--print-address=1");
+    if (!daemon.waitForStarted(2000)) {
+        return QString();
+    }
+    
+    QElapsedTimer timer;
+    timer.start();
+    while (!daemon.canReadLine() && timer.elapsed() < 2000) {
+        daemon.waitForReadyRead(100);
+    }
+    return QString::fromUtf8(daemon.readLine()).trimmed();
+}
+
+bool runProcess(const QString &program, const QStringList &args)
+{
+    QProcess process;
+    process.setStandardOutputFile(QProcess::nullDevice());
+    if (!g_verbose) {
+        process.setStandardErrorFile(QProcess::nullDevice());
+    }
+    process.start(program, args);
+    return process.waitForFinished(10000) && process.exitStatus() == QProcess::NormalExit &&
+           process.exitCode() == 0;
+}
+
+// Launch all, gapMs apart, and wait for every one of them
+bool runProcesses(const QString &program, const QList<QStringList> &argLists, int gapMs)
+{
+    std::vector<std::unique_ptr<QProcess>> processes;
+    for (const QStringList &args : argLists) {
+        if (gapMs > 0 && !processes.empty()) {
+            QThread::msleep(gapMs);
+        }
+        processes.push_back(std::make_unique<QProcess>());
+        processes.back()->setStandardOutputFile(QProcess::nullDevice());
+        if (!g_verbose) {
+            processes.back()->setStandardErrorFile(QProcess::nullDevice());
+        }
+        processes.back()->start(program, args);
+    }
+    
+    bool ok = true;
+    for (auto &process : processes) {
+        ok = process->waitForFinished(10000) && process->exitStatus() == QProcess::NormalExit &&
+             process->exitCode() == 0 && ok;
+    }
+    return ok;
+}
+
+// Applies against a Hyprland slower than the apply budget: each one should
+// time out once, the breaker should open after the configured threshold,
+// and the apply after that should be refused without waiting
+QJsonObject checkBreaker(GridManager &manager, const QList<QPair<QString, QString>> &positions)
+{
+    const QVariantMap advanced = manager.getConfig()->getAdvancedConfig();
+    const int threshold = advanced.value("breakerThreshold", 3).toInt();
+    const int budgetMs = advanced.value("applyBudgetMs", 2000).toInt();
+    
+    QJsonArray appliesMs;
+    int opensAfter = -1;
+    QElapsedTimer timer;
+    for (int i = 0; i < threshold + 2 && opensAfter < 0; ++i) {
+        timer.start();
+        manager.applyPositionByCode(positions[i % positions.size()].first, positions[i % positions.size()].second);
+        appliesMs.append(timer.nsecsElapsed() / 1e6);
+        if (manager.hyprland()->breaker().state() == CircuitBreaker::Open) {
+            opensAfter = i + 1;
+        }
+    }
+    
+    double fastFailMs = -1;
+    if (opensAfter > 0) {
+        timer.start();
+        manager.applyPositionByCode(positions[0].first, positions[0].second);
+        fastFailMs = timer.nsecsElapsed() / 1e6;
+    }
+    
+    QJsonObject result;
+    result["threshold"] = threshold;
+    result["applyBudgetMs"] = budgetMs;
+    result["opensAfterApplies"] = opensAfter;
+    result["appliesMs"] = appliesMs;
+    result["fastFailMs"] = fastFailMs;
+    result["timeouts"] = static_cast<double>(manager.hyprland()->breaker().stats().timeouts);
+    result["passed"] = opensAfter == threshold && fastFailMs >= 0 && fastFailMs < budgetMs / 10.0;
+    return result;
+}
+
+} // namespace
+
+// Stand-in notification daemon; it lives on its own thread so it answers
+// while the benchmark is blocked waiting for a launched process
+class NotificationsStandIn : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.Notifications")
+    
+public:
+    std::atomic<long> calls{0};
+    std::atomic<long> bubbles{0};
+    
+public slots:
+    uint Notify(const QString &, uint replacesId, const QString &, const QString &,
+                const QString &, const QStringList &, const QVariantMap &, int)
+    {
+        ++calls;
+        if (replacesId != 0) {
+            return replacesId;
+        }
+        return static_cast<uint>(++bubbles);
+    }
+    
+    QStringList GetCapabilities() { return QStringList() << "body"; }
+    void CloseNotification(uint) {}
+};
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    
+    Options options;
+    if (!parseOptions(app.arguments(), options)) {
+        return usage(argv[0]);
+    }
+    g_verbose = options.verbose;
+    qInstallMessageHandler(messageHandler);
+    
+    const QString binDir = options.binDir.isEmpty() ? app.applicationDirPath() : options.binDir;
+    const QString mockPath = binDir + "/hypr-grid-mock-hyprland";
+    if (!QFileInfo(mockPath).isExecutable()) {
+        fprintf(stderr, "hypr-grid-bench: %s not found, configure with -DBUILD_TOOLS=ON\n", qPrintable(mockPath));
+        return 1;
+    }
+    
+    QTemporaryDir workDir;
+    const QString runtimeDir = workDir.path() + "/runtime";
+    const QString homeDir = workDir.path() + "/home";
+    const QString stubDir = workDir.path() + "/bin";
+    const QString spawnLog = workDir.path() + "/spawns.log";
+    QDir().mkpath(runtimeDir);
+    QDir().mkpath(homeDir);
+    QDir().mkpath(stubDir);
+    
+    if (!installStubs(stubDir, spawnLog, mockPath, runtimeDir)) {
+        fprintf(stderr, "hypr-grid-bench: cannot write stand-ins to %s\n", qPrintable(stubDir));
+        return 1;
+    }
+    
+    QProcess mock;
+    mock.setStandardOutputFile(QProcess::nullDevice());
+    mock.start(mockPath, QStringList()
+               << "--runtime-dir" << runtimeDir << "--signature" << MockSignature
+               << "--latency" << QString::number(options.latencyMs)
+               << "--clients" << QString::number(options.clients)
+               << "--monitors" << options.monitors);
+    const QString socketPath = QString("%1/hypr/%2/.socket.sock").arg(runtimeDir, MockSignature);
+    if (!mock.waitForStarted() || !waitForFile(socketPath, 3000)) {
+        fprintf(stderr, "hypr-grid-bench: mock Hyprland did not start\n");
+        return 1;
+    }
+    
+    // Keep notifications off the desktop, see the top of this file
+    QProcess busDaemon;
+    const QString busAddress = startSessionBus(busDaemon);
+    qputenv("DBUS_SESSION_BUS_ADDRESS", busAddress.isEmpty()
+            ? QString("unix:path=%1/no-bus").arg(workDir.path()).toLocal8Bit() : busAddress.toLocal8Bit());
+    
+    QThread notificationThread;
+    NotificationsStandIn notifications;
+    if (!busAddress.isEmpty()) {
+        notifications.moveToThread(&notificationThread);
+        notificationThread.start();
+        QDBusConnection bus = QDBusConnection::sessionBus();
+        if (!bus.registerObject("/org/freedesktop/Notifications", &notifications,
+                                QDBusConnection::ExportAllSlots) ||
+            !bus.registerService("org.freedesktop.Notifications")) {
+            fprintf(stderr, "hypr-grid-bench: cannot register the notification stand-in\n");
+            return 1;
+        }
+    }
+    
+    // Everything started from here on sees the mock. With the hyprctl
+    // transport the signature points nowhere, so only the stand-in reaches it.
+    qputenv("XDG_RUNTIME_DIR", runtimeDir.toLocal8Bit());
+    qputenv("HYPRLAND_INSTANCE_SIGNATURE",
+            options.transport == "socket" ? QByteArray(MockSignature) : QByteArray("hypr-grid-bench-hidden"));
+    qputenv("PATH", stubDir.toLocal8Bit() + ":" + qgetenv("PATH"));
+    if (!options.userConfig) {
+        qputenv("HOME", homeDir.toLocal8Bit());
+    }
+    
+    // Positions to cycle through, from the same configuration the app loads
+    Config config;
+    config.load();
+    QList<QPair<QString, QString>> positions;
+    const auto presets = config.getPresets();
+    for (auto preset = presets.constBegin(); preset != presets.constEnd(); ++preset) {
+        if (!options.preset.isEmpty() && preset.key() != options.preset) {
+            continue;
+        }
+        for (auto position = preset->constBegin(); position != preset->constEnd(); ++position) {
+            positions.append(qMakePair(preset.key(), position.key()));
+        }
+    }
+    if (positions.isEmpty()) {
+        fprintf(stderr, "hypr-grid-bench: no positions to apply\n");
+        return 1;
+    }
+    
+    // The application's std::cout debug output would drown the results
+    std::ofstream devNull("/dev/null");
+    std::streambuf *coutBuffer = std::cout.rdbuf();
+    if (!options.verbose) {
+        std::cout.rdbuf(devNull.rdbuf());
+    }
+    
+    GridManager *manager = nullptr;
+    QProcess daemon;
+    const QString managerPath = binDir + "/hypr-grid-manager";
+    const QString clientPath = binDir + "/hypr-grid-client";
+    
+    if (options.mode == "inprocess") {
+        manager = new GridManager;
+        if (!manager->initialize()) {
+            fprintf(stderr, "hypr-grid-bench: GridManager failed to initialize\n");
+            return 1;
+        }
+        if (options.mirror) {
+            manager->enableStateMirror();
+        }
+        if (options.checkBreaker) {
+            const QJsonObject result = checkBreaker(*manager, positions);
+            std::cout.rdbuf(coutBuffer);
+            delete manager;
+            mock.terminate();
+            mock.waitForFinished(2000);
+            notificationThread.quit();
+            notificationThread.wait();
+            busDaemon.terminate();
+            busDaemon.waitForFinished(2000);
+            
+            const QByteArray json = QJsonDocument(result).toJson(QJsonDocument::Indented);
+            QFile file(options.output);
+            if (options.output.isEmpty()) {
+                fwrite(json.constData(), 1, json.size(), stdout);
+            } else if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size()) {
+                fprintf(stderr, "hypr-grid-bench: cannot write %s\n", qPrintable(options.output));
+                return 1;
+            }
+            fprintf(stderr, "breaker: opened after %d of %d applies, next apply refused in %.2f ms: %s\n",
+                    result["opensAfterApplies"].toInt(), result["threshold"].toInt(),
+                    result["fastFailMs"].toDouble(), result["passed"].toBool() ? "ok" : "FAILED");
+            return result["passed"].toBool() ? 0 : 1;
+        }
+    } else if (options.mode == "client" || options.snapshot) {
+        daemon.setStandardOutputFile(QProcess::nullDevice());
+        daemon.start(managerPath, QStringList() << "--daemon");
+        if (!daemon.waitForStarted() ||
+            !waitForFile(QString::fromStdString(DaemonProtocol::socketPath()), 5000)) {
+            fprintf(stderr, "hypr-grid-bench: daemon did not start\n");
+            return 1;
+        }
+        // Published once the daemon's state mirror is up, which needs the event socket
+        if (options.snapshot && !waitForFile(QString::fromStdString(DaemonProtocol::runtimeFilePath(".state")), 2000)) {
+            fprintf(stderr, "hypr-grid-bench: daemon publishes no state snapshot, measuring without\n");
+        }
+    }
+    
+    // Keybinding launches are spawns too
+    const int launchSpawns = options.mode == "inprocess" ? 0 : options.burst;
+    auto launchArgs = [&](const QPair<QString, QString> &position) {
+        const QString code = position.first + ":" + position.second;
+        return options.mode == "cli" ? QStringList() << "-a" << code : QStringList() << code;
+    };
+    auto apply = [&](const QPair<QString, QString> &position) {
+        if (options.mode == "inprocess") {
+            return manager->applyPositionByCode(position.first, position.second);
+        }
+        return runProcess(options.mode == "cli" ? managerPath : clientPath, launchArgs(position));
+    };
+    
+    // Iteration i applies positions [i * burst, (i + 1) * burst)
+    auto applyBurst = [&](int i) {
+        if (options.burst == 1) {
+            return apply(positions[i % positions.size()]);
+        }
+        QList<QStringList> argLists;
+        for (int j = 0; j < options.burst; ++j) {
+            argLists.append(launchArgs(positions[(i * options.burst + j) % positions.size()]));
+        }
+        return runProcesses(options.mode == "cli" ? managerPath : clientPath, argLists, options.burstGapMs);
+    };
+    
+    for (int i = 0; i < options.warmup; ++i) {
+        apply(positions[i % positions.size()]);
+    }
+    
+    // Same file the launched processes and the daemon use
+    ApplyQueue queue;
+    const ApplyQueueStats queueBefore = queue.stats();
+    int finalMismatches = 0;
+    
+    std::vector<double> wallMs;
+    wallMs.reserve(options.iterations);
+    std::vector<double> firstIpcMs;
+    Counters total;
+    const long notificationsBefore = notifications.calls;
+    const long bubblesBefore = notifications.bubbles;
+    int failures = 0;
+    QElapsedTimer timer;
+    
+    for (int i = 0; i < options.iterations; ++i) {
+        Counters before;
+        readMockStats(socketPath, before);
+        long spawnsBefore = countLines(spawnLog);
+        if (options.coldMonitors) {
+            MonitorCache().invalidate();
+        }
+        
+        const long long launchUs = monotonicUs();
+        timer.start();
+        bool ok = applyBurst(i);
+        wallMs.push_back(timer.nsecsElapsed() / 1e6);
+        
+        // Let the event mirror drain what this apply caused before counting
+        QCoreApplication::processEvents();
+        
+        Counters after;
+        readMockStats(socketPath, after);
+        total.requests += after.requests - before.requests;
+        total.commands += after.commands - before.commands;
+        total.spawns += countLines(spawnLog) - spawnsBefore + launchSpawns;
+        if (options.mode != "inprocess" && after.firstRequestUs >= launchUs) {
+            firstIpcMs.push_back((after.firstRequestUs - launchUs) / 1000.0);
+        }
+        if (!ok) {
+            ++failures;
+        }
+        
+        // The last request of the burst must win: applying it once more
+        // must not move the window (unmeasured)
+        if (options.burst > 1) {
+            const QJsonArray settled = activeGeometry(socketPath);
+            apply(positions[((i + 1) * options.burst - 1) % positions.size()]);
+            if (activeGeometry(socketPath) != settled) {
+                ++finalMismatches;
+            }
+        }
+    }
+    const ApplyQueueStats queueAfter = queue.stats();
+    
+    std::cout.rdbuf(coutBuffer);
+    delete manager;
+    const long notificationCalls = notifications.calls - notificationsBefore;
+    const long notificationBubbles = notifications.bubbles - bubblesBefore;
+    if (daemon.state() != QProcess::NotRunning) {
+        daemon.terminate();
+        daemon.waitForFinished(2000);
+    }
+    mock.terminate();
+    mock.waitForFinished(2000);
+    notificationThread.quit();
+    notificationThread.wait();
+    busDaemon.terminate();
+    busDaemon.waitForFinished(2000);
+    
+    std::vector<double> sorted = wallMs;
+    std::sort(sorted.begin(), sorted.end());
+    double sum = 0;
+    for (double ms : wallMs) {
+        sum += ms;
+    }
+    
+    const double n = options.iterations;
+    QJsonObject wall;
+    wall["p50"] = percentile(sorted, 50);
+    wall["p90"] = percentile(sorted, 90);
+    wall["p99"] = percentile(sorted, 99);
+    wall["max"] = sorted.back();
+    wall["mean"] = sum / n;
+    
+    QJsonArray samples;
+    for (double ms : wallMs) {
+        samples.append(ms);
+    }
+    
+    QJsonObject result;
+    result["mode"] = options.mode;
+    result["transport"] = options.transport;
+    result["mirror"] = options.mirror;
+    result["snapshot"] = options.snapshot;
+    result["coldMonitors"] = options.coldMonitors;
+    result["latencyMs"] = options.latencyMs;
+    result["clients"] = options.clients;
+    result["positions"] = static_cast<int>(positions.size());
+    result["iterations"] = options.iterations;
+    result["failures"] = failures;
+    result["wallMs"] = wall;
+    result["ipcRequestsPerApply"] = total.requests / n;
+    result["ipcCommandsPerApply"] = total.commands / n;
+    result["spawnsPerApply"] = total.spawns / n;
+    result["notificationBus"] = !busAddress.isEmpty();
+    result["notificationsPerApply"] = notificationCalls / n;
+    result["notificationBubbles"] = static_cast<double>(notificationBubbles);
+    result["burst"] = options.burst;
+    if (options.mode != "inprocess") {
+        QJsonObject queueStats;
+        queueStats["applied"] = static_cast<double>(queueAfter.applied - queueBefore.applied);
+        queueStats["dropped"] = static_cast<double>(queueAfter.dropped - queueBefore.dropped);
+        queueStats["cancelled"] = static_cast<double>(queueAfter.cancelled - queueBefore.cancelled);
+        queueStats["failed"] = static_cast<double>(queueAfter.failed - queueBefore.failed);
+        queueStats["maxDepth"] = queueAfter.maxDepth;
+        queueStats["lastSettleMs"] = queueAfter.lastSettleUs < 0 ? -1.0 : queueAfter.lastSettleUs / 1000.0;
+        queueStats["finalMismatches"] = finalMismatches;
+        result["applyQueue"] = queueStats;
+    }
+    if (!firstIpcMs.empty()) {
+        std::sort(firstIpcMs.begin(), firstIpcMs.end());
+        QJsonObject firstIpc;
+        firstIpc["p50"] = percentile(firstIpcMs, 50);
+        firstIpc["p90"] = percentile(firstIpcMs, 90);
+        firstIpc["max"] = firstIpcMs.back();
+        result["startupToFirstIpcMs"] = firstIpc;
+    }
+    result["samplesMs"] = samples;
+    
+    const QByteArray json = QJsonDocument(result).toJson(QJsonDocument::Indented);
+    if (options.output.isEmpty()) {
+        fwrite(json.constData(), 1, json.size(), stdout);
+    } else {
+        QFile file(options.output);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size()) {
+            fprintf(stderr, "hypr-grid-bench: cannot write %s\n", qPrintable(options.output));
+            return 1;
+        }
+    }
+    
+    fprintf(stderr, "%s/%s: p50 %.2f ms  p90 %.2f ms  p99 %.2f ms  max %.2f ms  "
+                    "%.1f requests, %.1f spawns per apply, %d failures\n",
+            qPrintable(options.mode), qPrintable(options.transport),
+            wall["p50"].toDouble(), wall["p90"].toDouble(), wall["p99"].toDouble(), wall["max"].toDouble(),
+            total.requests / n, total.spawns / n, failures);
+    if (!firstIpcMs.empty()) {
+        fprintf(stderr, "startup to first IPC: p50 %.2f ms  p90 %.2f ms  max %.2f ms\n",
+                percentile(firstIpcMs, 50), percentile(firstIpcMs, 90), firstIpcMs.back());
+    }
+    if (options.burst > 1) {
+        fprintf(stderr, "burst %d: %llu dropped, %llu cancelled, max depth %d, %d final mismatches\n",
+                options.burst, static_cast<unsigned long long>(queueAfter.dropped - queueBefore.dropped),
+                static_cast<unsigned long long>(queueAfter.cancelled - queueBefore.cancelled),
+                queueAfter.maxDepth, finalMismatches);
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+#include "applybench.moc"
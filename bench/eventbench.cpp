@@ -0,0 +1,827 @@
+// hypr-grid-eventbench: records Hyprland's event stream (.socket2.sock) and
+// replays it into HyprlandState, the mirror the daemon keeps, to show
+// whether the event-driven paths keep up with a storm of events.
+//
+// Usage:
+//   hypr-grid-eventbench record FILE [--seconds N]
+//   hypr-grid-eventbench generate FILE [--windows N] [--flicks N] [--titles N]
+//   hypr-grid-eventbench replay FILE [--speed X] [--output FILE] [--verbose]
+//
+// record saves the live event stream with the time of every line, plus the
+// monitors, workspaces, clients and active window before and after, until
+// interrupted or for N seconds. generate writes a synthetic storm in the
+// same format: windows opening at login, workspace flicking across two
+// monitors and terminal title updates, with moves, floating toggles and
+// closes mixed in.
+//
+// replay serves the recording from stand-in sockets: the request socket
+// answers with the state from before, the event socket sends the lines at
+// X times their recorded pace (default 1, 0 sends as fast as the mirror
+// reads). It reports events processed per second, the backlog of sent but
+// unprocessed events, how long each event took to reach the model
+// (staleness), resyncs, resident memory growth, and whether the model
+// ended up matching the state recorded afterwards.
+
+#include "hyprlandstate.h"
+#include "hyprlandipc.h"
+#include "hyprlandjson.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QTimer>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+const char FileHeader[] = "hypr-grid-events 1";
+const char *const SnapshotCommands[] = {"monitors", "workspaces", "clients", "activewindow"};
+
+struct RecordedEvent {
+    qint64 us;          // Since the recording started
+    QByteArray line;    // Without the newline
+};
+
+struct Recording {
+    QHash<QByteArray, QByteArray> before;   // Replies by command
+    QHash<QByteArray, QByteArray> after;
+    std::vector<RecordedEvent> events;
+};
+
+volatile sig_atomic_t g_stop = 0;
+bool g_verbose = false;
+
+void onStopSignal(int)
+{
+    g_stop = 1;
+}
+
+void messageHandler(QtMsgType type, const QMessageLogContext &, const QString &message)
+{
+    if (g_verbose || type >= QtWarningMsg) {
+        fprintf(stderr, "%s\n", qPrintable(message));
+    }
+}
+
+int usage(const char *program)
+{
+    fprintf(stderr, "Usage: %s record FILE [--seconds N]\n"
+                    "       %s generate FILE [--windows N] [--flicks N] [--titles N]\n"
+                    "       %s replay FILE [--speed X] [--output FILE] [--verbose]\n",
+            program, program, program);
+    return 2;
+}
+
+qint64 nowNs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<qint64>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+std::string_view view(const QByteArray &data)
+{
+    return std::string_view(data.constData(), static_cast<size_t>(data.size()));
+}
+
+// Recording file: a header line, then "reply PHASE COMMAND LENGTH" lines
+// each followed by that many bytes and a newline, then "event US LINE"
+
+bool writeRecording(const QString &path, const Recording &recording)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    
+    QByteArray out = QByteArray(FileHeader) + "\n";
+    for (const char *phase : {"before", "after"}) {
+        const QHash<QByteArray, QByteArray> &replies = std::strcmp(phase, "before") == 0
+            ? recording.before : recording.after;
+        for (const char *command : SnapshotCommands) {
+            const QByteArray reply = replies.value(command);
+            out += "reply " + QByteArray(phase) + " " + command + " " + QByteArray::number(reply.size()) + "\n";
+            out += reply + "\n";
+        }
+    }
+    for (const RecordedEvent &event : recording.events) {
+        out += "event " + QByteArray::number(event.us) + " " + event.line + "\n";
+    }
+    return file.write(out) == out.size();
+}
+
+bool readRecording(const QString &path, Recording &recording)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QByteArray data = file.readAll();
+    
+    qsizetype offset = 0;
+    auto nextLine = [&](QByteArray &line) {
+        qsizetype newline = data.indexOf('\n', offset);
+        if (newline < 0) {
+            return false;
+        }
+        line = data.mid(offset, newline - offset);
+        offset = newline + 1;
+        return true;
+    };
+    
+    QByteArray line;
+    if (!nextLine(line) || line != FileHeader) {
+        return false;
+    }
+    while (nextLine(line)) {
+        if (line.startsWith("reply ")) {
+            const QList<QByteArray> parts = line.split(' ');
+            const qsizetype length = parts.size() == 4 ? parts[3].toLongLong() : -1;
+            if (length < 0 || offset + length > data.size()) {
+                return false;
+            }
+            (parts[1] == "before" ? recording.before : recording.after).insert(parts[2], data.mid(offset, length));
+            offset += length + 1;
+        } else if (line.startsWith("event ")) {
+            const qsizetype space = line.indexOf(' ', 6);
+            if (space < 0) {
+                return false;
+            }
+            recording.events.push_back({line.mid(6, space - 6).toLongLong(), line.mid(space + 1)});
+        } else if (!line.isEmpty()) {
+            return false;
+        }
+    }
+    
+    for (const char *command : SnapshotCommands) {
+        if (!recording.before.contains(command)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool takeSnapshot(const HyprlandIPC &ipc, QHash<QByteArray, QByteArray> &replies)
+{
+    QStringList commands;
+    for (const char *command : SnapshotCommands) {
+        commands << command;
+    }
+    const QList<IpcReply> results = ipc.batch(commands, IpcFormat::Json);
+    for (int i = 0; i < results.size(); ++i) {
+        if (!results[i].ok()) {
+            return false;
+        }
+        replies.insert(SnapshotCommands[i], results[i].data);
+    }
+    return true;
+}
+
+int record(const QString &path, int seconds)
+{
+    HyprlandIPC ipc;
+    const int fd = HyprlandIPC::connectSocket(HyprlandIPC::instanceSocketPath(".socket2.sock"));
+    if (!ipc.isAvailable() || fd < 0) {
+        fprintf(stderr, "hypr-grid-eventbench: Hyprland is not running\n");
+        return 1;
+    }
+    
+    // Subscribed first, so nothing between the snapshot and the stream is lost
+    Recording recording;
+    if (!takeSnapshot(ipc, recording.before)) {
+        fprintf(stderr, "hypr-grid-eventbench: cannot read the state from Hyprland\n");
+        return 1;
+    }
+    
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = onStopSignal;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    fprintf(stderr, "Recording events%s, interrupt to stop\n",
+            seconds > 0 ? qPrintable(QString(" for %1 s").arg(seconds)) : "");
+    
+    const qint64 startNs = nowNs();
+    QByteArray buffer;
+    while (!g_stop && (seconds <= 0 || nowNs() - startNs < static_cast<qint64>(seconds) * 1000000000)) {
+        pollfd pfd = {fd, POLLIN, 0};
+        if (poll(&pfd, 1, 100) <= 0) {
+            continue;
+        }
+        char chunk[8192];
+        const ssize_t n = read(fd, chunk, sizeof(chunk));
+        if (n <= 0) {
+            break;
+        }
+        
+        const qint64 us = (nowNs() - startNs) / 1000;
+        buffer.append(chunk, n);
+        qsizetype newline;
+        while ((newline = buffer.indexOf('\n')) >= 0) {
+            recording.events.push_back({us, buffer.left(newline)});
+            buffer.remove(0, newline + 1);
+        }
+    }
+    close(fd);
+    
+    if (!takeSnapshot(ipc, recording.after)) {
+        fprintf(stderr, "hypr-grid-eventbench: cannot read the final state, replays will not be checked\n");
+    }
+    if (!writeRecording(path, recording)) {
+        fprintf(stderr, "hypr-grid-eventbench: cannot write %s\n", qPrintable(path));
+        return 1;
+    }
+    fprintf(stderr, "%zu events in %.1f s written to %s\n", recording.events.size(),
+            (nowNs() - startNs) / 1e9, qPrintable(path));
+    return 0;
+}
+
+// Synthetic storm
+
+struct SyntheticWindow {
+    uint64_t address = 0;
+    int workspace = 1;
+    bool floating = false;
+    bool open = true;
+    QString windowClass;
+    QString title;
+};
+
+struct SyntheticSession {
+    // Workspaces 1-5 are on DP-1, 6-10 on HDMI-A-1
+    int activeWorkspace[2] = {1, 6};
+    int focusedMonitor = 0;
+    uint64_t activeWindow = 0;
+    std::vector<SyntheticWindow> windows;
+    
+    static const char *monitorName(int monitor) { return monitor == 0 ? "DP-1" : "HDMI-A-1"; }
+    
+    QJsonObject windowJson(const SyntheticWindow &window) const
+    {
+        QJsonObject json;
+        json["address"] = QString::fromStdString(HyprlandJson::formatAddress(window.address));
+        json["mapped"] = true;
+        json["at"] = QJsonArray{0, 0};
+        json["size"] = QJsonArray{800, 600};
+        json["workspace"] = QJsonObject{{"id", window.workspace}, {"name", QString::number(window.workspace)}};
+        json["floating"] = window.floating;
+        json["class"] = window.windowClass;
+        json["title"] = window.title;
+        return json;
+    }
+    
+    QHash<QByteArray, QByteArray> replies() const
+    {
+        QJsonArray monitors;
+        for (int monitor = 0; monitor < 2; ++monitor) {
+            const int workspace = activeWorkspace[monitor];
+            monitors.append(QJsonObject{
+                {"id", monitor}, {"name", monitorName(monitor)},
+                {"width", monitor == 0 ? 2560 : 1920}, {"height", monitor == 0 ? 1440 : 1080},
+                {"x", monitor == 0 ? 0 : 2560}, {"y", 0}, {"scale", 1.0},
+                {"reserved", QJsonArray{0, monitor == 0 ? 40 : 0, 0, 0}},
+                {"activeWorkspace", QJsonObject{{"id", workspace}, {"name", QString::number(workspace)}}},
+                {"focused", monitor == focusedMonitor}});
+        }
+        
+        QJsonArray workspaces;
+        for (int id = 1; id <= 10; ++id) {
+            const int count = static_cast<int>(std::count_if(windows.begin(), windows.end(),
+                [id](const SyntheticWindow &window) { return window.open && window.workspace == id; }));
+            workspaces.append(QJsonObject{{"id", id}, {"name", QString::number(id)},
+                                          {"monitor", monitorName(id <= 5 ? 0 : 1)}, {"windows", count}});
+        }
+        
+        QJsonArray clients;
+        QJsonObject active;
+        for (const SyntheticWindow &window : windows) {
+            if (window.open) {
+                clients.append(windowJson(window));
+                if (window.address == activeWindow) {
+                    active = windowJson(window);
+                }
+            }
+        }
+        
+        QHash<QByteArray, QByteArray> replies;
+        replies.insert("monitors", QJsonDocument(monitors).toJson(QJsonDocument::Compact));
+        replies.insert("workspaces", QJsonDocument(workspaces).toJson(QJsonDocument::Compact));
+        replies.insert("clients", QJsonDocument(clients).toJson(QJsonDocument::Compact));
+        replies.insert("activewindow", QJsonDocument(active).toJson(QJsonDocument::Compact));
+        return replies;
+    }
+    
+    uint64_t firstWindowOn(int workspace) const
+    {
+        for (const SyntheticWindow &window : windows) {
+            if (window.open && window.workspace == workspace) {
+                return window.address;
+            }
+        }
+        return 0;
+    }
+};
+
+QByteArray bareHex(uint64_t address)
+{
+    return QByteArray::number(static_cast<qulonglong>(address), 16);
+}
+
+Recording generateStorm(int windowCount, int flicks, int titles)
+{
+    static const char *const classes[] = {"kitty", "firefox", "code", "org.gnome.Nautilus", "discord", "Spotify"};
+    Recording recording;
+    SyntheticSession session;
+    recording.before = session.replies();
+    
+    // Deterministic, so two runs replay the same storm
+    uint32_t seed = 1;
+    auto random = [&seed](int n) {
+        seed = seed * 1103515245u + 12345u;
+        return static_cast<int>((seed >> 16) % static_cast<uint32_t>(n));
+    };
+    auto add = [&recording](qint64 us, const QByteArray &line) { recording.events.push_back({us, line}); };
+    
+    // Login: every window opens, takes focus and sets its title within 2 s
+    for (int i = 0; i < windowCount; ++i) {
+        const qint64 us = static_cast<qint64>(i) * 2000000 / qMax(1, windowCount);
+        SyntheticWindow window;
+        window.address = 0x5a4f3e200000 + static_cast<uint64_t>(i) * 0x1f40;
+        window.workspace = 1 + i % 10;
+        window.windowClass = classes[i % 6];
+        window.title = QString("%1 %2").arg(window.windowClass).arg(i);
+        session.windows.push_back(window);
+        
+        const QByteArray hex = bareHex(window.address);
+        add(us, "openwindow>>" + hex + "," + QByteArray::number(window.workspace) + "," +
+                window.windowClass.toUtf8() + "," + window.windowClass.toUtf8());
+        add(us, "activewindowv2>>" + hex);
+        add(us, "windowtitlev2>>" + hex + "," + window.title.toUtf8());
+        session.activeWindow = window.address;
+    }
+    
+    // Flicking through workspaces, switching monitors every tenth time
+    for (int i = 0; i < flicks; ++i) {
+        const qint64 us = 2000000 + static_cast<qint64>(i) * 5000000 / qMax(1, flicks);
+        int &monitor = session.focusedMonitor;
+        if (i % 10 == 9) {
+            monitor = 1 - monitor;
+            add(us, "focusedmonv2>>" + QByteArray(SyntheticSession::monitorName(monitor)) + "," +
+                    QByteArray::number(session.activeWorkspace[monitor]));
+        }
+        const int workspace = monitor * 5 + 1 + random(5);
+        session.activeWorkspace[monitor] = workspace;
+        add(us, "workspacev2>>" + QByteArray::number(workspace) + "," + QByteArray::number(workspace));
+        
+        session.activeWindow = session.firstWindowOn(workspace);
+        add(us, "activewindowv2>>" + (session.activeWindow ? bareHex(session.activeWindow) : QByteArray()));
+    }
+    
+    // Terminal titles, with windows moved, floated and closed in between
+    for (int i = 0; i < titles && !session.windows.empty(); ++i) {
+        const qint64 us = 7000000 + static_cast<qint64>(i) * 5000000 / qMax(1, titles);
+        SyntheticWindow &window = session.windows[static_cast<size_t>(random(static_cast<int>(session.windows.size())))];
+        if (!window.open) {
+            continue;
+        }
+        
+        const QByteArray hex = bareHex(window.address);
+        if (i % 200 == 199) {
+            window.open = false;
+            add(us, "closewindow>>" + hex);
+            if (session.activeWindow == window.address) {
+                session.activeWindow = 0;
+            }
+        } else if (i % 70 == 69) {
+            window.floating = !window.floating;
+            add(us, "changefloatingmode>>" + hex + "," + (window.floating ? "1" : "0"));
+        } else if (i % 50 == 49) {
+            window.workspace = 1 + random(10);
+            add(us, "movewindowv2>>" + hex + "," + QByteArray::number(window.workspace) + "," +
+                    QByteArray::number(window.workspace));
+        } else {
+            window.title = QString("~/src/hyprgrid: make -j%1").arg(i);
+            add(us, "windowtitlev2>>" + hex + "," + window.title.toUtf8());
+        }
+    }
+    
+    recording.after = session.replies();
+    return recording;
+}
+
+// Stand-in sockets for the replay
+
+int listenOn(const QString &path)
+{
+    const QByteArray encoded = QFile::encodeName(path);
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (static_cast<size_t>(encoded.size()) >= sizeof(addr.sun_path)) {
+        return -1;
+    }
+    memcpy(addr.sun_path, encoded.constData(), static_cast<size_t>(encoded.size()));
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || listen(fd, 16) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    return fd;
+}
+
+bool writeAll(int fd, const char *data, size_t size)
+{
+    while (size > 0) {
+        const ssize_t n = send(fd, data, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Answers every query with the recorded state from before the events, so a
+// resync in the middle of a replay loses what was replayed so far
+void serveRequests(int listenFd, const Recording &recording, const std::atomic<bool> &stop,
+                   std::atomic<long> &served)
+{
+    while (!stop.load()) {
+        pollfd pfd = {listenFd, POLLIN, 0};
+        if (poll(&pfd, 1, 100) <= 0) {
+            continue;
+        }
+        const int fd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        
+        QByteArray request;
+        char buffer[4096];
+        pollfd client = {fd, POLLIN, 0};
+        while (poll(&client, 1, request.isEmpty() ? 1000 : 0) > 0) {
+            const ssize_t n = read(fd, buffer, sizeof(buffer));
+            if (n <= 0) {
+                break;
+            }
+            request.append(buffer, n);
+        }
+        
+        QByteArray body = request.startsWith("[[BATCH]]") ? request.mid(9) : request;
+        QByteArray reply;
+        for (QByteArray command : body.split(';')) {
+            command = command.trimmed();
+            if (command.isEmpty()) {
+                continue;
+            }
+            const qsizetype slash = command.indexOf('/');
+            command = slash >= 0 ? command.mid(slash + 1) : command;
+            if (!reply.isEmpty()) {
+                reply += "\n\n\n";
+            }
+            reply += recording.before.value(command, command.startsWith("dispatch") ? "ok" : "unknown request");
+        }
+        writeAll(fd, reply.constData(), static_cast<size_t>(reply.size()));
+        close(fd);
+        served++;
+    }
+}
+
+long residentKiB()
+{
+    QFile status("/proc/self/status");
+    if (!status.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    for (const QByteArray &line : status.readAll().split('\n')) {
+        if (line.startsWith("VmRSS:")) {
+            return line.mid(6).trimmed().split(' ').value(0).toLong();
+        }
+    }
+    return 0;
+}
+
+double percentile(const std::vector<double> &sorted, double p)
+{
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+// Where the model disagrees with the state recorded after the events
+QStringList compareWithAfter(HyprlandState &state, const Recording &recording)
+{
+    QStringList mismatches;
+    std::vector<MonitorInfo> monitors;
+    std::vector<WorkspaceInfo> workspaces;
+    WindowInfo active;
+    if (!HyprlandJson::decodeMonitors(view(recording.after.value("monitors")), monitors) ||
+        !HyprlandJson::decodeWorkspaces(view(recording.after.value("workspaces")), workspaces) ||
+        !HyprlandJson::decodeWindow(view(recording.after.value("activewindow")), active, 0)) {
+        mismatches << "no usable state after the events to compare with";
+        return mismatches;
+    }
+    
+    QHash<int, int> windows;
+    HyprlandJson::forEachClient(view(recording.after.value("clients")), [&windows](const WindowInfo &window) {
+        windows[window.workspaceId]++;
+    }, HyprlandJson::WindowGeometry);
+    for (const WorkspaceInfo &workspace : workspaces) {
+        if (state.windowCount(workspace.id) != windows.value(workspace.id)) {
+            mismatches << QString("workspace %1 has %2 windows, expected %3").arg(workspace.id)
+                .arg(state.windowCount(workspace.id)).arg(windows.value(workspace.id));
+        }
+    }
+    
+    const MonitorInfo *focused = HyprlandJson::focusedMonitor(monitors);
+    if (focused && state.activeWorkspaceId() != focused->activeWorkspaceId) {
+        mismatches << QString("active workspace %1, expected %2").arg(state.activeWorkspaceId())
+            .arg(focused->activeWorkspaceId);
+    }
+    
+    const QString expected = active.valid() ? QString::fromStdString(HyprlandJson::formatAddress(active.address)) : QString();
+    const QString actual = state.activeWindowAddress();
+    if (actual != expected) {
+        mismatches << QString("active window '%1', expected '%2'").arg(actual, expected);
+    }
+    return mismatches;
+}
+
+int replay(const QString &path, double speed, const QString &output)
+{
+    Recording recording;
+    if (!readRecording(path, recording)) {
+        fprintf(stderr, "hypr-grid-eventbench: cannot read a recording from %s\n", qPrintable(path));
+        return 1;
+    }
+    const size_t total = recording.events.size();
+    
+    // Stand-in instance in a scratch runtime directory
+    QTemporaryDir runtimeDir;
+    const QString signature = "hypr-grid-eventbench";
+    const QString instanceDir = runtimeDir.path() + "/hypr/" + signature;
+    if (!runtimeDir.isValid() || !QDir().mkpath(instanceDir)) {
+        fprintf(stderr, "hypr-grid-eventbench: cannot create a runtime directory\n");
+        return 1;
+    }
+    const int requestFd = listenOn(instanceDir + "/.socket.sock");
+    const int eventFd = listenOn(instanceDir + "/.socket2.sock");
+    if (requestFd < 0 || eventFd < 0) {
+        fprintf(stderr, "hypr-grid-eventbench: cannot listen in %s\n", qPrintable(instanceDir));
+        return 1;
+    }
+    qputenv("XDG_RUNTIME_DIR", runtimeDir.path().toLocal8Bit());
+    qputenv("HYPRLAND_INSTANCE_SIGNATURE", signature.toLocal8Bit());
+    
+    std::atomic<bool> stop{false};
+    std::atomic<long> served{0};
+    std::thread requestThread(serveRequests, requestFd, std::cref(recording), std::cref(stop), std::ref(served));
+    
+    HyprlandAPI api;
+    HyprlandState state(&api);
+    if (!state.start()) {
+        fprintf(stderr, "hypr-grid-eventbench: the state mirror did not start\n");
+        stop = true;
+        requestThread.join();
+        return 1;
+    }
+    const EventStats statsBefore = state.eventStats();
+    const long rssBefore = residentKiB();
+    
+    // Sends every line at its recorded time divided by `speed`, and notes when
+    std::unique_ptr<std::atomic<qint64>[]> sentNs(new std::atomic<qint64>[total ? total : 1]);
+    std::atomic<size_t> sent{0};
+    std::atomic<bool> sendDone{false};
+    std::atomic<qint64> sendEndNs{0};
+    const qint64 startNs = nowNs();
+    std::thread eventThread([&]() {
+        const int fd = accept4(eventFd, nullptr, nullptr, SOCK_CLOEXEC);
+        for (size_t i = 0; fd >= 0 && i < total; ++i) {
+            if (speed > 0) {
+                const qint64 dueNs = startNs + static_cast<qint64>(recording.events[i].us * 1000 / speed);
+                const qint64 waitNs = dueNs - nowNs();
+                if (waitNs > 0) {
+                    timespec ts = {static_cast<time_t>(waitNs / 1000000000), static_cast<long>(waitNs % 1000000000)};
+                    nanosleep(&ts, nullptr);
+                }
+            }
+            const QByteArray line = recording.events[i].line + "\n";
+            if (!writeAll(fd, line.constData(), static_cast<size_t>(line.size()))) {
+                break;
+            }
+            sentNs[i].store(nowNs(), std::memory_order_release);
+            sent.store(i + 1, std::memory_order_release);
+        }
+        sendEndNs = nowNs();
+        sendDone = true;
+        
+        // Closing would make the mirror reconnect and resync
+        while (!stop.load()) {
+            usleep(10000);
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+    });
+    
+    // The mirror runs on this thread's event loop; the timer bounds how long
+    // a single wait can take
+    QTimer wake;
+    wake.start(10);
+    std::vector<double> stalenessMs;
+    stalenessMs.reserve(total);
+    size_t measured = 0;
+    size_t maxBacklog = 0;
+    long rssPeak = rssBefore;
+    qint64 lastRssNs = 0;
+    qint64 lastProgressNs = nowNs();
+    qint64 lastHandledNs = startNs;
+    while (true) {
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+        const qint64 now = nowNs();
+        const size_t handled = static_cast<size_t>(state.eventStats().events - statsBefore.events);
+        const size_t sentCount = sent.load(std::memory_order_acquire);
+        
+        // Lines are handled in order, so the newly handled ones are next
+        for (; measured < handled && measured < sentCount; ++measured) {
+            stalenessMs.push_back((now - sentNs[measured].load(std::memory_order_acquire)) / 1e6);
+            lastProgressNs = lastHandledNs = now;
+        }
+        maxBacklog = std::max(maxBacklog, sentCount - std::min(handled, sentCount));
+        if (now - lastRssNs > 50000000) {
+            rssPeak = std::max(rssPeak, residentKiB());
+            lastRssNs = now;
+        }
+        
+        // Lines dropped by a resync never arrive; stop once nothing moves
+        if (sendDone && (measured >= total || now - lastProgressNs > 2000000000)) {
+            break;
+        }
+    }
+    
+    // Let a pending resync run before comparing
+    QElapsedTimer settle;
+    settle.start();
+    while (settle.elapsed() < 200) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 20);
+    }
+    const long rssAfter = residentKiB();
+    const EventStats statsAfter = state.eventStats();
+    const QStringList mismatches = recording.after.isEmpty()
+        ? QStringList() : compareWithAfter(state, recording);
+    
+    stop = true;
+    eventThread.join();
+    requestThread.join();
+    close(requestFd);
+    close(eventFd);
+    
+    std::vector<double> sorted = stalenessMs;
+    std::sort(sorted.begin(), sorted.end());
+    const double sendSeconds = (sendEndNs - startNs) / 1e9;
+    const double processSeconds = (lastHandledNs - startNs) / 1e9;
+    
+    QJsonObject staleness;
+    staleness["p50"] = percentile(sorted, 50);
+    staleness["p90"] = percentile(sorted, 90);
+    staleness["p99"] = percentile(sorted, 99);
+    staleness["max"] = sorted.empty() ? 0.0 : sorted.back();
+    
+    QJsonObject result;
+    result["recording"] = path;
+    result["speed"] = speed;
+    result["events"] = static_cast<double>(total);
+    result["processed"] = static_cast<double>(measured);
+    result["dropped"] = static_cast<double>(total - measured);
+    result["sendSeconds"] = sendSeconds;
+    result["offeredPerSecond"] = sendSeconds > 0 ? total / sendSeconds : 0.0;
+    result["processedPerSecond"] = processSeconds > 0 ? measured / processSeconds : 0.0;
+    result["maxBacklogEvents"] = static_cast<double>(maxBacklog);
+    result["maxBufferedBytes"] = static_cast<double>(statsAfter.maxBuffered);
+    result["maxQueuedRecords"] = static_cast<double>(statsAfter.maxQueued);
+    result["coalesced"] = static_cast<double>(statsAfter.coalesced);
+    result["overflows"] = static_cast<double>(statsAfter.overflows);
+    result["resyncs"] = static_cast<double>(statsAfter.resyncs - statsBefore.resyncs);
+    result["requestsServed"] = static_cast<double>(served.load());
+    result["stalenessMs"] = staleness;
+    result["rssBeforeKiB"] = static_cast<double>(rssBefore);
+    result["rssPeakKiB"] = static_cast<double>(rssPeak);
+    result["rssAfterKiB"] = static_cast<double>(rssAfter);
+    result["checked"] = !recording.after.isEmpty();
+    result["mismatches"] = QJsonArray::fromStringList(mismatches);
+    
+    const QByteArray json = QJsonDocument(result).toJson(QJsonDocument::Indented);
+    if (output.isEmpty()) {
+        fwrite(json.constData(), 1, json.size(), stdout);
+    } else {
+        QFile file(output);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size()) {
+            fprintf(stderr, "hypr-grid-eventbench: cannot write %s\n", qPrintable(output));
+            return 1;
+        }
+    }
+    
+    fprintf(stderr, "%zu events at %gx: %.0f/s offered, %.0f/s processed, staleness p50 %.2f ms p99 %.2f ms "
+                    "max %.2f ms, backlog %zu, %zu dropped, %d resyncs, RSS +%ld KiB (peak +%ld), %d mismatches\n",
+            total, speed, result["offeredPerSecond"].toDouble(), result["processedPerSecond"].toDouble(),
+            staleness["p50"].toDouble(), staleness["p99"].toDouble(), staleness["max"].toDouble(),
+            maxBacklog, total - measured, result["resyncs"].toInt(), rssAfter - rssBefore, rssPeak - rssBefore,
+            static_cast<int>(mismatches.size()));
+    for (const QString &mismatch : mismatches) {
+        fprintf(stderr, "  %s\n", qPrintable(mismatch));
+    }
+    return measured == total && mismatches.isEmpty() ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    if (args.size() < 3) {
+        return usage(argv[0]);
+    }
+    const QString mode = args[1];
+    const QString path = args[2];
+    
+    int seconds = 0;
+    int windows = 300;
+    int flicks = 500;
+    int titles = 5000;
+    double speed = 1.0;
+    QString output;
+    for (int i = 3; i < args.size(); ++i) {
+        const QString &arg = args[i];
+        const bool hasValue = i + 1 < args.size();
+        if (arg == "--verbose") {
+            g_verbose = true;
+        } else if (!hasValue) {
+            return usage(argv[0]);
+        } else if (arg == "--seconds") {
+            seconds = args[++i].toInt();
+        } else if (arg == "--windows") {
+            windows = args[++i].toInt();
+        } else if (arg == "--flicks") {
+            flicks = args[++i].toInt();
+        } else if (arg == "--titles") {
+            titles = args[++i].toInt();
+        } else if (arg == "--speed") {
+            speed = args[++i].toDouble();
+        } else if (arg == "--output") {
+            output = args[++i];
+        } else {
+            return usage(argv[0]);
+        }
+    }
+    qInstallMessageHandler(messageHandler);
+    
+    if (mode == "record") {
+        return record(path, seconds);
+    }
+    if (mode == "generate") {
+        const Recording recording = generateStorm(windows, flicks, titles);
+        if (!writeRecording(path, recording)) {
+            fprintf(stderr, "hypr-grid-eventbench: cannot write %s\n", qPrintable(path));
+            return 1;
+        }
+        fprintf(stderr, "%zu events written to %s\n", recording.events.size(), qPrintable(path));
+        return 0;
+    }
+    if (mode == "replay" && speed >= 0) {
+        return replay(path, speed, output);
+    }
+    return usage(argv[0]);
+}
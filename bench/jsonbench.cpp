@@ -0,0 +1,195 @@
+// hypr-grid-jsonbench: compares QJsonDocument against the typed decoders in
+// hyprlandjson.h on captured Hyprland replies (bench/data). The clients
+// reply is also replicated to show how both scale with many windows.
+//
+// Usage:
+//   hypr-grid-jsonbench [data-dir] [iterations]
+
+#include "hyprlandjson.h"
+
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include <QVariantMap>
+
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+namespace {
+
+// Accumulates decoded values so the compiler cannot drop the work
+long long g_sink = 0;
+
+QByteArray readFixture(const QString &dir, const QString &name)
+{
+    QFile file(dir + "/" + name);
+    if (!file.open(QIODevice::ReadOnly)) {
+        fprintf(stderr, "hypr-grid-jsonbench: cannot read %s\n", qPrintable(file.fileName()));
+        exit(1);
+    }
+    return file.readAll();
+}
+
+// Repeat the elements of a JSON array until it holds at least count entries
+QByteArray replicateArray(const QByteArray &array, int count)
+{
+    QByteArray body = array.trimmed();
+    body = body.mid(1, body.size() - 2);
+    int perCopy = static_cast<int>(QJsonDocument::fromJson(array).array().size());
+    
+    QByteArray result = "[";
+    for (int copies = 0; copies * perCopy < count; ++copies) {
+        if (copies > 0) {
+            result += ",";
+        }
+        result += body;
+    }
+    result += "]";
+    return result;
+}
+
+std::string_view view(const QByteArray &data)
+{
+    return std::string_view(data.constData(), static_cast<size_t>(data.size()));
+}
+
+double nsPerOp(int iterations, const std::function<void()> &body)
+{
+    // Warm up caches and the allocator before timing
+    for (int i = 0; i < iterations / 10 + 1; ++i) {
+        body();
+    }
+    
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        body();
+    }
+    return static_cast<double>(timer.nsecsElapsed()) / iterations;
+}
+
+void report(const char *name, int iterations, const std::function<void()> &document,
+            const std::function<void()> &typed)
+{
+    double documentNs = nsPerOp(iterations, document);
+    double typedNs = nsPerOp(iterations, typed);
+    printf("%-22s %12.0f %12.0f %8.1fx\n", name, documentNs, typedNs, documentNs / typedNs);
+}
+
+// The fields the placement path reads, extracted the way the old code did
+void documentWindow(const QByteArray &reply)
+{
+    QJsonObject window = QJsonDocument::fromJson(reply).object();
+    g_sink += window["address"].toString().size();
+    g_sink += window["floating"].toBool();
+    g_sink += window["workspace"].toObject()["id"].toInt();
+}
+
+void documentMonitors(const QByteArray &reply)
+{
+    const QJsonArray monitors = QJsonDocument::fromJson(reply).array();
+    for (const QJsonValue &val : monitors) {
+        QJsonObject monitor = val.toObject();
+        if (monitor["focused"].toBool()) {
+            QVariantMap data = monitor.toVariantMap();
+            g_sink += data["width"].toInt() + data["height"].toInt();
+            g_sink += static_cast<long long>(data["scale"].toDouble());
+        }
+    }
+}
+
+void documentClients(const QByteArray &reply)
+{
+    const QJsonArray clients = QJsonDocument::fromJson(reply).array();
+    for (const QJsonValue &val : clients) {
+        QJsonObject client = val.toObject();
+        g_sink += client["address"].toString().size();
+        g_sink += client["workspace"].toObject()["id"].toInt();
+        g_sink += client["floating"].toBool();
+        g_sink += client["class"].toString().size() + client["title"].toString().size();
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QString dir = argc > 1 ? QString::fromLocal8Bit(argv[1]) : QStringLiteral(HYPR_GRID_BENCH_DATA);
+    int iterations = argc > 2 ? atoi(argv[2]) : 20000;
+    if (iterations <= 0) {
+        fprintf(stderr, "Usage: %s [data-dir] [iterations]\n", argv[0]);
+        return 2;
+    }
+    
+    const QByteArray activeWindow = readFixture(dir, "activewindow.json");
+    const QByteArray monitors = readFixture(dir, "monitors.json");
+    const QByteArray activeWorkspace = readFixture(dir, "activeworkspace.json");
+    const QByteArray clients = readFixture(dir, "clients.json");
+    
+    printf("%-22s %12s %12s %9s\n", "reply", "qjson ns", "typed ns", "speedup");
+    
+    report("activewindow", iterations,
+           [&]() { documentWindow(activeWindow); },
+           [&]() {
+               WindowInfo window;
+               HyprlandJson::decodeWindow(view(activeWindow), window, HyprlandJson::WindowGeometry);
+               g_sink += static_cast<long long>(window.address) + window.floating + window.workspaceId;
+           });
+    
+    report("monitors", iterations,
+           [&]() { documentMonitors(monitors); },
+           [&]() {
+               std::vector<MonitorInfo> decoded;
+               HyprlandJson::decodeMonitors(view(monitors), decoded);
+               const MonitorInfo *monitor = HyprlandJson::focusedMonitor(decoded);
+               g_sink += monitor->width + monitor->height + static_cast<long long>(monitor->scale);
+           });
+    
+    report("activeworkspace", iterations,
+           [&]() { g_sink += QJsonDocument::fromJson(activeWorkspace).object()["windows"].toInt(); },
+           [&]() {
+               WorkspaceInfo workspace;
+               HyprlandJson::decodeWorkspace(view(activeWorkspace), workspace);
+               g_sink += workspace.windows;
+           });
+    
+    for (int count : {7, 70, 700}) {
+        const QByteArray reply = replicateArray(clients, count);
+        const QByteArray name = QByteArray("clients x") + QByteArray::number(count);
+        int scaled = count > 7 ? iterations * 7 / count + 1 : iterations;
+        
+        report(name.constData(), scaled,
+               [&]() { documentClients(reply); },
+               [&]() {
+                   HyprlandJson::forEachClient(view(reply), [](const WindowInfo &window) {
+                       g_sink += static_cast<long long>(window.address) + window.workspaceId + window.floating;
+                       g_sink += static_cast<long long>(window.windowClass.size() + window.title.size());
+                   }, HyprlandJson::WindowStrings);
+               });
+    }
+    
+    // Old placement query parsed all four replies; the new one skips clients
+    const QByteArray placementClients = replicateArray(clients, 70);
+    report("placement (70 win)", iterations / 10 + 1,
+           [&]() {
+               documentWindow(activeWindow);
+               documentMonitors(monitors);
+               g_sink += QJsonDocument::fromJson(activeWorkspace).object()["id"].toInt();
+               documentClients(placementClients);
+           },
+           [&]() {
+               WindowInfo window;
+               std::vector<MonitorInfo> decoded;
+               WorkspaceInfo workspace;
+               HyprlandJson::decodeWindow(view(activeWindow), window, HyprlandJson::WindowGeometry);
+               HyprlandJson::decodeMonitors(view(monitors), decoded);
+               HyprlandJson::decodeWorkspace(view(activeWorkspace), workspace);
+               g_sink += static_cast<long long>(window.address) + decoded.size() + workspace.windows;
+           });
+    
+    // Keep the sink observable
+    return g_sink == 42 ? 1 : 0;
+}
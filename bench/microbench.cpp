@@ -0,0 +1,327 @@
+// hypr-grid-microbench: time and heap allocations per call of the code that
+// runs on every apply or configuration change, without Hyprland: the grid
+// to pixel conversion, preset lookups against configurations with thousands
+// of positions, loading, saving and serializing the configuration, and
+// decoding captured clients replies (bench/data) with 10 to 1000 windows.
+//
+// Usage:
+//   hypr-grid-microbench [data-dir] [iterations]
+//
+// Allocations are counted by wrapping malloc (glibc) or operator new
+// (elsewhere, which misses Qt's containers and strings). A lookup that
+// copies a QMap it only reads, or detaches one through operator[], shows up
+// as allocations that grow with the size of the configuration.
+
+#include "gridmanager.h"
+#include "config.h"
+#include "hyprlandjson.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+
+namespace {
+
+std::atomic<unsigned long long> g_allocations{0};
+std::atomic<unsigned long long> g_allocatedBytes{0};
+
+inline void countAllocation(size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+} // namespace
+
+#ifdef __GLIBC__
+// Every allocation, operator new and Qt's own included, ends up here
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+void __libc_free(void *pointer);
+
+void *malloc(size_t size)
+{
+    countAllocation(size);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    countAllocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size)
+{
+    countAllocation(size);
+    return __libc_realloc(pointer, size);
+}
+
+void free(void *pointer)
+{
+    __libc_free(pointer);
+}
+}
+#else
+void *operator new(size_t size)
+{
+    countAllocation(size);
+    if (void *pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+#endif
+
+namespace {
+
+// Accumulates results so the compiler cannot drop the work
+long long g_sink = 0;
+
+struct Measurement {
+    double ns;
+    double allocations;
+    double bytes;
+};
+
+Measurement measure(int iterations, const std::function<void()> &body)
+{
+    // Warm up caches and the allocator before measuring
+    for (int i = 0; i < iterations / 10 + 1; ++i) {
+        body();
+    }
+    
+    const unsigned long long allocationsBefore = g_allocations.load(std::memory_order_relaxed);
+    const unsigned long long bytesBefore = g_allocatedBytes.load(std::memory_order_relaxed);
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        body();
+    }
+    const qint64 elapsedNs = timer.nsecsElapsed();
+    
+    Measurement result;
+    result.ns = static_cast<double>(elapsedNs) / iterations;
+    result.allocations = static_cast<double>(g_allocations.load(std::memory_order_relaxed) - allocationsBefore) / iterations;
+    result.bytes = static_cast<double>(g_allocatedBytes.load(std::memory_order_relaxed) - bytesBefore) / iterations;
+    return result;
+}
+
+void report(const QByteArray &name, int iterations, const std::function<void()> &body)
+{
+    const Measurement result = measure(qMax(1, iterations), body);
+    printf("%-40s %12.0f %10.1f %12.0f\n", name.constData(), result.ns, result.allocations, result.bytes);
+}
+
+QByteArray readFixture(const QString &dir, const QString &name)
+{
+    QFile file(dir + "/" + name);
+    if (!file.open(QIODevice::ReadOnly)) {
+        fprintf(stderr, "hypr-grid-microbench: cannot read %s\n", qPrintable(file.fileName()));
+        exit(1);
+    }
+    return file.readAll();
+}
+
+// Repeat the elements of a JSON array until it holds exactly count entries
+QByteArray replicateArray(const QByteArray &array, int count)
+{
+    const QJsonArray elements = QJsonDocument::fromJson(array).array();
+    QJsonArray result;
+    while (!elements.isEmpty() && result.size() < count) {
+        result.append(elements.at(result.size() % elements.size()));
+    }
+    return QJsonDocument(result).toJson(QJsonDocument::Compact);
+}
+
+std::string_view view(const QByteArray &data)
+{
+    return std::string_view(data.constData(), static_cast<size_t>(data.size()));
+}
+
+// `total` positions spread over ten presets, shaped like the defaults
+QMap<QString, QMap<QString, QVariantMap>> generatePresets(int total)
+{
+    QMap<QString, QMap<QString, QVariantMap>> presets;
+    for (int i = 0; i < total; ++i) {
+        QVariantMap position;
+        position["x"] = i % 3;
+        position["y"] = (i / 3) % 3;
+        position["width"] = 1 + i % 2;
+        position["height"] = 1 + (i / 2) % 2;
+        if (i % 5 == 0) {
+            position["centered"] = true;
+            position["scale"] = 0.65;
+        }
+        presets[QString("preset-%1").arg(i % 10)][QString("position-%1").arg(i)] = position;
+    }
+    return presets;
+}
+
+void benchGeometry(GridManager &gridManager, int iterations)
+{
+    const Screen screen{2560, 1440, 40, 0, 0, 0, 1.25};
+    GridPosition cell{1, 1, 1, 1};
+    GridPosition centered{0, 0, 3, 3, true, 0.65};
+    
+    report("gridToPixelPosition (cell)", iterations, [&]() {
+        g_sink += gridManager.gridToPixelPosition(cell, screen).width;
+    });
+    report("gridToPixelPosition (centered)", iterations, [&]() {
+        g_sink += gridManager.gridToPixelPosition(centered, screen).width;
+    });
+}
+
+void benchPresets(GridManager &gridManager, int total, int iterations)
+{
+    Config *config = gridManager.getConfig();
+    config->setPresets(generatePresets(total));
+    
+    const QString preset = "preset-3";
+    const QStringList codes = gridManager.getPositionCodesForPreset(preset);
+    const QByteArray suffix = " (" + QByteArray::number(total) + " positions)";
+    // Whole-configuration work gets fewer rounds as it grows
+    const int scaled = iterations * 10 / total + 1;
+    
+    report("getPresetNames" + suffix, scaled, [&]() {
+        g_sink += gridManager.getPresetNames().size();
+    });
+    report("getPositionCodesForPreset" + suffix, scaled, [&]() {
+        g_sink += gridManager.getPositionCodesForPreset(preset).size();
+    });
+    
+    int next = 0;
+    report("getGridPosition" + suffix, scaled, [&]() {
+        g_sink += gridManager.getGridPosition(preset, codes.at(next++ % codes.size())).width;
+    });
+    
+    // The same lookup reading through const references, for comparison
+    next = 0;
+    report("  const lookup, for comparison" + suffix, scaled, [&]() {
+        const QMap<QString, QMap<QString, QVariantMap>> presets = config->getPresets();
+        const QVariantMap position = presets.value(preset).value(codes.at(next++ % codes.size()));
+        g_sink += position.value("width").toInt();
+    });
+}
+
+void benchConfig(Config &config, int total, int iterations)
+{
+    config.setPresets(generatePresets(total));
+    const QByteArray suffix = " (" + QByteArray::number(total) + " positions)";
+    const int scaled = iterations / total + 1;
+    
+    report("Config::toJsonObject" + suffix, scaled, [&]() {
+        g_sink += config.toJsonObject().size();
+    });
+    report("Config::save" + suffix, scaled, [&]() {
+        g_sink += config.save();
+    });
+    report("Config::load" + suffix, scaled, [&]() {
+        g_sink += config.load();
+    });
+}
+
+// The fields the placement path and the state mirror read
+void documentClients(const QByteArray &reply)
+{
+    const QJsonArray clients = QJsonDocument::fromJson(reply).array();
+    for (const QJsonValue &val : clients) {
+        QJsonObject client = val.toObject();
+        g_sink += client["address"].toString().size();
+        g_sink += client["workspace"].toObject()["id"].toInt();
+        g_sink += client["floating"].toBool();
+        g_sink += client["class"].toString().size() + client["title"].toString().size();
+    }
+}
+
+void benchClients(const QByteArray &clients, int iterations)
+{
+    for (int count : {10, 100, 1000}) {
+        const QByteArray reply = replicateArray(clients, count);
+        const QByteArray suffix = " (" + QByteArray::number(count) + " windows)";
+        const int scaled = iterations * 10 / count + 1;
+        
+        report("clients, QJsonDocument" + suffix, scaled, [&]() {
+            documentClients(reply);
+        });
+        report("clients, forEachClient" + suffix, scaled, [&]() {
+            HyprlandJson::forEachClient(view(reply), [](const WindowInfo &window) {
+                g_sink += static_cast<long long>(window.address) + window.workspaceId + window.floating;
+                g_sink += static_cast<long long>(window.windowClass.size() + window.title.size());
+            });
+        });
+    }
+}
+
+void quietMessages(QtMsgType, const QMessageLogContext &, const QString &)
+{
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    
+    QString dir = argc > 1 ? QString::fromLocal8Bit(argv[1]) : QStringLiteral(HYPR_GRID_BENCH_DATA);
+    int iterations = argc > 2 ? atoi(argv[2]) : 100000;
+    if (iterations <= 0) {
+        fprintf(stderr, "Usage: %s [data-dir] [iterations]\n", argv[0]);
+        return 2;
+    }
+    const QByteArray clients = readFixture(dir, "clients.json");
+    
+    // Configuration goes to a scratch home, never the user's
+    QTemporaryDir home;
+    if (!home.isValid()) {
+        fprintf(stderr, "hypr-grid-microbench: cannot create a temporary directory\n");
+        return 1;
+    }
+    qputenv("HOME", home.path().toLocal8Bit());
+    qInstallMessageHandler(quietMessages);
+    
+    GridManager gridManager;
+    if (!gridManager.initialize()) {
+        fprintf(stderr, "hypr-grid-microbench: cannot initialize the grid manager\n");
+        return 1;
+    }
+    
+    printf("%-40s %12s %10s %12s\n", "benchmark", "ns/op", "allocs/op", "bytes/op");
+    
+    benchGeometry(gridManager, iterations);
+    for (int total : {100, 1000, 5000}) {
+        benchPresets(gridManager, total, iterations);
+    }
+    
+    Config config;
+    for (int total : {100, 1000, 5000}) {
+        benchConfig(config, total, iterations);
+    }
+    
+    benchClients(clients, iterations);
+    
+    // Keep the sink observable
+    return g_sink == 42 ? 1 : 0;
+}
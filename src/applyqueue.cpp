@@ -0,0 +1,282 @@
+#include "applyqueue.h"
+#include "daemonprotocol.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/file.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+int64_t monotonicUs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+int openFile(const std::string &path)
+{
+    return ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+}
+
+bool flockRetry(int fd, int operation)
+{
+    while (::flock(fd, operation) != 0) {
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool processAlive(pid_t pid)
+{
+    return ::kill(pid, 0) == 0 || errno == EPERM;
+}
+
+} // namespace
+
+ApplyQueue::ApplyQueue()
+    : ApplyQueue(DaemonProtocol::runtimeFilePath(".queue"))
+{
+}
+
+ApplyQueue::ApplyQueue(const std::string &path)
+    : m_stateFd(openFile(path)), m_runFd(openFile(path + ".lock")), m_running(false)
+{
+}
+
+ApplyQueue::~ApplyQueue()
+{
+    if (m_stateFd >= 0) {
+        ::close(m_stateFd);
+    }
+    if (m_runFd >= 0) {
+        ::close(m_runFd);
+    }
+}
+
+uint64_t ApplyQueue::enqueue(const std::string &target, bool *followsSameTarget)
+{
+    if (!lockState(LOCK_EX)) {
+        return 0;
+    }
+    
+    State state;
+    load(state);
+    
+    // Requests of processes that died without finishing never run
+    state.pending.erase(std::remove_if(state.pending.begin(), state.pending.end(), [](const Entry &entry) {
+        return !processAlive(entry.pid);
+    }), state.pending.end());
+    
+    if (state.pending.empty()) {
+        state.burstStartUs = monotonicUs();
+    }
+    if (followsSameTarget) {
+        *followsSameTarget = !target.empty() && std::any_of(state.pending.begin(), state.pending.end(),
+                                                            [&](const Entry &entry) { return entry.target == target; });
+    }
+    
+    const uint64_t ticket = state.next++;
+    state.pending.push_back({ticket, ::getpid(), target});
+    state.stats.enqueued++;
+    state.stats.maxDepth = std::max(state.stats.maxDepth, static_cast<int>(state.pending.size()));
+    
+    bool stored = store(state);
+    unlockState();
+    return stored ? ticket : 0;
+}
+
+bool ApplyQueue::acquire(uint64_t ticket)
+{
+    if (!m_running) {
+        if (!flockRetry(m_runFd, LOCK_EX)) {
+            return false;
+        }
+        m_running = true;
+    }
+    return !isSuperseded(ticket);
+}
+
+bool ApplyQueue::isSuperseded(uint64_t ticket)
+{
+    if (!lockState(LOCK_SH)) {
+        return false;
+    }
+    State state;
+    load(state);
+    unlockState();
+    
+    auto own = std::find_if(state.pending.begin(), state.pending.end(), [&](const Entry &entry) {
+        return entry.ticket == ticket;
+    });
+    if (own == state.pending.end() || own->target.empty()) {
+        return false;
+    }
+    return std::any_of(state.pending.begin(), state.pending.end(), [&](const Entry &entry) {
+        return entry.ticket > ticket && entry.target == own->target;
+    });
+}
+
+void ApplyQueue::finish(uint64_t ticket, Outcome outcome)
+{
+    if (lockState(LOCK_EX)) {
+        State state;
+        load(state);
+        
+        state.pending.erase(std::remove_if(state.pending.begin(), state.pending.end(), [&](const Entry &entry) {
+            return entry.ticket == ticket;
+        }), state.pending.end());
+        
+        switch (outcome) {
+        case Applied: state.stats.applied++; break;
+        case Dropped: state.stats.dropped++; break;
+        case Cancelled: state.stats.cancelled++; break;
+        case Failed: state.stats.failed++; break;
+        }
+        
+        // The burst has settled once nothing is left to run
+        if (state.pending.empty() && state.burstStartUs >= 0) {
+            state.stats.lastSettleUs = monotonicUs() - state.burstStartUs;
+            state.burstStartUs = -1;
+        }
+        
+        store(state);
+        unlockState();
+    }
+    
+    if (m_running) {
+        flockRetry(m_runFd, LOCK_UN);
+        m_running = false;
+    }
+}
+
+ApplyQueueStats ApplyQueue::stats()
+{
+    State state;
+    if (lockState(LOCK_SH)) {
+        load(state);
+        unlockState();
+    }
+    state.stats.depth = static_cast<int>(state.pending.size());
+    return state.stats;
+}
+
+std::string ApplyQueue::formatStats(const ApplyQueueStats &stats)
+{
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer),
+             "depth=%d max_depth=%d enqueued=%" PRIu64 " applied=%" PRIu64 " dropped=%" PRIu64
+             " cancelled=%" PRIu64 " failed=%" PRIu64 " settle_us=%" PRId64,
+             stats.depth, stats.maxDepth, stats.enqueued, stats.applied, stats.dropped,
+             stats.cancelled, stats.failed, stats.lastSettleUs);
+    return buffer;
+}
+
+bool ApplyQueue::lockState(int operation)
+{
+    return m_stateFd >= 0 && flockRetry(m_stateFd, operation);
+}
+
+void ApplyQueue::unlockState()
+{
+    flockRetry(m_stateFd, LOCK_UN);
+}
+
+// One "key value..." line per field, one "pending" line per request
+bool ApplyQueue::load(State &state)
+{
+    std::string data;
+    char buffer[4096];
+    off_t offset = 0;
+    ssize_t n;
+    while ((n = ::pread(m_stateFd, buffer, sizeof(buffer), offset)) > 0) {
+        data.append(buffer, static_cast<size_t>(n));
+        offset += n;
+    }
+    if (n < 0) {
+        return false;
+    }
+    
+    size_t start = 0;
+    while (start < data.size()) {
+        size_t end = data.find('\n', start);
+        if (end == std::string::npos) {
+            end = data.size();
+        }
+        const std::string line = data.substr(start, end - start);
+        start = end + 1;
+        
+        char key[16];
+        char target[64] = "";
+        unsigned long long a = 0;
+        long long b = 0;
+        int fields = sscanf(line.c_str(), "%15s %llu %lld %63s", key, &a, &b, target);
+        if (fields < 2) {
+            continue;
+        }
+        
+        if (!strcmp(key, "pending") && fields >= 3) {
+            state.pending.push_back({a, static_cast<pid_t>(b), strcmp(target, "-") ? target : ""});
+        } else if (!strcmp(key, "next")) {
+            state.next = a;
+        } else if (!strcmp(key, "enqueued")) {
+            state.stats.enqueued = a;
+        } else if (!strcmp(key, "applied")) {
+            state.stats.applied = a;
+        } else if (!strcmp(key, "dropped")) {
+            state.stats.dropped = a;
+        } else if (!strcmp(key, "cancelled")) {
+            state.stats.cancelled = a;
+        } else if (!strcmp(key, "failed")) {
+            state.stats.failed = a;
+        } else if (!strcmp(key, "maxdepth")) {
+            state.stats.maxDepth = static_cast<int>(a);
+        } else if (!strcmp(key, "settle")) {
+            // Stored shifted by one so -1 (never settled) stays unsigned
+            state.stats.lastSettleUs = static_cast<int64_t>(a) - 1;
+        } else if (!strcmp(key, "burst")) {
+            state.burstStartUs = static_cast<int64_t>(a) - 1;
+        }
+    }
+    return true;
+}
+
+bool ApplyQueue::store(const State &state)
+{
+    std::string data;
+    char line[128];
+    auto add = [&](const char *key, unsigned long long value) {
+        snprintf(line, sizeof(line), "%s %llu\n", key, value);
+        data += line;
+    };
+    
+    add("next", state.next);
+    add("enqueued", state.stats.enqueued);
+    add("applied", state.stats.applied);
+    add("dropped", state.stats.dropped);
+    add("cancelled", state.stats.cancelled);
+    add("failed", state.stats.failed);
+    add("maxdepth", static_cast<unsigned long long>(state.stats.maxDepth));
+    add("settle", static_cast<unsigned long long>(state.stats.lastSettleUs + 1));
+    add("burst", static_cast<unsigned long long>(state.burstStartUs + 1));
+    for (const Entry &entry : state.pending) {
+        snprintf(line, sizeof(line), "pending %llu %lld %s\n", static_cast<unsigned long long>(entry.ticket),
+                 static_cast<long long>(entry.pid), entry.target.empty() ? "-" : entry.target.c_str());
+        data += line;
+    }
+    
+    if (::pwrite(m_stateFd, data.data(), data.size(), 0) != static_cast<ssize_t>(data.size())) {
+        return false;
+    }
+    return ::ftruncate(m_stateFd, static_cast<off_t>(data.size())) == 0;
+}
@@ -0,0 +1,97 @@
+#ifndef APPLYQUEUE_H
+#define APPLYQUEUE_H
+
+// Last-writer-wins coordination of apply requests, shared by every
+// hypr-grid-manager process of one Hyprland instance (CLI runs and the
+// daemon alike). Applies run one at a time. A request that has not started
+// is dropped once a newer request for the same window exists, and a
+// running one is cut short at its next cancellation point, so the window
+// always ends up where the last request put it.
+//
+// The state lives in a small file in the runtime directory, guarded by
+// flock(); a second file is held locked while an apply runs. Entries of
+// processes that died are pruned. Plain C++ so the benchmark can read
+// the counters too.
+
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+struct ApplyQueueStats {
+    int depth = 0;                  // Requests waiting or running
+    int maxDepth = 0;               // Deepest the queue has been
+    uint64_t enqueued = 0;
+    uint64_t applied = 0;
+    uint64_t dropped = 0;           // Superseded before they started
+    uint64_t cancelled = 0;         // Superseded while running
+    uint64_t failed = 0;
+    int64_t lastSettleUs = -1;      // From the first request of the last burst until the queue drained
+};
+
+class ApplyQueue
+{
+public:
+    enum Outcome {
+        Applied,
+        Dropped,
+        Cancelled,
+        Failed
+    };
+    
+    // Defaults to hypr-grid-manager[-<signature>].queue in the runtime directory
+    ApplyQueue();
+    explicit ApplyQueue(const std::string &path);
+    ~ApplyQueue();
+    
+    ApplyQueue(const ApplyQueue &) = delete;
+    ApplyQueue &operator=(const ApplyQueue &) = delete;
+    
+    bool isOpen() const { return m_stateFd >= 0 && m_runFd >= 0; }
+    
+    // Register a request for a window (its address, empty if unknown) and
+    // return its ticket. Tickets grow with every request; 0 means failure.
+    // `followsSameTarget` is set when an earlier request for the same window
+    // is still waiting or running, so it may change the window first.
+    uint64_t enqueue(const std::string &target, bool *followsSameTarget = nullptr);
+    
+    // Wait until no other apply runs. False when the request was
+    // superseded meanwhile and should be dropped.
+    bool acquire(uint64_t ticket);
+    
+    // A newer request for the same window exists
+    bool isSuperseded(uint64_t ticket);
+    
+    // Remove the request, count its outcome and let the next one run
+    void finish(uint64_t ticket, Outcome outcome);
+    
+    ApplyQueueStats stats();
+    
+    // Key=value form used in daemon replies and logs
+    static std::string formatStats(const ApplyQueueStats &stats);
+    
+private:
+    struct Entry {
+        uint64_t ticket;
+        pid_t pid;
+        std::string target;
+    };
+    
+    struct State {
+        uint64_t next = 1;
+        ApplyQueueStats stats;
+        int64_t burstStartUs = -1;
+        std::vector<Entry> pending;
+    };
+    
+    bool load(State &state);
+    bool store(const State &state);
+    bool lockState(int operation);
+    void unlockState();
+    
+    int m_stateFd;
+    int m_runFd;
+    bool m_running;
+};
+
+#endif // APPLYQUEUE_H
@@ -0,0 +1,133 @@
+#include "asyncgridmanager.h"
+#include "gridmanager.h"
+
+#include <QPromise>
+#include <QJsonObject>
+#include <QDebug>
+
+#include <memory>
+
+AsyncGridManager::AsyncGridManager(GridManager &source, QObject *parent)
+    : QObject(parent), m_source(source), m_worker(nullptr), m_pendingCount(0)
+{
+    m_thread.setObjectName("hyprland-ipc");
+}
+
+AsyncGridManager::~AsyncGridManager()
+{
+    cancel();
+    m_thread.quit();
+    m_thread.wait();
+}
+
+void AsyncGridManager::start()
+{
+    if (m_worker) {
+        return;
+    }
+    
+    m_worker = new GridManager();
+    m_worker->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+    connect(m_worker, &GridManager::errorOccurred, this, &AsyncGridManager::errorOccurred);
+    
+    m_thread.start();
+    
+    // Config, HyprlandAPI and the state mirror are created on the IPC thread
+    GridManager *worker = m_worker;
+    QMetaObject::invokeMethod(m_worker, [worker]() {
+        if (!worker->initialize()) {
+            qWarning() << "Async grid manager failed to initialize";
+            return;
+        }
+        worker->enableStateMirror();
+    }, Qt::QueuedConnection);
+}
+
+QFuture<bool> AsyncGridManager::applyPositionAsync(const QString &preset, const QString &code)
+{
+    start();
+    
+    auto promise = std::make_shared<QPromise<bool>>();
+    QFuture<bool> future = promise->future();
+    promise->start();
+    
+    // Snapshot the caller's configuration so unsaved edits apply too
+    QJsonObject config = m_source.getConfig()->toJsonObject();
+    GridManager *worker = m_worker;
+    
+    operationStarted(future);
+    QMetaObject::invokeMethod(m_worker, [this, worker, promise, config, preset, code]() {
+        bool success = false;
+        if (!promise->isCanceled() && worker->getConfig()) {
+            worker->getConfig()->fromJsonObject(config);
+            worker->setCancellationCheck([promise]() { return promise->isCanceled(); });
+            success = worker->applyPositionByCode(preset, code);
+            worker->setCancellationCheck(nullptr);
+        }
+        
+        bool cancelled = promise->isCanceled();
+        promise->addResult(success && !cancelled);
+        promise->finish();
+        
+        QMetaObject::invokeMethod(this, [this, preset, code, success, cancelled]() {
+            operationDone();
+            emit applyFinished(preset, code, success && !cancelled, cancelled);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+    
+    return future;
+}
+
+QFuture<bool> AsyncGridManager::resetWindowStateAsync()
+{
+    start();
+    
+    auto promise = std::make_shared<QPromise<bool>>();
+    QFuture<bool> future = promise->future();
+    promise->start();
+    
+    GridManager *worker = m_worker;
+    
+    operationStarted(future);
+    QMetaObject::invokeMethod(m_worker, [this, worker, promise]() {
+        bool success = !promise->isCanceled() && worker->getConfig() && worker->resetWindowState();
+        promise->addResult(success);
+        promise->finish();
+        
+        QMetaObject::invokeMethod(this, [this, success]() {
+            operationDone();
+            emit resetFinished(success);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+    
+    return future;
+}
+
+void AsyncGridManager::cancel()
+{
+    for (QFuture<bool> &future : m_pending) {
+        if (!future.isFinished()) {
+            future.cancel();
+        }
+    }
+}
+
+void AsyncGridManager::operationStarted(const QFuture<bool> &future)
+{
+    // Forget operations that completed since the last call
+    m_pending.removeIf([](const QFuture<bool> &pending) { return pending.isFinished(); });
+    m_pending.append(future);
+    
+    if (m_pendingCount++ == 0) {
+        emit busyChanged(true);
+    }
+}
+
+void AsyncGridManager::operationDone()
+{
+    if (--m_pendingCount == 0) {
+        m_pending.clear();
+        emit busyChanged(false);
+    }
+}
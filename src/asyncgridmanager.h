@@ -0,0 +1,55 @@
+#ifndef ASYNCGRIDMANAGER_H
+#define ASYNCGRIDMANAGER_H
+
+#include <QObject>
+#include <QThread>
+#include <QFuture>
+#include <QList>
+#include <QString>
+
+class GridManager;
+
+// Runs GridManager operations on a dedicated IPC thread so callers such as
+// the UI never block on Hyprland. Every operation returns a QFuture and
+// reports completion through signals; cancelling the future (or calling
+// cancel()) stops the operation at its next safe step.
+//
+// The worker has its own GridManager, HyprlandAPI and state mirror. The
+// caller's configuration is snapshotted into it for every operation.
+class AsyncGridManager : public QObject
+{
+    Q_OBJECT
+    
+public:
+    explicit AsyncGridManager(GridManager &source, QObject *parent = nullptr);
+    ~AsyncGridManager();
+    
+    // Start the IPC thread and initialize the worker on it
+    void start();
+    
+    // Asynchronous variants of the GridManager operations
+    QFuture<bool> applyPositionAsync(const QString &preset, const QString &code);
+    QFuture<bool> resetWindowStateAsync();
+    
+    // Cancel every operation that has not finished yet
+    void cancel();
+    bool isBusy() const { return m_pendingCount > 0; }
+    
+signals:
+    void busyChanged(bool busy);
+    void applyFinished(const QString &preset, const QString &code, bool success, bool cancelled);
+    void resetFinished(bool success);
+    void errorOccurred(const QString &message);
+    
+private:
+    void operationStarted(const QFuture<bool> &future);
+    void operationDone();
+    
+    GridManager &m_source;
+    GridManager *m_worker;
+    QThread m_thread;
+    QList<QFuture<bool>> m_pending;
+    int m_pendingCount;
+};
+
+#endif // ASYNCGRIDMANAGER_H
@@ -1,4 +1,5 @@
 #include "config.h"
+#include "trace.h"
 
 #include <QFile>
 #include <QDir>
@@ -19,6 +20,8 @@ Config::Config(QObject *parent) : QObject(parent)
 
 bool Config::load()
 {
+    TRACE_SPAN("config.load", "init");
+    
     if (m_configPath.isEmpty()) {
         qDebug() << "No config file found, using defaults";
         return true;
@@ -41,8 +44,14 @@ bool Config::load()
         return false;
     }
     
-    QJsonObject obj = doc.object();
+    fromJsonObject(doc.object());
     
+    qDebug() << "Loaded configuration from" << m_configPath;
+    return true;
+}
+
+bool Config::fromJsonObject(const QJsonObject &obj)
+{
     // Load grid configuration
     if (obj.contains("grid") && obj["grid"].isObject()) {
         m_gridConfig = obj["grid"].toObject().toVariantMap();
@@ -80,7 +89,6 @@ bool Config::load()
         }
     }
     
-    qDebug() << "Loaded configuration from" << m_configPath;
     return true;
 }
 
@@ -212,6 +220,13 @@ void Config::loadDefaultConfig()
     m_advancedConfig["retryOnFailure"] = true;
     m_advancedConfig["retryCount"] = 3;
     m_advancedConfig["retryDelay"] = 200;
+    m_advancedConfig["verifyPlacement"] = "sampled";
+    m_advancedConfig["verifySampleEvery"] = 10;
+    m_advancedConfig["verifyTolerance"] = 5;
+    m_advancedConfig["floatingTimeout"] = 500;
+    m_advancedConfig["applyBudgetMs"] = 2000;
+    m_advancedConfig["breakerThreshold"] = 3;
+    m_advancedConfig["breakerCooldownMs"] = 5000;
     
     // Default presets
     QMap<QString, QVariantMap> defaultPreset;
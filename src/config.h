@@ -35,6 +35,9 @@ public:
     // Convert to JSON for saving/display
     QJsonObject toJsonObject() const;
     
+    // Replace the configuration with a JSON snapshot (as read from disk)
+    bool fromJsonObject(const QJsonObject &obj);
+    
 signals:
     void configChanged();
     void errorOccurred(const QString &message);
@@ -0,0 +1,420 @@
+#include "conformance.h"
+#include "config.h"
+#include "hyprlandjson.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QXmlStreamWriter>
+
+#include <algorithm>
+#include <cstdlib>
+#include <string_view>
+
+namespace {
+
+std::string_view view(const QByteArray &data)
+{
+    return std::string_view(data.constData(), static_cast<size_t>(data.size()));
+}
+
+QString monitorLabel(const MonitorInfo &monitor)
+{
+    return QString("%1 %2x%3@%4").arg(QString::fromStdString(monitor.name))
+        .arg(monitor.width).arg(monitor.height).arg(monitor.scale);
+}
+
+QString geometryText(const PixelPosition &geometry)
+{
+    return QString("%1,%2 %3x%4").arg(geometry.x).arg(geometry.y).arg(geometry.width).arg(geometry.height);
+}
+
+QJsonArray geometryJson(const PixelPosition &geometry)
+{
+    return QJsonArray{geometry.x, geometry.y, geometry.width, geometry.height};
+}
+
+// Cells `position` spans on `monitor`, in layout coordinates: the monitor's
+// offset, less its reserved areas, split by the grid. Worked out from
+// Hyprland's own monitor reply, never from what the grid manager computed.
+// Gaps only shrink the window inside this area.
+PixelPosition expectedArea(const MonitorInfo &monitor, const GridPosition &position, int rows, int columns)
+{
+    const double scale = monitor.scale > 0.0 ? monitor.scale : 1.0;
+    const int left = monitor.x + monitor.reservedLeft;
+    const int top = monitor.y + monitor.reservedTop;
+    const int width = static_cast<int>(monitor.width / scale) - monitor.reservedLeft - monitor.reservedRight;
+    const int height = static_cast<int>(monitor.height / scale) - monitor.reservedTop - monitor.reservedBottom;
+    
+    if (position.centered && position.scale > 0.0 && position.scale < 1.0) {
+        const int scaledWidth = static_cast<int>(width * position.scale);
+        const int scaledHeight = static_cast<int>(height * position.scale);
+        return {left + (width - scaledWidth) / 2, top + (height - scaledHeight) / 2, scaledWidth, scaledHeight};
+    }
+    
+    const int x0 = left + width * position.x / columns;
+    const int y0 = top + height * position.y / rows;
+    const int x1 = left + width * (position.x + position.width) / columns;
+    const int y1 = top + height * (position.y + position.height) / rows;
+    return {x0, y0, x1 - x0, y1 - y0};
+}
+
+// How far the window reaches past `area` on its worst side; 0 if inside
+int outsidePx(const PixelPosition &window, const PixelPosition &area)
+{
+    return std::max({area.x - window.x, area.y - window.y,
+                     (window.x + window.width) - (area.x + area.width),
+                     (window.y + window.height) - (area.y + area.height), 0});
+}
+
+// JUnit suites group the cases of one monitor and starting state
+QString suiteName(const ConformanceCase &testCase)
+{
+    return testCase.monitor + (testCase.startFloating ? " floating" : " tiled");
+}
+
+} // namespace
+
+ConformanceSuite::ConformanceSuite(GridManager &gridManager)
+    : m_gridManager(gridManager), m_tolerancePx(-1), m_latencyLimitMs(-1), m_elapsedMs(0)
+{
+}
+
+bool ConformanceSuite::run()
+{
+    m_cases.clear();
+    m_lastError.clear();
+    
+    Config *config = m_gridManager.getConfig();
+    const QVariantMap advanced = config->getAdvancedConfig();
+    if (m_tolerancePx < 0) {
+        m_tolerancePx = advanced.value("verifyTolerance", 5).toInt();
+    }
+    if (m_latencyLimitMs < 0) {
+        m_latencyLimitMs = advanced.value("applyBudgetMs", 2000).toInt();
+    }
+    
+    if (!m_ipc.isAvailable()) {
+        m_lastError = "Hyprland is not running";
+        return false;
+    }
+    if (m_gridManager.getPresetNames().isEmpty()) {
+        m_lastError = "No presets to test";
+        return false;
+    }
+    
+    IpcReply reply = m_ipc.request("monitors", IpcFormat::Json);
+    std::vector<MonitorInfo> monitors;
+    if (!reply.ok() || !HyprlandJson::decodeMonitors(view(reply.data), monitors) || monitors.empty()) {
+        m_lastError = QString("Cannot list the monitors (%1)").arg(ipcStatusName(reply.status));
+        return false;
+    }
+    
+    // Put focus back where it was once the run is over
+    WindowInfo focused;
+    reply = m_ipc.request("activewindow", IpcFormat::Json);
+    if (reply.ok()) {
+        HyprlandJson::decodeWindow(view(reply.data), focused, HyprlandJson::WindowGeometry);
+    }
+    
+    // Hundreds of bubbles help nobody; the setting is restored, not saved
+    const QVariantMap appearance = config->getAppearanceConfig();
+    QVariantMap quiet = appearance;
+    quiet["showNotifications"] = false;
+    config->setAppearanceConfig(quiet);
+    
+    QElapsedTimer elapsed;
+    elapsed.start();
+    for (const MonitorInfo &monitor : monitors) {
+        runMonitor(monitor);
+    }
+    m_elapsedMs = elapsed.elapsed();
+    
+    config->setAppearanceConfig(appearance);
+    if (focused.valid()) {
+        dispatch(QString("focuswindow address:%1").arg(QString::fromStdString(HyprlandJson::formatAddress(focused.address))));
+    }
+    return true;
+}
+
+void ConformanceSuite::runMonitor(const MonitorInfo &monitor)
+{
+    ConformanceCase setup;
+    setup.monitor = monitorLabel(monitor);
+    setup.preset = "setup";
+    setup.code = "focus";
+    
+    // Any window on the monitor's visible workspace will do
+    uint64_t address = 0;
+    IpcReply reply = m_ipc.request("clients", IpcFormat::Json);
+    if (reply.ok()) {
+        HyprlandJson::forEachClient(view(reply.data), [&](const WindowInfo &window) {
+            if (!address && window.mapped && window.workspaceId == monitor.activeWorkspaceId) {
+                address = window.address;
+            }
+        }, HyprlandJson::WindowGeometry);
+    }
+    if (!address) {
+        setup.failure = QString("No window on workspace %1").arg(monitor.activeWorkspaceId);
+        m_cases << setup;
+        return;
+    }
+    
+    const QString window = QString("address:%1").arg(QString::fromStdString(HyprlandJson::formatAddress(address)));
+    if (!dispatch(QString("workspace %1").arg(monitor.activeWorkspaceId)) ||
+        !dispatch(QString("focuswindow %1").arg(window))) {
+        setup.failure = "Cannot focus a window on the monitor";
+        m_cases << setup;
+        return;
+    }
+    
+    // Ask Hyprland itself where focus went and what the monitor looks like
+    // now; a daemon's snapshot or the monitor cache may lag behind
+    MonitorInfo current;
+    if (!readFocus(monitor.name, address, current)) {
+        setup.failure = QString("Focus did not move to %1").arg(window);
+        m_cases << setup;
+        return;
+    }
+    
+    const QVariantMap grid = m_gridManager.getConfig()->getGridConfig();
+    const int rows = qMax(1, grid.value("rows").toInt());
+    const int columns = qMax(1, grid.value("columns").toInt());
+    
+    for (bool startFloating : {true, false}) {
+        for (const QString &preset : m_gridManager.getPresetNames()) {
+            for (const QString &code : m_gridManager.getPositionCodesForPreset(preset)) {
+                ConformanceCase testCase;
+                testCase.monitor = setup.monitor;
+                testCase.startFloating = startFloating;
+                testCase.preset = preset;
+                testCase.code = code;
+                testCase.expected = expectedArea(current, m_gridManager.getGridPosition(preset, code), rows, columns);
+                
+                if (!dispatch(QString(startFloating ? "setfloating %1" : "settiled %1").arg(window))) {
+                    testCase.failure = "Cannot set the starting state";
+                    m_cases << testCase;
+                    continue;
+                }
+                
+                QElapsedTimer timer;
+                timer.start();
+                const bool applied = m_gridManager.applyPositionByCode(preset, code);
+                testCase.latencyUs = timer.nsecsElapsed() / 1000;
+                
+                const PlacementTarget &target = m_gridManager.lastPlacement();
+                testCase.requested = target.geometry;
+                testCase.attempts = target.attempts;
+                
+                WindowInfo result;
+                if (target.address.isEmpty()) {
+                    testCase.failure = "Nothing was dispatched";
+                } else if (HyprlandJson::parseAddress(target.address.toStdString()) != address) {
+                    testCase.failure = QString("Placed %1 instead of the focused window").arg(target.address);
+                } else if (!readWindow(address, result)) {
+                    testCase.failure = "Cannot read the window back";
+                } else {
+                    testCase.actual = {result.x, result.y, result.width, result.height};
+                    testCase.errorPx = outsidePx(testCase.actual, testCase.expected);
+                    if (testCase.errorPx > m_tolerancePx) {
+                        testCase.failure = QString("%1 px outside %2: at %3, requested %4").arg(testCase.errorPx)
+                            .arg(geometryText(testCase.expected), geometryText(testCase.actual),
+                                 geometryText(testCase.requested));
+                    } else if (!applied) {
+                        testCase.failure = "Apply reported failure";
+                    } else if (testCase.latencyUs > qint64(m_latencyLimitMs) * 1000) {
+                        testCase.failure = QString("Took %1 ms, limit %2 ms")
+                            .arg(testCase.latencyUs / 1000.0, 0, 'f', 1).arg(m_latencyLimitMs);
+                    }
+                }
+                m_cases << testCase;
+            }
+        }
+    }
+}
+
+bool ConformanceSuite::readFocus(const std::string &monitorName, uint64_t address, MonitorInfo &monitor) const
+{
+    QList<IpcReply> replies = m_ipc.batch(QStringList() << "activewindow" << "monitors", IpcFormat::Json);
+    WindowInfo focused;
+    std::vector<MonitorInfo> monitors;
+    if (replies.size() != 2 || !replies[0].ok() || !replies[1].ok() ||
+        !HyprlandJson::decodeWindow(view(replies[0].data), focused, HyprlandJson::WindowGeometry) ||
+        !HyprlandJson::decodeMonitors(view(replies[1].data), monitors) || focused.address != address) {
+        return false;
+    }
+    
+    for (const MonitorInfo &candidate : monitors) {
+        if (candidate.name == monitorName) {
+            monitor = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ConformanceSuite::readWindow(uint64_t address, WindowInfo &window) const
+{
+    IpcReply reply = m_ipc.request("clients", IpcFormat::Json);
+    bool found = false;
+    if (reply.ok()) {
+        HyprlandJson::forEachClient(view(reply.data), [&](const WindowInfo &client) {
+            if (client.address == address) {
+                window = client;
+                found = true;
+            }
+        }, HyprlandJson::WindowGeometry);
+    }
+    return found;
+}
+
+bool ConformanceSuite::dispatch(const QString &command) const
+{
+    return m_ipc.request("dispatch " + command, IpcFormat::Ack).ok();
+}
+
+int ConformanceSuite::failures() const
+{
+    return static_cast<int>(std::count_if(m_cases.begin(), m_cases.end(),
+                                          [](const ConformanceCase &testCase) { return !testCase.passed(); }));
+}
+
+qint64 ConformanceSuite::latencyPercentileUs(double fraction) const
+{
+    QList<qint64> latencies;
+    for (const ConformanceCase &testCase : m_cases) {
+        if (testCase.latencyUs > 0) {
+            latencies << testCase.latencyUs;
+        }
+    }
+    if (latencies.isEmpty()) {
+        return 0;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    const int index = qMin(static_cast<int>(fraction * latencies.size()), static_cast<int>(latencies.size()) - 1);
+    return latencies.at(index);
+}
+
+QString ConformanceSuite::summary() const
+{
+    QString text;
+    int maxErrorPx = 0;
+    for (const ConformanceCase &testCase : m_cases) {
+        maxErrorPx = qMax(maxErrorPx, testCase.errorPx);
+        if (!testCase.passed()) {
+            text += QString("FAIL %1:%2 on %3: %4\n").arg(testCase.preset, testCase.code, suiteName(testCase),
+                                                          testCase.failure);
+        }
+    }
+    text += QString("%1 cases, %2 failed, max error %3 px, latency p50 %4 ms, p99 %5 ms, max %6 ms\n")
+        .arg(m_cases.size()).arg(failures()).arg(maxErrorPx)
+        .arg(latencyPercentileUs(0.5) / 1000.0, 0, 'f', 1)
+        .arg(latencyPercentileUs(0.99) / 1000.0, 0, 'f', 1)
+        .arg(latencyPercentileUs(1.0) / 1000.0, 0, 'f', 1);
+    return text;
+}
+
+QByteArray ConformanceSuite::toJson() const
+{
+    QJsonArray cases;
+    int maxErrorPx = 0;
+    for (const ConformanceCase &testCase : m_cases) {
+        QJsonObject entry;
+        entry["monitor"] = testCase.monitor;
+        entry["start"] = testCase.startFloating ? "floating" : "tiled";
+        entry["preset"] = testCase.preset;
+        entry["code"] = testCase.code;
+        entry["expected"] = geometryJson(testCase.expected);
+        entry["requested"] = geometryJson(testCase.requested);
+        entry["actual"] = geometryJson(testCase.actual);
+        entry["errorPx"] = testCase.errorPx;
+        entry["attempts"] = testCase.attempts;
+        entry["latencyMs"] = testCase.latencyUs / 1000.0;
+        entry["passed"] = testCase.passed();
+        if (!testCase.passed()) {
+            entry["failure"] = testCase.failure;
+        }
+        cases.append(entry);
+        maxErrorPx = qMax(maxErrorPx, testCase.errorPx);
+    }
+    
+    QJsonObject report;
+    report["cases"] = static_cast<int>(m_cases.size());
+    report["failures"] = failures();
+    report["tolerancePx"] = m_tolerancePx;
+    report["latencyLimitMs"] = m_latencyLimitMs;
+    report["maxErrorPx"] = maxErrorPx;
+    report["latencyP50Ms"] = latencyPercentileUs(0.5) / 1000.0;
+    report["latencyP90Ms"] = latencyPercentileUs(0.9) / 1000.0;
+    report["latencyP99Ms"] = latencyPercentileUs(0.99) / 1000.0;
+    report["latencyMaxMs"] = latencyPercentileUs(1.0) / 1000.0;
+    report["elapsedMs"] = m_elapsedMs;
+    report["results"] = cases;
+    return QJsonDocument(report).toJson(QJsonDocument::Indented);
+}
+
+QByteArray ConformanceSuite::toJUnit() const
+{
+    QByteArray xml;
+    QXmlStreamWriter writer(&xml);
+    writer.setAutoFormatting(true);
+    writer.writeStartDocument();
+    writer.writeStartElement("testsuites");
+    writer.writeAttribute("name", "hypr-grid-conformance");
+    writer.writeAttribute("tests", QString::number(m_cases.size()));
+    writer.writeAttribute("failures", QString::number(failures()));
+    writer.writeAttribute("time", QString::number(m_elapsedMs / 1000.0, 'f', 3));
+    
+    // Cases are stored grouped already, one suite per run of equal names
+    for (int begin = 0; begin < m_cases.size();) {
+        const QString name = suiteName(m_cases.at(begin));
+        int end = begin;
+        int failed = 0;
+        qint64 suiteUs = 0;
+        while (end < m_cases.size() && suiteName(m_cases.at(end)) == name) {
+            failed += m_cases.at(end).passed() ? 0 : 1;
+            suiteUs += m_cases.at(end).latencyUs;
+            ++end;
+        }
+        
+        writer.writeStartElement("testsuite");
+        writer.writeAttribute("name", name);
+        writer.writeAttribute("tests", QString::number(end - begin));
+        writer.writeAttribute("failures", QString::number(failed));
+        writer.writeAttribute("time", QString::number(suiteUs / 1e6, 'f', 3));
+        for (int i = begin; i < end; ++i) {
+            const ConformanceCase &testCase = m_cases.at(i);
+            writer.writeStartElement("testcase");
+            writer.writeAttribute("classname", testCase.preset);
+            writer.writeAttribute("name", testCase.code);
+            writer.writeAttribute("time", QString::number(testCase.latencyUs / 1e6, 'f', 6));
+            if (!testCase.passed()) {
+                writer.writeStartElement("failure");
+                writer.writeAttribute("message", testCase.failure);
+                writer.writeEndElement();
+            }
+            writer.writeTextElement("system-out", QString("expected %1, requested %2, actual %3, error %4 px, %5 attempts")
+                .arg(geometryText(testCase.expected), geometryText(testCase.requested), geometryText(testCase.actual))
+                .arg(testCase.errorPx).arg(testCase.attempts));
+            writer.writeEndElement();
+        }
+        writer.writeEndElement();
+        begin = end;
+    }
+    
+    writer.writeEndElement();
+    writer.writeEndDocument();
+    return xml;
+}
+
+bool ConformanceSuite::writeReport(const QString &path) const
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    const QByteArray report = path.endsWith(".xml", Qt::CaseInsensitive) ? toJUnit() : toJson();
+    return file.write(report) == report.size();
+}
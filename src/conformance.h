@@ -0,0 +1,80 @@
+#ifndef CONFORMANCE_H
+#define CONFORMANCE_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+#include "gridmanager.h"
+#include "hyprlandipc.h"
+
+// Placement-accuracy conformance run behind `hypr-grid-manager --test`.
+// Applies every position of every preset on every monitor, once from a
+// floating and once from a tiled window, and checks that the window ended
+// up inside the grid cells the position spans on that monitor. Those are
+// worked out from Hyprland's monitor reply, not from the grid manager.
+// Nothing waits between cases; each one is timed from the request until
+// the apply returned.
+//
+// Run it against hypr-grid-mock-hyprland to check a build headlessly; the
+// JUnit or JSON report is what a release gate reads.
+struct ConformanceCase {
+    QString monitor;            // "DP-1 2560x1440@1.25"
+    bool startFloating = false;
+    QString preset;
+    QString code;
+    PixelPosition expected = {0, 0, 0, 0};     // Cells the position spans
+    PixelPosition requested = {0, 0, 0, 0};    // What the grid manager dispatched
+    PixelPosition actual = {0, 0, 0, 0};
+    int errorPx = -1;           // How far outside `expected`, -1 if not measured
+    int attempts = 0;
+    qint64 latencyUs = 0;
+    QString failure;            // Why the case failed, empty if it passed
+    
+    bool passed() const { return failure.isEmpty(); }
+};
+
+class ConformanceSuite
+{
+public:
+    explicit ConformanceSuite(GridManager &gridManager);
+    
+    // Limits beyond which a case fails; by default the advanced
+    // "verifyTolerance" and "applyBudgetMs"
+    void setTolerancePx(int tolerancePx) { m_tolerancePx = tolerancePx; }
+    void setLatencyLimitMs(int latencyLimitMs) { m_latencyLimitMs = latencyLimitMs; }
+    
+    // False if the run could not start at all (no Hyprland, no presets)
+    bool run();
+    QString lastError() const { return m_lastError; }
+    
+    const QList<ConformanceCase> &cases() const { return m_cases; }
+    int failures() const;
+    
+    // Failed cases and the totals, for the terminal
+    QString summary() const;
+    
+    QByteArray toJson() const;
+    QByteArray toJUnit() const;
+    
+    // JUnit XML for a path ending in .xml, JSON otherwise
+    bool writeReport(const QString &path) const;
+    
+private:
+    void runMonitor(const MonitorInfo &monitor);
+    // True if `address` has focus; `monitor` is then read afresh
+    bool readFocus(const std::string &monitorName, uint64_t address, MonitorInfo &monitor) const;
+    bool readWindow(uint64_t address, WindowInfo &window) const;
+    bool dispatch(const QString &command) const;
+    qint64 latencyPercentileUs(double fraction) const;
+    
+    GridManager &m_gridManager;
+    HyprlandIPC m_ipc;
+    int m_tolerancePx;
+    int m_latencyLimitMs;
+    qint64 m_elapsedMs;
+    QList<ConformanceCase> m_cases;
+    QString m_lastError;
+};
+
+#endif // CONFORMANCE_H
@@ -0,0 +1,56 @@
+#ifndef DAEMONPROTOCOL_H
+#define DAEMONPROTOCOL_H
+
+// Wire protocol between the resident daemon (hypr-grid-manager --daemon)
+// and hypr-grid-client. Plain C++ only: the client must not depend on Qt.
+//
+// One request line per connection, one reply line back:
+//   apply <preset>:<position>   ->  ok | error <message>
+//   reset                       ->  ok | error <message>
+//   stats                       ->  ok <apply queue and placement counters, key=value ...>
+//   metrics [json]              ->  ok, then metrics in Prometheus text (or JSON)
+//                                   until the daemon closes the connection
+//   ping                        ->  ok
+
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+namespace DaemonProtocol {
+
+constexpr const char *ReplyOk = "ok";
+constexpr const char *ReplyError = "error";
+
+// Requests longer than this are rejected
+constexpr int MaxRequestSize = 1024;
+
+// How long either side waits for the other before giving up
+constexpr int TimeoutMs = 3000;
+
+// Per-instance file in the user's runtime directory, e.g. ".sock"
+inline std::string runtimeFilePath(const char *suffix)
+{
+    std::string name = "hypr-grid-manager";
+    const char *signature = std::getenv("HYPRLAND_INSTANCE_SIGNATURE");
+    if (signature && *signature) {
+        name += "-";
+        name += signature;
+    }
+    name += suffix;
+    
+    const char *runtimeDir = std::getenv("XDG_RUNTIME_DIR");
+    if (runtimeDir && *runtimeDir) {
+        return std::string(runtimeDir) + "/" + name;
+    }
+    return "/tmp/" + std::to_string(getuid()) + "-" + name;
+}
+
+// One daemon per Hyprland instance
+inline std::string socketPath()
+{
+    return runtimeFilePath(".sock");
+}
+
+} // namespace DaemonProtocol
+
+#endif // DAEMONPROTOCOL_H
@@ -0,0 +1,306 @@
+#include "daemonserver.h"
+#include "daemonprotocol.h"
+#include "gridmanager.h"
+#include "hyprlandipc.h"
+#include "trace.h"
+#include "metrics.h"
+
+#include <QSocketNotifier>
+#include <QTimer>
+#include <QFile>
+#include <QDebug>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+DaemonServer::DaemonServer(GridManager &gridManager, QObject *parent)
+    : QObject(parent), m_gridManager(gridManager), m_nextConnectionId(0), m_processing(false),
+      m_listenFd(-1), m_notifier(nullptr)
+{
+    m_socketPath = QString::fromStdString(DaemonProtocol::socketPath());
+    
+    // Remember the last error so it can be sent back to the client
+    connect(&m_gridManager, &GridManager::errorOccurred, this, [this](const QString &message) {
+        m_lastError = message;
+    });
+}
+
+DaemonServer::~DaemonServer()
+{
+    for (const PendingRequest &pending : m_pending) {
+        ::close(pending.fd);
+    }
+    for (auto it = m_connections.constBegin(); it != m_connections.constEnd(); ++it) {
+        ::close(it.key());
+    }
+    if (m_listenFd >= 0) {
+        ::close(m_listenFd);
+        ::unlink(QFile::encodeName(m_socketPath).constData());
+    }
+}
+
+bool DaemonServer::start()
+{
+    const QByteArray path = QFile::encodeName(m_socketPath);
+    
+    // A connectable socket means another daemon is already serving
+    int probe = HyprlandIPC::connectSocket(m_socketPath);
+    if (probe >= 0) {
+        ::close(probe);
+        qCritical() << "A daemon is already listening on" << m_socketPath;
+        return false;
+    }
+    ::unlink(path.constData());
+    
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (static_cast<size_t>(path.size()) >= sizeof(addr.sun_path)) {
+        qCritical() << "Daemon socket path too long:" << m_socketPath;
+        return false;
+    }
+    memcpy(addr.sun_path, path.constData(), path.size());
+    
+    m_listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (m_listenFd < 0) {
+        qCritical() << "Cannot create daemon socket:" << strerror(errno);
+        return false;
+    }
+    
+    if (::bind(m_listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0
+        || ::listen(m_listenFd, 16) != 0) {
+        qCritical() << "Cannot listen on" << m_socketPath << ":" << strerror(errno);
+        ::close(m_listenFd);
+        m_listenFd = -1;
+        return false;
+    }
+    ::chmod(path.constData(), S_IRUSR | S_IWUSR);
+    
+    m_notifier = new QSocketNotifier(m_listenFd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &DaemonServer::onConnectionPending);
+    
+    qInfo() << "Daemon listening on" << m_socketPath;
+    return true;
+}
+
+void DaemonServer::onConnectionPending()
+{
+    acceptPending();
+    processPending();
+}
+
+void DaemonServer::acceptPending()
+{
+    while (true) {
+        int fd = ::accept4(m_listenFd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        
+        const quint64 id = ++m_nextConnectionId;
+        m_connections[fd].id = id;
+        QTimer::singleShot(DaemonProtocol::TimeoutMs, this, [this, fd, id]() {
+            auto it = m_connections.constFind(fd);
+            if (it != m_connections.constEnd() && it->id == id) {
+                qWarning() << "Daemon client sent no request";
+                closeConnection(fd);
+            }
+        });
+        
+        // The client usually writes its line right after connecting
+        if (!readConnection(fd)) {
+            QSocketNotifier *notifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+            connect(notifier, &QSocketNotifier::activated, this, [this, fd]() {
+                if (readConnection(fd)) {
+                    processPending();
+                }
+            });
+            m_connections[fd].notifier = notifier;
+        }
+    }
+    
+    // No event loop runs during an apply, so look at the slower clients here
+    const QList<int> reading = m_connections.keys();
+    for (int fd : reading) {
+        readConnection(fd);
+    }
+}
+
+void DaemonServer::processPending()
+{
+    // Requests accepted during an apply are picked up by the loop below
+    if (m_processing) {
+        return;
+    }
+    m_processing = true;
+    
+    while (!m_pending.isEmpty()) {
+        PendingRequest pending = m_pending.takeFirst();
+        sendReply(pending.fd, handleRequest(pending));
+        ::close(pending.fd);
+    }
+    
+    m_processing = false;
+}
+
+bool DaemonServer::readConnection(int fd)
+{
+    // Take what has arrived without waiting; true once the connection is
+    // done with, its request queued or the connection closed
+    QByteArray &buffer = m_connections[fd].buffer;
+    char chunk[DaemonProtocol::MaxRequestSize];
+    bool ended = false;
+    while (!buffer.contains('\n') && buffer.size() < DaemonProtocol::MaxRequestSize) {
+        ssize_t n = ::read(fd, chunk, sizeof(chunk));
+        if (n > 0) {
+            buffer.append(chunk, n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && errno == EAGAIN) {
+            return false;
+        }
+        ended = true;
+        break;
+    }
+    
+    const QByteArray request = buffer.left(buffer.indexOf('\n')).trimmed();
+    if (request.isEmpty()) {
+        if (ended) {
+            qWarning() << "Daemon client sent no request";
+        }
+        closeConnection(fd);
+        return true;
+    }
+    
+    QSocketNotifier *notifier = m_connections.take(fd).notifier;
+    if (notifier) {
+        notifier->setEnabled(false);
+        notifier->deleteLater();
+    }
+    queueRequest(fd, request);
+    return true;
+}
+
+void DaemonServer::closeConnection(int fd)
+{
+    QSocketNotifier *notifier = m_connections.take(fd).notifier;
+    if (notifier) {
+        notifier->setEnabled(false);
+        notifier->deleteLater();
+    }
+    ::close(fd);
+}
+
+void DaemonServer::queueRequest(int fd, const QByteArray &request)
+{
+    // Replies are written in one go, metrics included
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+    
+    PendingRequest pending;
+    pending.fd = fd;
+    pending.request = request;
+    pending.ticket = 0;
+    
+    // Enqueue at arrival, so a newer request supersedes this one even
+    // before it gets its turn. Only the address is read here: this may run
+    // inside another apply's cancellation check, mid-placement. The full
+    // context is captured when the ticket runs.
+    if (pending.request.startsWith("apply ") && m_queue.isOpen()) {
+        pending.ticket = m_queue.enqueue(m_gridManager.focusedWindowAddress().toStdString());
+    }
+    m_pending.append(pending);
+}
+
+void DaemonServer::sendReply(int fd, QByteArray reply)
+{
+    reply.append('\n');
+    
+    qsizetype written = 0;
+    while (written < reply.size()) {
+        ssize_t n = ::write(fd, reply.constData() + written, reply.size() - written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            qWarning() << "Failed to send daemon reply";
+            return;
+        }
+        written += n;
+    }
+}
+
+QByteArray DaemonServer::handleRequest(const PendingRequest &pending)
+{
+    const QByteArray &request = pending.request;
+    Trace::Span span("daemon.request", "daemon");
+    if (span.active()) {
+        span.setDetail(request.toStdString());
+    }
+    
+    m_lastError.clear();
+    bool success = false;
+    
+    if (request == "ping") {
+        success = true;
+    }
+    else if (request == "stats") {
+        const PlacementStats &placement = m_gridManager.placementStats();
+        QString placementStats = QString(" placements=%1 verified=%2 matched=%3 corrected=%4 off_target=%5"
+                                         " unreadable=%6 retries=%7 placement_failed=%8 max_error_px=%9")
+            .arg(placement.placements).arg(placement.verified).arg(placement.matched)
+            .arg(placement.corrected).arg(placement.offTarget).arg(placement.unreadable)
+            .arg(placement.retries).arg(placement.failed).arg(placement.maxErrorPx);
+        const CircuitBreaker &breaker = m_gridManager.hyprland()->breaker();
+        QString ipcStats = QString(" over_budget=%1 deadline_expired=%2 ipc_timeouts=%3 breaker=%4"
+                                   " breaker_trips=%5 breaker_rejected=%6")
+            .arg(placement.overBudget).arg(m_gridManager.hyprland()->expiredRequests())
+            .arg(breaker.stats().timeouts).arg(CircuitBreaker::stateName(breaker.state()))
+            .arg(breaker.stats().trips).arg(breaker.stats().rejected);
+        return QByteArray(DaemonProtocol::ReplyOk) + " "
+            + QByteArray::fromStdString(ApplyQueue::formatStats(m_queue.stats()))
+            + placementStats.toUtf8() + ipcStats.toUtf8();
+    }
+    else if (request == "metrics" || request == "metrics json") {
+        // The only multi-line reply: the body follows until the connection closes
+        const std::string body = request == "metrics" ? Metrics::formatPrometheus() : Metrics::formatJson();
+        return QByteArray(DaemonProtocol::ReplyOk) + "\n" + QByteArray::fromStdString(body);
+    }
+    else if (request == "reset") {
+        success = m_gridManager.resetWindowState();
+    }
+    else if (request.startsWith("apply ")) {
+        QStringList parts = QString::fromUtf8(request.mid(6)).split(":");
+        if (parts.size() != 2) {
+            return QByteArray(DaemonProtocol::ReplyError) + " Invalid apply format. Use preset:position";
+        }
+        if (pending.ticket == 0) {
+            success = m_gridManager.applyPositionByCode(parts[0], parts[1]);
+        } else {
+            // Superseded requests still succeed: the newer one places the window
+            ApplyQueue::Outcome outcome = m_gridManager.runQueuedApply(m_queue, pending.ticket, parts[0], parts[1],
+                                                                       [this]() { acceptPending(); });
+            success = outcome != ApplyQueue::Failed;
+        }
+    }
+    else {
+        return QByteArray(DaemonProtocol::ReplyError) + " Unknown request";
+    }
+    
+    if (success) {
+        return DaemonProtocol::ReplyOk;
+    }
+    
+    QString message = m_lastError.isEmpty() ? QString("Request failed") : m_lastError;
+    return QByteArray(DaemonProtocol::ReplyError) + " " + message.toUtf8();
+}
@@ -0,0 +1,75 @@
+#ifndef DAEMONSERVER_H
+#define DAEMONSERVER_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+
+#include "applyqueue.h"
+
+class GridManager;
+class QSocketNotifier;
+
+// Resident-mode listener. Keeps the GridManager, its parsed Config and the
+// Hyprland state mirror warm and serves requests from hypr-grid-client over
+// a Unix socket (see daemonprotocol.h).
+//
+// Apply requests go through the ApplyQueue shared with one-shot CLI runs.
+// Connections are taken in while an apply runs, so a burst of keypresses
+// collapses to the last one for each window instead of replaying them all.
+// Nothing here waits on a client: a connection is read as its data arrives
+// and dropped if no complete request line follows in time.
+class DaemonServer : public QObject
+{
+    Q_OBJECT
+    
+public:
+    explicit DaemonServer(GridManager &gridManager, QObject *parent = nullptr);
+    ~DaemonServer();
+    
+    // Bind the socket; fails if another daemon already serves this instance
+    bool start();
+    QString socketPath() const { return m_socketPath; }
+    
+private slots:
+    void onConnectionPending();
+    
+private:
+    struct PendingRequest {
+        int fd;
+        QByteArray request;
+        uint64_t ticket;
+    };
+    
+    // Accepted, request line still incomplete
+    struct Connection {
+        quint64 id = 0;
+        QByteArray buffer;
+        QSocketNotifier *notifier = nullptr;
+    };
+    
+    // Accept every waiting connection and queue the requests that are
+    // complete; never blocks, as it also runs between the steps of an apply
+    void acceptPending();
+    void processPending();
+    bool readConnection(int fd);
+    void closeConnection(int fd);
+    void queueRequest(int fd, const QByteArray &request);
+    void sendReply(int fd, QByteArray reply);
+    QByteArray handleRequest(const PendingRequest &pending);
+    
+    GridManager &m_gridManager;
+    ApplyQueue m_queue;
+    QList<PendingRequest> m_pending;
+    QHash<int, Connection> m_connections;   // By fd
+    quint64 m_nextConnectionId;
+    bool m_processing;
+    int m_listenFd;
+    QSocketNotifier *m_notifier;
+    QString m_socketPath;
+    QString m_lastError;
+};
+
+#endif // DAEMONSERVER_H
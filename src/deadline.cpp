@@ -0,0 +1,115 @@
+#include "deadline.h"
+
+#include <algorithm>
+
+#include <time.h>
+
+namespace {
+
+int64_t monotonicNs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+} // namespace
+
+Deadline::Deadline()
+    : m_startNs(0), m_budgetMs(-1)
+{
+}
+
+Deadline Deadline::in(int budgetMs)
+{
+    Deadline deadline;
+    deadline.m_startNs = monotonicNs();
+    deadline.m_budgetMs = std::max(0, budgetMs);
+    return deadline;
+}
+
+bool Deadline::expired() const
+{
+    return isSet() && elapsedMs() >= m_budgetMs;
+}
+
+int Deadline::elapsedMs() const
+{
+    return isSet() ? static_cast<int>((monotonicNs() - m_startNs) / 1000000) : 0;
+}
+
+int Deadline::remainingMs(int capMs) const
+{
+    if (!isSet()) {
+        return capMs;
+    }
+    return std::max(0, std::min(capMs, m_budgetMs - elapsedMs()));
+}
+
+CircuitBreaker::CircuitBreaker(int threshold, int cooldownMs)
+    : m_threshold(threshold), m_cooldownMs(cooldownMs), m_consecutiveTimeouts(0), m_openedNs(0),
+      m_state(Closed)
+{
+}
+
+void CircuitBreaker::configure(int threshold, int cooldownMs)
+{
+    m_threshold = std::max(0, threshold);
+    m_cooldownMs = std::max(0, cooldownMs);
+    if (m_threshold == 0) {
+        m_state = Closed;
+        m_consecutiveTimeouts = 0;
+    }
+}
+
+bool CircuitBreaker::allow()
+{
+    switch (m_state) {
+    case Closed:
+        return true;
+    case Open:
+        if (monotonicNs() - m_openedNs >= static_cast<int64_t>(m_cooldownMs) * 1000000) {
+            m_state = HalfOpen;
+            return true;
+        }
+        break;
+    case HalfOpen:
+        // Requests are made one at a time, so this is the next probe after
+        // one that ended without an answer either way (no socket, I/O error)
+        return true;
+    }
+    m_stats.rejected++;
+    return false;
+}
+
+void CircuitBreaker::recordSuccess()
+{
+    m_consecutiveTimeouts = 0;
+    m_state = Closed;
+}
+
+void CircuitBreaker::recordTimeout()
+{
+    m_stats.timeouts++;
+    if (m_threshold == 0) {
+        return;
+    }
+    
+    // A failed probe reopens at once
+    if (m_state == HalfOpen || ++m_consecutiveTimeouts >= m_threshold) {
+        m_state = Open;
+        m_openedNs = monotonicNs();
+        m_consecutiveTimeouts = 0;
+        m_stats.trips++;
+    }
+}
+
+const char *CircuitBreaker::stateName(State state)
+{
+    switch (state) {
+    case Closed: return "closed";
+    case Open: return "open";
+    case HalfOpen: return "half-open";
+    }
+    return "unknown";
+}
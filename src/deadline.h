@@ -0,0 +1,78 @@
+#ifndef DEADLINE_H
+#define DEADLINE_H
+
+// Time budget of one apply and a circuit breaker for Hyprland requests.
+//
+// An apply sets one Deadline on the Hyprland API; every request, hyprctl
+// spawn and event wait below it gets the remaining time as its timeout, so
+// a hung compositor costs at most the budget. The breaker opens after a
+// few timeouts in a row and refuses requests at once until its cooldown
+// passes; then one probe is let through, and any answer closes it again.
+//
+// Plain C++ so the benchmarks can use it without Qt.
+
+#include <cstdint>
+
+class Deadline
+{
+public:
+    // No deadline: remainingMs() always grants the caller's own timeout
+    Deadline();
+    
+    static Deadline in(int budgetMs);
+    
+    bool isSet() const { return m_budgetMs >= 0; }
+    bool expired() const;
+    int budgetMs() const { return m_budgetMs; }
+    int elapsedMs() const;
+    
+    // Time left, at most `capMs`; 0 once expired
+    int remainingMs(int capMs) const;
+    
+private:
+    int64_t m_startNs;
+    int m_budgetMs;
+};
+
+class CircuitBreaker
+{
+public:
+    enum State {
+        Closed,     // Requests go out
+        Open,       // Refused until the cooldown passes
+        HalfOpen    // One probe is out; its outcome decides
+    };
+    
+    struct Stats {
+        uint64_t timeouts = 0;      // Requests that timed out
+        uint64_t trips = 0;         // Times the breaker opened
+        uint64_t rejected = 0;      // Requests refused while open
+    };
+    
+    explicit CircuitBreaker(int threshold = 3, int cooldownMs = 5000);
+    
+    // A threshold of 0 disables the breaker
+    void configure(int threshold, int cooldownMs);
+    
+    // Whether a request may go out now
+    bool allow();
+    
+    // Any answer from Hyprland counts as success, even an error reply
+    void recordSuccess();
+    void recordTimeout();
+    
+    State state() const { return m_state; }
+    const Stats &stats() const { return m_stats; }
+    
+    static const char *stateName(State state);
+    
+private:
+    int m_threshold;
+    int m_cooldownMs;
+    int m_consecutiveTimeouts;
+    int64_t m_openedNs;
+    State m_state;
+    Stats m_stats;
+};
+
+#endif // DEADLINE_H
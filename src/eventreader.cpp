@@ -0,0 +1,509 @@
+#include "eventreader.h"
+#include "hyprlandjson.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace {
+
+// Split data into at most `count` comma-separated fields; the last one
+// keeps any further commas, since titles may contain them
+int splitFields(std::string_view data, std::string_view *fields, int count)
+{
+    int found = 0;
+    while (found < count - 1) {
+        const size_t comma = data.find(',');
+        if (comma == std::string_view::npos) {
+            break;
+        }
+        fields[found++] = data.substr(0, comma);
+        data.remove_prefix(comma + 1);
+    }
+    fields[found++] = data;
+    return found;
+}
+
+int32_t parseId(std::string_view text)
+{
+    int32_t value = 0;
+    std::from_chars(text.data(), text.data() + text.size(), value);
+    return value;
+}
+
+void appendField(EventRecord &record, std::string_view value)
+{
+    size_t room = EventRecord::TextCapacity - record.textSize;
+    if (room == 0) {
+        return;
+    }
+    
+    // Cut at a character boundary, leaving room for the NUL
+    size_t length = std::min(value.size(), room - 1);
+    if (length < value.size()) {
+        while (length > 0 && (static_cast<unsigned char>(value[length]) & 0xc0) == 0x80) {
+            length--;
+        }
+    }
+    memcpy(record.text + record.textSize, value.data(), length);
+    record.textSize = static_cast<uint16_t>(record.textSize + length);
+    record.text[record.textSize++] = '\0';
+}
+
+bool sameEvent(const EventRecord &a, const EventRecord &b)
+{
+    return a.type == b.type && a.address == b.address && a.workspaceId == b.workspaceId && a.flag == b.flag &&
+           a.textSize == b.textSize && memcmp(a.text, b.text, a.textSize) == 0;
+}
+
+// Events whose repeat changes nothing; repeated opens and closes still
+// count windows
+bool isIdempotent(EventType type)
+{
+    switch (type) {
+    case EventType::ActiveWindow:
+    case EventType::FloatingMode:
+    case EventType::WindowTitle:
+    case EventType::Workspace:
+    case EventType::FocusedMonitor:
+    case EventType::FocusedMonitorByName:
+        return true;
+    default:
+        return false;
+    }
+}
+
+} // namespace
+
+const char *eventTypeName(EventType type)
+{
+    switch (type) {
+    case EventType::None: return "none";
+    case EventType::ActiveWindow: return "activewindowv2";
+    case EventType::OpenWindow: return "openwindow";
+    case EventType::CloseWindow: return "closewindow";
+    case EventType::MoveWindow: return "movewindowv2";
+    case EventType::FloatingMode: return "changefloatingmode";
+    case EventType::WindowTitle: return "windowtitlev2";
+    case EventType::Workspace: return "workspacev2";
+    case EventType::FocusedMonitor: return "focusedmonv2";
+    case EventType::FocusedMonitorByName: return "focusedmon";
+    case EventType::CreateWorkspace: return "createworkspacev2";
+    case EventType::DestroyWorkspace: return "destroyworkspacev2";
+    case EventType::MoveWorkspace: return "moveworkspacev2";
+    case EventType::MonitorRemoved: return "monitorremoved";
+    case EventType::MonitorsChanged: return "monitorschanged";
+    }
+    return "unknown";
+}
+
+std::string_view EventRecord::field(int index) const
+{
+    size_t start = 0;
+    while (start < textSize) {
+        const size_t end = start + strnlen(text + start, textSize - start);
+        if (index-- == 0) {
+            return std::string_view(text + start, end - start);
+        }
+        start = end + 1;
+    }
+    return std::string_view();
+}
+
+bool parseEventLine(std::string_view line, EventRecord &record)
+{
+    const size_t separator = line.find(">>");
+    if (separator == std::string_view::npos || separator == 0) {
+        return false;
+    }
+    const std::string_view name = line.substr(0, separator);
+    const std::string_view data = line.substr(separator + 2);
+    
+    record.address = 0;
+    record.workspaceId = 0;
+    record.lines = 1;
+    record.type = EventType::None;
+    record.flag = 0;
+    record.textSize = 0;
+    
+    // A window event with too few fields keeps address 0, which the
+    // consumer cannot apply and reloads the model for
+    std::string_view fields[4];
+    if (name == "activewindowv2") {
+        record.type = EventType::ActiveWindow;
+        record.address = (data.empty() || data == ",") ? 0 : HyprlandJson::parseAddress(data);
+    }
+    else if (name == "openwindow") {
+        // ADDRESS,WORKSPACENAME,CLASS,TITLE
+        record.type = EventType::OpenWindow;
+        if (splitFields(data, fields, 4) == 4) {
+            record.address = HyprlandJson::parseAddress(fields[0]);
+            appendField(record, fields[1]);
+            appendField(record, fields[2]);
+            appendField(record, fields[3]);
+        }
+    }
+    else if (name == "closewindow") {
+        record.type = EventType::CloseWindow;
+        record.address = HyprlandJson::parseAddress(data);
+    }
+    else if (name == "movewindowv2") {
+        // ADDRESS,WORKSPACEID,WORKSPACENAME
+        record.type = EventType::MoveWindow;
+        if (splitFields(data, fields, 3) == 3) {
+            record.address = HyprlandJson::parseAddress(fields[0]);
+            record.workspaceId = parseId(fields[1]);
+        }
+    }
+    else if (name == "changefloatingmode") {
+        // ADDRESS,FLOATING
+        record.type = EventType::FloatingMode;
+        if (splitFields(data, fields, 2) == 2) {
+            record.address = HyprlandJson::parseAddress(fields[0]);
+            record.flag = fields[1] == "1";
+        }
+    }
+    else if (name == "windowtitlev2") {
+        // ADDRESS,TITLE
+        record.type = EventType::WindowTitle;
+        splitFields(data, fields, 2);
+        record.address = HyprlandJson::parseAddress(fields[0]);
+        appendField(record, fields[1]);
+    }
+    else if (name == "workspacev2") {
+        // WORKSPACEID,WORKSPACENAME on the focused monitor
+        record.type = EventType::Workspace;
+        splitFields(data, fields, 2);
+        record.workspaceId = parseId(fields[0]);
+    }
+    else if (name == "focusedmonv2") {
+        // MONITORNAME,WORKSPACEID
+        record.type = EventType::FocusedMonitor;
+        splitFields(data, fields, 2);
+        appendField(record, fields[0]);
+        record.workspaceId = parseId(fields[1]);
+    }
+    else if (name == "focusedmon") {
+        // MONITORNAME,WORKSPACENAME
+        record.type = EventType::FocusedMonitorByName;
+        splitFields(data, fields, 2);
+        appendField(record, fields[0]);
+        appendField(record, fields[1]);
+    }
+    else if (name == "createworkspacev2") {
+        // WORKSPACEID,WORKSPACENAME
+        record.type = EventType::CreateWorkspace;
+        splitFields(data, fields, 2);
+        record.workspaceId = parseId(fields[0]);
+        appendField(record, fields[1]);
+    }
+    else if (name == "destroyworkspacev2") {
+        record.type = EventType::DestroyWorkspace;
+        splitFields(data, fields, 2);
+        record.workspaceId = parseId(fields[0]);
+    }
+    else if (name == "moveworkspacev2") {
+        // WORKSPACEID,WORKSPACENAME,MONITORNAME
+        record.type = EventType::MoveWorkspace;
+        splitFields(data, fields, 3);
+        record.workspaceId = parseId(fields[0]);
+        appendField(record, fields[1]);
+        appendField(record, fields[2]);
+    }
+    else if (name == "monitorremoved") {
+        record.type = EventType::MonitorRemoved;
+        appendField(record, data);
+    }
+    else if (name == "monitoradded" || name == "monitoraddedv2" || name == "configreloaded") {
+        record.type = EventType::MonitorsChanged;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+void coalesceEvents(std::vector<EventRecord> &records)
+{
+    std::vector<bool> dropped(records.size(), false);
+    
+    // Walking backwards, a title is redundant once a later one for the same
+    // window is known; an open or close in between keeps it
+    std::unordered_map<uint64_t, size_t> laterTitle;
+    for (size_t i = records.size(); i-- > 0;) {
+        const EventRecord &record = records[i];
+        if (record.type == EventType::WindowTitle) {
+            auto it = laterTitle.find(record.address);
+            if (it != laterTitle.end()) {
+                records[it->second].lines += record.lines;
+                dropped[i] = true;
+            } else {
+                laterTitle.emplace(record.address, i);
+            }
+        } else if (record.type == EventType::OpenWindow || record.type == EventType::CloseWindow) {
+            laterTitle.erase(record.address);
+        }
+    }
+    
+    // A repeat replaces the record it repeats, which then goes
+    size_t kept = 0;
+    for (size_t i = 0; i < records.size(); ++i) {
+        if (dropped[i]) {
+            continue;
+        }
+        if (kept > 0 && isIdempotent(records[i].type) && sameEvent(records[kept - 1], records[i])) {
+            records[kept - 1].lines += records[i].lines;
+            continue;
+        }
+        records[kept++] = records[i];
+    }
+    records.resize(kept);
+}
+
+EventReader::EventReader()
+    : m_socketFd(-1), m_stopping(false), m_closed(false), m_notified(false),
+      m_requestSerial(0), m_discardSerial(0), m_servedSerial(0),
+      m_lines(0), m_coalesced(0), m_overflows(0), m_maxQueued(0), m_maxBuffered(0)
+{
+    m_notifyFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    m_wakeFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+}
+
+EventReader::~EventReader()
+{
+    stop();
+    if (m_notifyFd >= 0) {
+        ::close(m_notifyFd);
+    }
+    if (m_wakeFd >= 0) {
+        ::close(m_wakeFd);
+    }
+}
+
+bool EventReader::start(int socketFd)
+{
+    if (isRunning() || socketFd < 0 || m_notifyFd < 0 || m_wakeFd < 0) {
+        return false;
+    }
+    
+    ::fcntl(socketFd, F_SETFL, ::fcntl(socketFd, F_GETFL) | O_NONBLOCK);
+    m_socketFd = socketFd;
+    m_stopping = false;
+    m_closed = false;
+    m_thread = std::thread(&EventReader::run, this);
+    return true;
+}
+
+void EventReader::stop()
+{
+    if (m_thread.joinable()) {
+        m_stopping = true;
+        const uint64_t one = 1;
+        [[maybe_unused]] ssize_t n = ::write(m_wakeFd, &one, sizeof(one));
+        m_thread.join();
+    }
+    if (m_socketFd >= 0) {
+        ::close(m_socketFd);
+        m_socketFd = -1;
+    }
+}
+
+void EventReader::clearNotification()
+{
+    uint64_t value;
+    [[maybe_unused]] ssize_t n = ::read(m_notifyFd, &value, sizeof(value));
+    
+    // Pairs with notify(), so the pops after this see what was pushed before
+    m_notified.exchange(false, std::memory_order_acq_rel);
+}
+
+bool EventReader::catchUp(int timeoutMs)
+{
+    return request(false, timeoutMs);
+}
+
+bool EventReader::discardQueued(int timeoutMs)
+{
+    const bool served = request(true, timeoutMs);
+    
+    // Whatever was pushed before the reader dropped its input goes too
+    EventRecord record;
+    while (m_ring.pop(record)) {
+    }
+    return served;
+}
+
+EventReader::Stats EventReader::stats() const
+{
+    Stats stats;
+    stats.lines = m_lines.load(std::memory_order_relaxed);
+    stats.coalesced = m_coalesced.load(std::memory_order_relaxed);
+    stats.overflows = m_overflows.load(std::memory_order_relaxed);
+    stats.maxQueued = m_maxQueued.load(std::memory_order_relaxed);
+    stats.maxBuffered = m_maxBuffered.load(std::memory_order_relaxed);
+    return stats;
+}
+
+bool EventReader::request(bool discard, int timeoutMs)
+{
+    if (!isRunning()) {
+        return false;
+    }
+    
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const uint64_t serial = ++m_requestSerial;
+    if (discard) {
+        m_discardSerial = serial;
+    }
+    const uint64_t one = 1;
+    [[maybe_unused]] ssize_t n = ::write(m_wakeFd, &one, sizeof(one));
+    
+    return m_served.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this, serial]() {
+        return m_servedSerial >= serial || isClosed();
+    });
+}
+
+void EventReader::run()
+{
+    std::string buffer;
+    std::vector<EventRecord> records;
+    records.reserve(RingCapacity);
+    
+    while (!m_stopping) {
+        pollfd fds[2] = {{m_socketFd, POLLIN, 0}, {m_wakeFd, POLLIN, 0}};
+        if (::poll(fds, 2, -1) < 0 && errno != EINTR) {
+            break;
+        }
+        if (fds[1].revents & POLLIN) {
+            uint64_t value;
+            [[maybe_unused]] ssize_t n = ::read(m_wakeFd, &value, sizeof(value));
+        }
+        if (m_stopping) {
+            break;
+        }
+        
+        // Requests made from here on are served by the next round
+        uint64_t serial;
+        bool discard;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            serial = m_requestSerial;
+            discard = m_discardSerial > m_servedSerial;
+        }
+        
+        const bool open = readSocket(buffer);
+        if (discard) {
+            buffer.clear();
+        }
+        
+        size_t offset = 0;
+        size_t newline;
+        uint32_t ignored = 0;
+        while ((newline = buffer.find('\n', offset)) != std::string::npos) {
+            const std::string_view line(buffer.data() + offset, newline - offset);
+            offset = newline + 1;
+            if (line.empty()) {
+                continue;
+            }
+            m_lines.fetch_add(1, std::memory_order_relaxed);
+            
+            // Lines we have no use for are accounted to the next record
+            records.emplace_back();
+            if (!parseEventLine(line, records.back())) {
+                records.pop_back();
+                ignored++;
+                continue;
+            }
+            records.back().lines += ignored;
+            ignored = 0;
+        }
+        buffer.erase(0, offset);
+        
+        if (ignored > 0) {
+            // Or to the last one, or to a record standing in for them
+            if (records.empty()) {
+                records.emplace_back(EventRecord());
+            }
+            records.back().lines += ignored;
+        }
+        publish(records);
+        
+        if (!open) {
+            m_closed.store(true, std::memory_order_release);
+            notify();
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_servedSerial = serial;
+        }
+        m_served.notify_all();
+        if (!open) {
+            break;
+        }
+    }
+}
+
+bool EventReader::readSocket(std::string &buffer)
+{
+    const size_t before = buffer.size();
+    char chunk[8192];
+    while (true) {
+        const ssize_t n = ::read(m_socketFd, chunk, sizeof(chunk));
+        if (n > 0) {
+            buffer.append(chunk, static_cast<size_t>(n));
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        
+        const uint64_t burst = buffer.size() - before;
+        if (burst > m_maxBuffered.load(std::memory_order_relaxed)) {
+            m_maxBuffered.store(burst, std::memory_order_relaxed);
+        }
+        return n < 0 && errno == EAGAIN;
+    }
+}
+
+void EventReader::publish(std::vector<EventRecord> &records)
+{
+    if (records.empty()) {
+        return;
+    }
+    
+    const size_t parsed = records.size();
+    coalesceEvents(records);
+    m_coalesced.fetch_add(parsed - records.size(), std::memory_order_relaxed);
+    
+    // A full ring means the consumer fell behind; what does not fit is lost
+    // and counted, never waited for
+    for (const EventRecord &record : records) {
+        if (!m_ring.push(record)) {
+            m_overflows.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    records.clear();
+    
+    const uint64_t queued = m_ring.size();
+    if (queued > m_maxQueued.load(std::memory_order_relaxed)) {
+        m_maxQueued.store(queued, std::memory_order_relaxed);
+    }
+    notify();
+}
+
+void EventReader::notify()
+{
+    // One wakeup per drain of the consumer, not one per burst
+    if (!m_notified.exchange(true, std::memory_order_acq_rel)) {
+        const uint64_t one = 1;
+        [[maybe_unused]] ssize_t n = ::write(m_notifyFd, &one, sizeof(one));
+    }
+}
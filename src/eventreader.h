@@ -0,0 +1,153 @@
+#ifndef EVENTREADER_H
+#define EVENTREADER_H
+
+// Reads Hyprland's event socket (.socket2.sock) on a thread of its own, so
+// a burst of events is taken off the socket at once even while the thread
+// that owns the model is busy, and the compositor never waits on us.
+//
+// The reader parses every line into a fixed-size EventRecord and hands it
+// over through a bounded SPSC ring. Within a burst it drops what a consumer
+// would overwrite anyway: earlier titles of a window that is retitled later
+// in the burst, and repeats of the same event. When the ring is full
+// records are dropped and counted; the model is stale from then on and the
+// consumer has to reload it.
+//
+// The consumer watches notifyFd() (QSocketNotifier or poll) and pops until
+// the ring is empty.
+//
+// Plain C++ so the benchmarks can use it without Qt.
+
+#include "spscring.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Only the events the state mirror applies; anything else is counted and
+// dropped on the reader thread
+enum class EventType : uint8_t {
+    None,               // Stands in for lines that were dropped
+    ActiveWindow,       // activewindowv2: address, 0 for none
+    OpenWindow,         // openwindow: address; workspace name, class, title
+    CloseWindow,        // closewindow: address
+    MoveWindow,         // movewindowv2: address, workspace id
+    FloatingMode,       // changefloatingmode: address, flag
+    WindowTitle,        // windowtitlev2: address; title
+    Workspace,          // workspacev2: workspace id
+    FocusedMonitor,     // focusedmonv2: workspace id; monitor name
+    FocusedMonitorByName, // focusedmon: monitor name, workspace name
+    CreateWorkspace,    // createworkspacev2: workspace id; workspace name
+    DestroyWorkspace,   // destroyworkspacev2: workspace id
+    MoveWorkspace,      // moveworkspacev2: workspace id; workspace name, monitor name
+    MonitorRemoved,     // monitorremoved: monitor name
+    MonitorsChanged     // monitoradded, monitoraddedv2, configreloaded
+};
+
+const char *eventTypeName(EventType type);
+
+struct EventRecord {
+    static constexpr size_t TextCapacity = 236;
+    
+    uint64_t address;       // Window, 0 if none
+    int32_t workspaceId;
+    uint32_t lines;         // Event lines this record accounts for, itself included
+    EventType type;
+    uint8_t flag;           // changefloatingmode: 1 when floating
+    uint16_t textSize;
+    char text[TextCapacity];  // String fields, each ended by a NUL; long titles are cut
+    
+    // String field by position, empty past the last one
+    std::string_view field(int index) const;
+};
+
+static_assert(sizeof(EventRecord) == 256, "records are meant to fill four cache lines");
+
+// Parse one line without the newline. False for lines the state mirror has
+// no use for.
+bool parseEventLine(std::string_view line, EventRecord &record);
+
+// Coalesce a burst in place, keeping the order of what remains
+void coalesceEvents(std::vector<EventRecord> &records);
+
+class EventReader
+{
+public:
+    struct Stats {
+        uint64_t lines = 0;             // Lines read off the socket
+        uint64_t coalesced = 0;         // Records folded into a later one
+        uint64_t overflows = 0;         // Records dropped on a full ring
+        uint64_t maxQueued = 0;         // Most records waiting at once
+        uint64_t maxBuffered = 0;       // Largest burst read in one go, bytes
+    };
+    
+    EventReader();
+    ~EventReader();
+    
+    EventReader(const EventReader &) = delete;
+    EventReader &operator=(const EventReader &) = delete;
+    
+    // Take over a connected event socket and start the thread; the socket is
+    // closed by stop()
+    bool start(int socketFd);
+    void stop();
+    bool isRunning() const { return m_thread.joinable(); }
+    
+    // Readable while records may be waiting
+    int notifyFd() const { return m_notifyFd; }
+    
+    // Consumer side: rearm notifyFd(), then pop until empty
+    void clearNotification();
+    bool pop(EventRecord &record) { return m_ring.pop(record); }
+    
+    // Wait until the reader has read everything Hyprland wrote so far, so
+    // the next pops include it. False if the reader did not answer in time.
+    bool catchUp(int timeoutMs);
+    
+    // Drop every queued record, any partial line and whatever is still
+    // unread on the socket; events from then on are delivered again
+    bool discardQueued(int timeoutMs);
+    
+    // Hyprland closed the socket; the records before that remain poppable
+    bool isClosed() const { return m_closed.load(std::memory_order_acquire); }
+    
+    Stats stats() const;
+    
+private:
+    static constexpr size_t RingCapacity = 4096;
+    
+    void run();
+    bool request(bool discard, int timeoutMs);
+    bool readSocket(std::string &buffer);
+    void publish(std::vector<EventRecord> &records);
+    void notify();
+    
+    int m_socketFd;
+    int m_notifyFd;         // eventfd the reader signals the consumer with
+    int m_wakeFd;           // eventfd the consumer wakes the reader with
+    std::thread m_thread;
+    std::atomic<bool> m_stopping;
+    std::atomic<bool> m_closed;
+    std::atomic<bool> m_notified;
+    
+    // catchUp() and discardQueued() requests, served in order
+    std::mutex m_mutex;
+    std::condition_variable m_served;
+    uint64_t m_requestSerial;
+    uint64_t m_discardSerial;
+    uint64_t m_servedSerial;
+    
+    std::atomic<uint64_t> m_lines;
+    std::atomic<uint64_t> m_coalesced;
+    std::atomic<uint64_t> m_overflows;
+    std::atomic<uint64_t> m_maxQueued;
+    std::atomic<uint64_t> m_maxBuffered;
+    
+    SpscRing<EventRecord, RingCapacity> m_ring;
+};
+
+#endif // EVENTREADER_H
@@ -0,0 +1,423 @@
+#include "flightrecorder.h"
+#include "daemonprotocol.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+const uint32_t Magic = 0x31524648;      // "HFR1"
+const uint32_t LayoutVersion = 1;
+
+// A power of two, so the 32-bit record counter wraps onto the same slot
+const uint32_t SlotCount = 4096;
+
+const size_t RecordWords = (sizeof(FlightRecord) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+static_assert(std::is_trivially_copyable<FlightRecord>::value, "records are copied word by word");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "the ring needs lock-free atomics");
+
+// Shared between processes, so only 32-bit atomics, as in the state snapshot
+struct Slot {
+    std::atomic<uint32_t> sequence;     // 2 * index + 1 while written, 2 * index + 2 once complete
+    std::atomic<uint32_t> words[RecordWords];
+};
+
+struct Ring {
+    std::atomic<uint32_t> magic;
+    std::atomic<uint32_t> version;
+    std::atomic<uint32_t> recordSize;
+    std::atomic<uint32_t> next;         // Index of the next record
+    Slot slots[SlotCount];
+};
+
+Ring *g_ring = nullptr;
+std::atomic<bool> g_opened{false};
+
+// Written once before the handlers go in, read from them
+char g_dumpPath[512];
+
+const int FatalSignals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+
+// Appends to a fixed buffer and flushes it with write(): usable in a signal
+// handler, where stdio and allocation are not
+class Writer
+{
+public:
+    explicit Writer(int fd) : m_fd(fd), m_length(0), m_ok(true) {}
+    
+    void text(const char *s) { raw(s, strlen(s)); }
+    
+    void raw(const char *s, size_t length)
+    {
+        for (size_t i = 0; i < length; ++i) {
+            if (m_length == sizeof(m_buffer)) {
+                flush();
+            }
+            m_buffer[m_length++] = s[i];
+        }
+    }
+    
+    // A JSON string from a field that may lack its terminator
+    void string(const char *s, size_t capacity)
+    {
+        static const char hex[] = "0123456789abcdef";
+        raw("\"", 1);
+        for (size_t i = 0; i < capacity && s[i]; ++i) {
+            const unsigned char c = static_cast<unsigned char>(s[i]);
+            if (c == '"' || c == '\\') {
+                const char escaped[2] = {'\\', static_cast<char>(c)};
+                raw(escaped, 2);
+            } else if (c < 0x20) {
+                const char escaped[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 15]};
+                raw(escaped, 6);
+            } else {
+                raw(reinterpret_cast<const char *>(&c), 1);
+            }
+        }
+        raw("\"", 1);
+    }
+    
+    void number(int64_t value)
+    {
+        char digits[24];
+        int length = 0;
+        uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+        do {
+            digits[sizeof(digits) - 1 - length++] = static_cast<char>('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude);
+        if (value < 0) {
+            digits[sizeof(digits) - 1 - length++] = '-';
+        }
+        raw(digits + sizeof(digits) - length, static_cast<size_t>(length));
+    }
+    
+    void address(uint64_t value)
+    {
+        static const char hex[] = "0123456789abcdef";
+        char digits[18] = {'"', '0', 'x'};
+        int length = 3;
+        bool leading = true;
+        for (int shift = 60; shift >= 0; shift -= 4) {
+            const int nibble = static_cast<int>((value >> shift) & 15);
+            if (nibble || !leading || shift == 0) {
+                digits[length++] = hex[nibble];
+                leading = false;
+            }
+        }
+        raw(digits, static_cast<size_t>(length));
+        raw("\"", 1);
+    }
+    
+    bool flush()
+    {
+        size_t written = 0;
+        while (m_ok && written < m_length) {
+            ssize_t n = ::write(m_fd, m_buffer + written, m_length - written);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            m_ok = n > 0;
+            written += n > 0 ? static_cast<size_t>(n) : 0;
+        }
+        m_length = 0;
+        return m_ok;
+    }
+    
+private:
+    int m_fd;
+    char m_buffer[4096];
+    size_t m_length;
+    bool m_ok;
+};
+
+const char *outcomeName(int32_t outcome)
+{
+    switch (outcome) {
+    case FlightRecord::Placed: return "placed";
+    case FlightRecord::OffTarget: return "off target";
+    case FlightRecord::Failed: return "failed";
+    case FlightRecord::Cancelled: return "cancelled";
+    }
+    return "unfinished";
+}
+
+void writeRecord(Writer &out, const FlightRecord &r)
+{
+    static const char *const steps[FlightRecord::StepCount] = {"capture", "dispatch", "verify", "notify", "total"};
+    
+    out.text("{\"timeUs\":");
+    out.number(r.timeUs);
+    out.text(",\"pid\":");
+    out.number(r.pid);
+    out.text(",\"preset\":");
+    out.string(r.preset, sizeof(r.preset));
+    out.text(",\"code\":");
+    out.string(r.code, sizeof(r.code));
+    out.text(",\"outcome\":\"");
+    out.text(outcomeName(r.outcome));
+    out.text("\",\"window\":");
+    out.address(r.windowAddress);
+    out.text(r.windowFloating ? ",\"floating\":true" : ",\"floating\":false");
+    out.text(",\"workspace\":");
+    out.number(r.workspaceId);
+    out.text(",\"workspaceWindows\":");
+    out.number(r.workspaceWindowCount);
+    out.text(r.monitorCached ? ",\"monitorCached\":true" : ",\"monitorCached\":false");
+    out.text(",\"screen\":{\"width\":");
+    out.number(r.screenWidth);
+    out.text(",\"height\":");
+    out.number(r.screenHeight);
+    out.text(",\"reserved\":[");
+    out.number(r.reservedTop);
+    out.text(",");
+    out.number(r.reservedBottom);
+    out.text(",");
+    out.number(r.reservedLeft);
+    out.text(",");
+    out.number(r.reservedRight);
+    out.text("],\"scaleMilli\":");
+    out.number(r.scaleMilli);
+    out.text("},\"target\":{\"x\":");
+    out.number(r.targetX);
+    out.text(",\"y\":");
+    out.number(r.targetY);
+    out.text(",\"width\":");
+    out.number(r.targetWidth);
+    out.text(",\"height\":");
+    out.number(r.targetHeight);
+    out.text("},\"attempts\":");
+    out.number(r.attempts);
+    out.text(",\"stepsUs\":{");
+    for (int step = 0; step < FlightRecord::StepCount; ++step) {
+        out.text(step ? ",\"" : "\"");
+        out.text(steps[step]);
+        out.text("\":");
+        out.number(r.stepUs[step]);
+    }
+    out.text("},\"commands\":");
+    out.string(r.commands, sizeof(r.commands));
+    out.text(",\"replies\":");
+    out.string(r.replies, sizeof(r.replies));
+    out.text("}\n");
+}
+
+// Copy `text` into a fixed field, cutting it with "..." when it does not fit
+template <size_t N>
+void appendField(char (&field)[N], const char *text, size_t length)
+{
+    size_t used = strnlen(field, N);
+    if (used + 1 >= N) {
+        return;
+    }
+    const size_t room = N - 1 - used;
+    if (length <= room) {
+        memcpy(field + used, text, length);
+        field[used + length] = '\0';
+        return;
+    }
+    memcpy(field + used, text, room);
+    memcpy(field + N - 4, "...", 4);
+}
+
+void dumpToPath()
+{
+    if (!g_dumpPath[0] || !g_ring) {
+        return;
+    }
+    int fd = ::open(g_dumpPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd >= 0) {
+        FlightRecorder::dump(fd);
+        ::close(fd);
+    }
+}
+
+void onDumpSignal(int)
+{
+    const int savedErrno = errno;
+    dumpToPath();
+    errno = savedErrno;
+}
+
+void onFatalSignal(int signal)
+{
+    // SA_RESETHAND restored the default action; raising again ends the
+    // process the way the signal would have
+    dumpToPath();
+    ::raise(signal);
+}
+
+} // namespace
+
+FlightRecord FlightRecord::start()
+{
+    FlightRecord record;
+    memset(&record, 0, sizeof(record));
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    record.timeUs = static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+    record.startUs = FlightRecorder::now();
+    record.pid = static_cast<int32_t>(::getpid());
+    return record;
+}
+
+void FlightRecord::setLabel(const char *presetName, const char *positionCode)
+{
+    strncpy(preset, presetName, sizeof(preset) - 1);
+    strncpy(code, positionCode, sizeof(code) - 1);
+}
+
+void FlightRecord::appendRequest(const char *command, size_t length, const char *statuses)
+{
+    if (commands[0]) {
+        appendField(commands, " | ", 3);
+    }
+    appendField(commands, command, length);
+    if (replies[0]) {
+        appendField(replies, " | ", 3);
+    }
+    appendField(replies, statuses, strlen(statuses));
+}
+
+void FlightRecord::endStep(Step step, int64_t sinceUs)
+{
+    // A step can run more than once, when an apply revalidates and re-applies
+    const int64_t elapsed = FlightRecorder::now() - sinceUs;
+    const int64_t total = static_cast<int64_t>(stepUs[step]) + (elapsed < 0 ? 0 : elapsed);
+    stepUs[step] = static_cast<uint32_t>(total > UINT32_MAX ? UINT32_MAX : total);
+}
+
+namespace FlightRecorder {
+
+int64_t now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+bool open()
+{
+    return open(DaemonProtocol::runtimeFilePath(".recent"));
+}
+
+bool open(const std::string &path)
+{
+    if (g_opened.exchange(true)) {
+        return g_ring != nullptr;
+    }
+    
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return false;
+    }
+    
+    // Another layout is started over; one of the same size is kept as is
+    struct stat info;
+    bool ok = ::fstat(fd, &info) == 0;
+    if (ok && info.st_size != static_cast<off_t>(sizeof(Ring))) {
+        ok = ::ftruncate(fd, 0) == 0 && ::ftruncate(fd, sizeof(Ring)) == 0;
+    }
+    void *mapping = ok ? ::mmap(nullptr, sizeof(Ring), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    
+    Ring *ring = static_cast<Ring *>(mapping);
+    if (ring->magic.load(std::memory_order_acquire) != Magic ||
+        ring->version.load(std::memory_order_relaxed) != LayoutVersion ||
+        ring->recordSize.load(std::memory_order_relaxed) != sizeof(FlightRecord)) {
+        // Fresh or foreign: every slot reads as never written
+        memset(static_cast<void *>(ring), 0, sizeof(Ring));
+        ring->version.store(LayoutVersion, std::memory_order_relaxed);
+        ring->recordSize.store(sizeof(FlightRecord), std::memory_order_relaxed);
+        ring->magic.store(Magic, std::memory_order_release);
+    }
+    g_ring = ring;
+    return true;
+}
+
+void record(const FlightRecord &record)
+{
+    if (!g_ring) {
+        return;
+    }
+    
+    uint32_t words[RecordWords] = {};
+    memcpy(words, &record, sizeof(record));
+    
+    const uint32_t index = g_ring->next.fetch_add(1, std::memory_order_relaxed);
+    Slot &slot = g_ring->slots[index % SlotCount];
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < RecordWords; ++i) {
+        slot.words[i].store(words[i], std::memory_order_relaxed);
+    }
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+}
+
+bool dump(int fd)
+{
+    if (!g_ring) {
+        return false;
+    }
+    
+    Writer out(fd);
+    const uint32_t next = g_ring->next.load(std::memory_order_acquire);
+    const uint32_t count = next < SlotCount ? next : SlotCount;
+    for (uint32_t index = next - count; index != next; ++index) {
+        const Slot &slot = g_ring->slots[index % SlotCount];
+        
+        // Skip records being written, or overwritten while we read them
+        uint32_t words[RecordWords];
+        if (slot.sequence.load(std::memory_order_acquire) != 2 * index + 2) {
+            continue;
+        }
+        for (size_t i = 0; i < RecordWords; ++i) {
+            words[i] = slot.words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != 2 * index + 2) {
+            continue;
+        }
+        
+        FlightRecord record;
+        memcpy(&record, words, sizeof(record));
+        writeRecord(out, record);
+    }
+    return out.flush();
+}
+
+void installSignalHandlers(const std::string &dumpPath)
+{
+    if (dumpPath.size() >= sizeof(g_dumpPath)) {
+        return;
+    }
+    memcpy(g_dumpPath, dumpPath.c_str(), dumpPath.size() + 1);
+    
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    sigemptyset(&action.sa_mask);
+    action.sa_handler = onDumpSignal;
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &action, nullptr);
+    
+    action.sa_handler = onFatalSignal;
+    action.sa_flags = SA_RESETHAND | SA_NODEFER;
+    for (int signal : FatalSignals) {
+        sigaction(signal, &action, nullptr);
+    }
+}
+
+} // namespace FlightRecorder
@@ -0,0 +1,106 @@
+#ifndef FLIGHTRECORDER_H
+#define FLIGHTRECORDER_H
+
+// Flight recorder of recent placements, to find out afterwards why one went
+// wrong. Every process appends to one ring of fixed-size records in the
+// runtime directory that all of them map, so one-shot runs and the daemon
+// share a history that outlives them, crashes included. A writer claims a
+// slot with one atomic increment and guards it with a per-slot sequence;
+// recording an apply is a copy of a few hundred bytes.
+//
+// The ring is written out as JSON lines, oldest first, by
+// `hypr-grid-manager --dump-recent`, and by a process that gets SIGUSR1 or
+// crashes. Dumping uses async-signal-safe calls only.
+//
+// Plain C++ so the benchmarks can use it without Qt.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct FlightRecord {
+    enum Outcome : int32_t {
+        Unfinished,     // Returned before a placement was tried
+        Placed,
+        OffTarget,      // Placed, but verification found it elsewhere
+        Failed,
+        Cancelled
+    };
+    
+    enum Step {
+        Capture,        // Querying the context
+        Dispatch,       // First placement, fallback included
+        Verify,         // Read-backs and retries
+        Notify,
+        Total,
+        StepCount
+    };
+    
+    int64_t timeUs;                 // CLOCK_REALTIME at the start
+    int64_t startUs;                // Monotonic, for the step durations
+    int32_t pid;
+    int32_t outcome;
+    char preset[24];
+    char code[16];
+    
+    // Context the apply worked from
+    uint64_t windowAddress;
+    int32_t windowFloating;
+    int32_t workspaceId;
+    int32_t workspaceWindowCount;
+    int32_t monitorCached;
+    int32_t screenWidth;
+    int32_t screenHeight;
+    int32_t reservedTop;
+    int32_t reservedBottom;
+    int32_t reservedLeft;
+    int32_t reservedRight;
+    int32_t scaleMilli;
+    
+    // Computed PixelPosition
+    int32_t targetX;
+    int32_t targetY;
+    int32_t targetWidth;
+    int32_t targetHeight;
+    
+    int32_t attempts;
+    uint32_t stepUs[StepCount];
+    
+    // Requests in order, " | " between requests and ";" inside a batch,
+    // with the reply status of each command; cut with "..." when full
+    char commands[240];
+    char replies[64];
+    
+    // Zeroed, stamped with the current time and pid
+    static FlightRecord start();
+    
+    void setLabel(const char *presetName, const char *positionCode);
+    void appendRequest(const char *command, size_t length, const char *statuses);
+    
+    // Add the time since `sinceUs` (FlightRecorder::now()) to `step`
+    void endStep(Step step, int64_t sinceUs);
+};
+
+namespace FlightRecorder {
+
+// Monotonic microseconds, the clock of FlightRecord::startUs
+int64_t now();
+
+// Map the ring, by default hypr-grid-manager[-<signature>].recent in the
+// runtime directory. Later calls do nothing; false leaves recording off.
+bool open();
+bool open(const std::string &path);
+
+void record(const FlightRecord &record);
+
+// Write the ring as JSON lines, oldest first; async-signal-safe
+bool dump(int fd);
+
+// SIGUSR1 dumps to `dumpPath` and carries on. A fatal signal (SIGSEGV,
+// SIGBUS, SIGFPE, SIGILL, SIGABRT, qFatal included) dumps there too, then
+// terminates the process as it would have.
+void installSignalHandlers(const std::string &dumpPath);
+
+} // namespace FlightRecorder
+
+#endif // FLIGHTRECORDER_H
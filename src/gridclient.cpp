@@ -0,0 +1,196 @@
+// hypr-grid-client: forwards one placement to a running
+// `hypr-grid-manager --daemon` and exits. It links no Qt, so a keybinding
+// costs one process exec, a connect and a two-line exchange.
+//
+// Usage:
+//   hypr-grid-client <preset>:<position>
+//   hypr-grid-client <preset> <position>
+//   hypr-grid-client reset
+//   hypr-grid-client stats     apply queue counters
+//   hypr-grid-client metrics [json]
+//                              daemon metrics, Prometheus text or JSON
+//
+// Without a running daemon it execs `hypr-grid-manager` with the same request.
+
+#include "applyqueue.h"
+#include "daemonprotocol.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <string>
+
+namespace {
+
+long long monotonicMs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<long long>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+int connectDaemon()
+{
+    const std::string path = DaemonProtocol::socketPath();
+    
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        return -1;
+    }
+    memcpy(addr.sun_path, path.c_str(), path.size());
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool writeAll(int fd, const std::string &data)
+{
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = write(fd, data.data() + written, data.size() - written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        written += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Read one reply line, or with `untilClose` everything up to the end of
+// the connection, bounded by the protocol timeout
+bool readReply(int fd, std::string &reply, bool untilClose = false)
+{
+    const long long deadline = monotonicMs() + DaemonProtocol::TimeoutMs;
+    char buffer[DaemonProtocol::MaxRequestSize];
+    
+    while (untilClose || reply.find('\n') == std::string::npos) {
+        long long remaining = deadline - monotonicMs();
+        if (remaining <= 0) {
+            return false;
+        }
+        
+        pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        int ready = poll(&pfd, 1, static_cast<int>(remaining));
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready <= 0) {
+            return false;
+        }
+        
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        reply.append(buffer, static_cast<size_t>(n));
+    }
+    
+    size_t newline = reply.find('\n');
+    if (newline != std::string::npos && !untilClose) {
+        reply.resize(newline);
+    }
+    return !reply.empty();
+}
+
+int usage(const char *program)
+{
+    fprintf(stderr, "Usage: %s <preset>:<position> | <preset> <position> | reset | stats | metrics [json]\n",
+            program);
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::string target;
+    if (argc >= 2 && strcmp(argv[1], "metrics") == 0) {
+        if (argc > 3 || (argc == 3 && strcmp(argv[2], "json") != 0)) {
+            return usage(argv[0]);
+        }
+        target = argc == 3 ? "metrics json" : "metrics";
+    } else if (argc == 2) {
+        target = argv[1];
+    } else if (argc == 3) {
+        target = std::string(argv[1]) + ":" + argv[2];
+    } else {
+        return usage(argv[0]);
+    }
+    
+    bool reset = target == "reset";
+    bool stats = target == "stats";
+    bool metrics = target.compare(0, 7, "metrics") == 0;
+    if (!reset && !stats && !metrics && target.find(':') == std::string::npos) {
+        return usage(argv[0]);
+    }
+    
+    int fd = connectDaemon();
+    if (fd < 0) {
+        // No daemon running, do the work in a regular process instead
+        if (metrics) {
+            fprintf(stderr, "hypr-grid-client: metrics are only kept by a running daemon\n");
+            return 1;
+        }
+        if (stats) {
+            ApplyQueue queue;
+            printf("%s\n", ApplyQueue::formatStats(queue.stats()).c_str());
+            return queue.isOpen() ? 0 : 1;
+        }
+        if (reset) {
+            execlp("hypr-grid-manager", "hypr-grid-manager", "--reset", static_cast<char *>(nullptr));
+        } else {
+            execlp("hypr-grid-manager", "hypr-grid-manager", "--apply", target.c_str(), static_cast<char *>(nullptr));
+        }
+        perror("hypr-grid-client: cannot reach daemon or exec hypr-grid-manager");
+        return 1;
+    }
+    
+    std::string request = reset || stats || metrics ? target + "\n" : "apply " + target + "\n";
+    std::string reply;
+    bool delivered = writeAll(fd, request) && readReply(fd, reply, metrics);
+    close(fd);
+    
+    if (!delivered) {
+        fprintf(stderr, "hypr-grid-client: no reply from daemon\n");
+        return 1;
+    }
+    
+    if (metrics && reply.compare(0, 3, "ok\n") == 0) {
+        fputs(reply.c_str() + 3, stdout);
+        return 0;
+    }
+    if (reply == DaemonProtocol::ReplyOk) {
+        return 0;
+    }
+    if (stats && reply.compare(0, 3, "ok ") == 0) {
+        printf("%s\n", reply.c_str() + 3);
+        return 0;
+    }
+    
+    fprintf(stderr, "hypr-grid-client: %s\n", reply.c_str());
+    return 1;
+}
@@ -1,27 +1,42 @@
 #include "gridmanager.h"
+#include "daemonprotocol.h"
+#include "trace.h"
+#include "metrics.h"
+#include "flightrecorder.h"
 #include <QDebug>
-#include <QProcess>
 #include <QJsonDocument>
 #include <QThread>
 #include <QDir>
 #include <QStandardPaths>
+#include <QRandomGenerator>
+#include <cmath>
 #include <iostream>
 
 GridManager::GridManager(QObject *parent)
-    : QObject(parent), m_hyprland(nullptr), m_config(nullptr)
+    : QObject(parent), m_hyprland(nullptr), m_state(nullptr), m_config(nullptr)
 {
     // Constructor will be completed in initialize()
+    
+    // Apply latency comes from the signal, so the metric and any listener
+    // see the same placements
+    connect(this, &GridManager::gridPositionApplied, this,
+            [](const QString &preset, const QString &, qint64 elapsedUs) {
+        Metrics::observe("hypr_grid_apply_duration_seconds", elapsedUs, "preset",
+                         Metrics::enabled() ? preset.toStdString() : std::string());
+    });
 }
 
 GridManager::~GridManager()
 {
     delete m_hyprland;
+    delete m_state;
     delete m_config;
 }
 
 bool GridManager::initialize()
 {
     std::cout << "[DEBUG] GridManager::initialize() called" << std::endl;
+    TRACE_SPAN("init", "init");
     
     // Initialize configuration first
     m_config = new Config(this);
@@ -33,21 +48,141 @@ bool GridManager::initialize()
     std::cout << "[INFO] Configuration loaded successfully" << std::endl;
     logInfo("Grid Manager initializing");
     
-    // Initialize Hyprland API
+    // Hyprland is connected lazily by ensureHyprland(), so modes that never
+    // talk to it (printing the config, --help) do not pay for it
     m_hyprland = new HyprlandAPI(this);
     connect(m_hyprland, &HyprlandAPI::errorOccurred, this, &GridManager::errorOccurred);
     
+    logInfo("Grid Manager initialized successfully");
+    return true;
+}
+
+class GridManager::DeadlineScope
+{
+public:
+    DeadlineScope(GridManager *manager, const char *what)
+        : m_manager(manager), m_what(what), m_owner(!manager->m_hyprland->deadline().isSet())
+    {
+        // An apply that re-enters itself keeps the deadline it started with
+        int budgetMs = manager->m_config->getAdvancedConfig().value("applyBudgetMs", 2000).toInt();
+        if (m_owner && budgetMs > 0) {
+            manager->m_hyprland->setDeadline(Deadline::in(budgetMs));
+        }
+    }
+    
+    ~DeadlineScope()
+    {
+        const Deadline deadline = m_manager->m_hyprland->deadline();
+        if (!m_owner || !deadline.isSet()) {
+            return;
+        }
+        if (deadline.expired()) {
+            m_manager->m_placementStats.overBudget++;
+            Metrics::count("hypr_grid_apply_over_budget_total");
+            m_manager->logWarning(QString("%1 ran out of its %2 ms budget").arg(m_what).arg(deadline.budgetMs()));
+        } else {
+            m_manager->logDebug(QString("%1 used %2 of %3 ms budget")
+                .arg(m_what).arg(deadline.elapsedMs()).arg(deadline.budgetMs()));
+        }
+        m_manager->m_hyprland->setDeadline(Deadline());
+    }
+    
+private:
+    GridManager *m_manager;
+    const char *m_what;
+    bool m_owner;
+};
+
+class GridManager::RecordScope
+{
+public:
+    explicit RecordScope(GridManager *manager)
+        : m_manager(manager), m_record(FlightRecord::start()), m_previous(manager->m_hyprland->flightRecord())
+    {
+        // An apply that re-enters itself adds to the record it started
+        if (m_previous) {
+            return;
+        }
+        FlightRecorder::open();
+        m_record.setLabel(manager->m_applyPreset.toUtf8().constData(), manager->m_applyCode.toUtf8().constData());
+        manager->m_hyprland->setFlightRecord(&m_record);
+    }
+    
+    ~RecordScope()
+    {
+        if (m_previous) {
+            return;
+        }
+        m_record.endStep(FlightRecord::Total, m_record.startUs);
+        m_manager->m_hyprland->setFlightRecord(nullptr);
+        FlightRecorder::record(m_record);
+    }
+    
+    bool isOwner() const { return !m_previous; }
+    FlightRecord &record() { return m_previous ? *m_previous : m_record; }
+    
+private:
+    GridManager *m_manager;
+    FlightRecord m_record;
+    FlightRecord *m_previous;
+};
+
+bool GridManager::ensureHyprland()
+{
+    if (m_hyprland->isInitialized()) {
+        return true;
+    }
+    
+    const QVariantMap advanced = m_config->getAdvancedConfig();
+    m_hyprland->configureBreaker(advanced.value("breakerThreshold", 3).toInt(),
+                                 advanced.value("breakerCooldownMs", 5000).toInt());
     if (!m_hyprland->initialize()) {
         logError("Failed to initialize Hyprland API");
         return false;
     }
+    return true;
+}
+
+bool GridManager::enableStateMirror()
+{
+    // Only worth it for long-lived processes; one-shot CLI calls query directly
+    if (m_state) {
+        return m_state->isSynced();
+    }
+    if (!ensureHyprland()) {
+        return false;
+    }
     
-    logInfo("Grid Manager initialized successfully");
+    m_state = new HyprlandState(m_hyprland, this);
+    if (!m_state->start()) {
+        logWarning("Hyprland state mirror unavailable, falling back to per-apply queries");
+        delete m_state;
+        m_state = nullptr;
+        return false;
+    }
+    
+    m_hyprland->setStateMirror(m_state);
+    logInfo("Hyprland state mirror enabled");
     return true;
 }
 
-bool GridManager::applyPositionByCode(const QString &preset, const QString &code)
+bool GridManager::publishStateSnapshot()
 {
+    // Lets one-shot invocations skip their state query while we run
+    if (!m_state) {
+        return false;
+    }
+    return m_state->publishSnapshot(DaemonProtocol::runtimeFilePath(".state"));
+}
+
+bool GridManager::applyPositionByCode(const QString &preset, const QString &code,
+                                      const std::optional<ApplyContext> &context)
+{
+    Trace::Span span("apply", "apply");
+    if (span.active()) {
+        span.setDetail((preset + ":" + code).toStdString());
+    }
+    
     std::cout << "[INFO] Applying position " << code.toStdString() << " from preset " << preset.toStdString() << std::endl;
     logInfo(QString("Applying position %1 from preset %2").arg(code).arg(preset));
     
@@ -78,27 +213,152 @@ bool GridManager::applyPositionByCode(const QString &preset, const QString &code
     
     std::cout << "[DEBUG] Found position: x=" << position.x << " y=" << position.y << " w=" << position.width << " h=" << position.height << std::endl;
     
+    m_applyPreset = preset;
+    m_applyCode = code;
+    m_applyContext = context;
     bool result = applyGridPosition(position);
+    m_applyPreset.clear();
+    m_applyCode.clear();
+    m_applyContext.reset();
+    if (!result) {
+        Metrics::count("hypr_grid_apply_failures_total", "preset", preset.toStdString());
+    }
     std::cout << "[DEBUG] applyPositionByCode returning: " << (result ? "true" : "false") << std::endl;
     return result;
 }
 
+ApplyQueue::Outcome GridManager::runQueuedApply(ApplyQueue &queue, uint64_t ticket, const QString &preset,
+                                                const QString &code, std::function<void()> poll,
+                                                const std::optional<ApplyContext> &context, bool refreshContext)
+{
+    if (!queue.acquire(ticket)) {
+        logInfo(QString("Dropping %1:%2, superseded by a newer request").arg(preset, code));
+        queue.finish(ticket, ApplyQueue::Dropped);
+        return ApplyQueue::Dropped;
+    }
+    
+    // Stop as soon as a newer request for the window shows up
+    std::function<bool()> previous = m_cancellationCheck;
+    bool superseded = false;
+    m_cancellationCheck = [&]() {
+        if (poll) {
+            poll();
+        }
+        superseded = superseded || queue.isSuperseded(ticket);
+        return superseded || (previous && previous());
+    };
+    
+    // An earlier request for the same window has run by now and may have
+    // changed it, floating state included
+    std::optional<ApplyContext> current = context;
+    bool success = true;
+    if (current && refreshContext && !refreshApplyContext(*current)) {
+        logError(QString("Window %1 is gone, dropping %2:%3").arg(current->address, preset, code));
+        success = false;
+    }
+    if (success) {
+        success = applyPositionByCode(preset, code, current);
+    }
+    m_cancellationCheck = previous;
+    
+    ApplyQueue::Outcome outcome = superseded ? ApplyQueue::Cancelled
+                                : success ? ApplyQueue::Applied : ApplyQueue::Failed;
+    queue.finish(ticket, outcome);
+    return outcome;
+}
+
+QString GridManager::focusedWindowAddress()
+{
+    if (!ensureHyprland()) {
+        return QString();
+    }
+    
+    // Not part of whichever apply may be running
+    const Deadline deadline = m_hyprland->deadline();
+    FlightRecord *record = m_hyprland->flightRecord();
+    m_hyprland->setDeadline(Deadline());
+    m_hyprland->setFlightRecord(nullptr);
+    const QString address = m_hyprland->activeWindowAddress();
+    m_hyprland->setDeadline(deadline);
+    m_hyprland->setFlightRecord(record);
+    return address;
+}
+
+bool GridManager::refreshApplyContext(ApplyContext &context)
+{
+    // Still focused: take everything afresh, screen included
+    std::optional<ApplyContext> fresh = captureApplyContext();
+    if (fresh && fresh->address == context.address) {
+        context = *fresh;
+        return true;
+    }
+    
+    // Focus moved on; the request still belongs to its own window
+    WindowInfo window;
+    if (!m_hyprland->getWindowInfo(context.address, window) || !window.valid()) {
+        return false;
+    }
+    context.floating = window.floating;
+    return true;
+}
+
 bool GridManager::applyGridPosition(const GridPosition &position)
 {
     std::cout << "[DEBUG] applyGridPosition called" << std::endl;
     
-    // Get screen dimensions
-    Screen screen = getScreenDimensions();
-    if (screen.width <= 0 || screen.height <= 0) {
-        std::cout << "[ERROR] Invalid screen dimensions: " << screen.width << "x" << screen.height << std::endl;
-        logError("Invalid screen dimensions");
+    if (isCancelled()) {
+        logInfo("Apply cancelled before it started");
+        return false;
+    }
+    
+    DeadlineScope deadline(this, "Apply");
+    RecordScope recording(this);
+    FlightRecord &record = recording.record();
+    m_lastPlacement = PlacementTarget();
+    if (!ensureHyprland()) {
         return false;
     }
     
+    // Capture the target once, or take the one the request was queued under;
+    // nothing below queries the focused window again. A revalidating
+    // re-apply captures afresh.
+    int64_t stepStart = FlightRecorder::now();
+    std::optional<ApplyContext> captured = m_applyContext ? m_applyContext : captureApplyContext();
+    m_applyContext.reset();
+    record.endStep(FlightRecord::Capture, stepStart);
+    if (!captured) {
+        return false;
+    }
+    const ApplyContext &context = *captured;
+    const Screen &screen = context.screen;
+    
+    record.windowAddress = HyprlandJson::parseAddress(context.address.toStdString());
+    record.windowFloating = context.floating;
+    record.workspaceId = context.workspaceId;
+    record.workspaceWindowCount = context.workspaceWindowCount;
+    record.monitorCached = context.monitorCached;
+    record.screenWidth = screen.width;
+    record.screenHeight = screen.height;
+    record.reservedTop = screen.reservedTop;
+    record.reservedBottom = screen.reservedBottom;
+    record.reservedLeft = screen.reservedLeft;
+    record.reservedRight = screen.reservedRight;
+    record.scaleMilli = static_cast<int32_t>(std::lround(screen.scale * 1000));
+    
     std::cout << "[DEBUG] Screen dimensions: " << screen.width << "x" << screen.height << std::endl;
     
     // Convert grid position to pixel coordinates
-    PixelPosition pixelPos = gridToPixelPosition(position, screen);
+    PixelPosition pixelPos;
+    {
+        TRACE_SPAN("apply.gridToPixels", "apply");
+        pixelPos = gridToPixelPosition(position, screen);
+    }
+    record.targetX = pixelPos.x;
+    record.targetY = pixelPos.y;
+    record.targetWidth = pixelPos.width;
+    record.targetHeight = pixelPos.height;
+    m_lastPlacement.address = context.address;
+    m_lastPlacement.geometry = pixelPos;
     
     std::cout << "[DEBUG] Converted to pixel position: x=" << pixelPos.x << " y=" << pixelPos.y << " w=" << pixelPos.width << " h=" << pixelPos.height << std::endl;
     
@@ -112,95 +372,247 @@ bool GridManager::applyGridPosition(const GridPosition &position)
     
     // Check if there are multiple windows in the current workspace
     // Tiling only works effectively with multiple windows
-    bool hasMultipleWindows = hasMultipleWindowsInWorkspace();
+    bool hasMultipleWindows = context.workspaceWindowCount > 1;
+    logDebug(QString("Found %1 windows in workspace %2").arg(context.workspaceWindowCount).arg(context.workspaceId));
     
     std::cout << "[DEBUG] hasMultipleWindows: " << (hasMultipleWindows ? "true" : "false") << std::endl;
     
-    if (useTiling && hasMultipleWindows) {
-        // For tiling mode with multiple windows, use tiling commands
-        if (!ensureTiled()) {
-            logWarning("Failed to ensure window is tiled");
-        }
-        
-        // Use Hyprland's tiling commands to position the window
-        if (!m_hyprland->positionTiledWindow(pixelPos.x, pixelPos.y, pixelPos.width, pixelPos.height)) {
-            logError("Failed to position tiled window");
-            return false;
-        }
-    } else {
-        // Use floating mode for precise positioning
-        // This includes: single windows, forced floating, or legacy floating mode
-        if (!hasMultipleWindows) {
-            std::cout << "[DEBUG] Single window detected, using floating mode for precise positioning" << std::endl;
-            logDebug("Single window detected, using floating mode for precise positioning");
-        }
-        
-        if (!ensureFloating()) {
-            std::cout << "[WARNING] Failed to ensure window is floating" << std::endl;
+    // Both modes place the window as floating on the grid for exact control;
+    // the floating toggle, move and resize go out in one batched dispatch
+    if (!hasMultipleWindows) {
+        std::cout << "[DEBUG] Single window detected, using floating mode for precise positioning" << std::endl;
+        logDebug("Single window detected, using floating mode for precise positioning");
+    }
+    
+    // Last point where cancelling leaves the window untouched
+    if (isCancelled()) {
+        logInfo("Apply cancelled before dispatch");
+        record.outcome = FlightRecord::Cancelled;
+        return false;
+    }
+    
+    stepStart = FlightRecorder::now();
+    std::cout << "[DEBUG] Calling applyPlacement with: " << pixelPos.x << "," << pixelPos.y << "," << pixelPos.width << "," << pixelPos.height << std::endl;
+    PlacementResult placement = m_hyprland->applyPlacement(context.address, pixelPos.x, pixelPos.y,
+                                                           pixelPos.width, pixelPos.height, !context.floating);
+    
+    if (!placement.ok() && placement.toggleStatus != IpcStatus::Ok) {
+        // Hyprland rejected the batched toggle, fall back to toggling step by step
+        TRACE_SPAN("apply.fallback", "apply");
+        logWarning("Batched floating toggle failed, retrying step by step");
+        bool floating = (useTiling && hasMultipleWindows) ? ensureTiled(context.address, context.floating)
+                                                          : ensureFloating(context.address, context.floating);
+        if (!floating) {
             logWarning("Failed to ensure window is floating");
-        } else {
-            std::cout << "[DEBUG] Window is now floating" << std::endl;
         }
+        placement.toggleStatus = IpcStatus::Ok;
+        bool moved = m_hyprland->moveAndResizeWindow(context.address, pixelPos.x, pixelPos.y,
+                                                     pixelPos.width, pixelPos.height);
+        placement.moveStatus = placement.resizeStatus = moved ? IpcStatus::Ok : IpcStatus::CommandError;
+    }
+    record.endStep(FlightRecord::Dispatch, stepStart);
+    
+    // Check the result as configured and retry what failed or landed
+    // elsewhere, backing off by Hyprland's measured response time. A
+    // revalidating re-apply counts as another attempt of the same placement.
+    if (recording.isOwner()) {
+        m_placementStats.placements++;
+    }
+    stepStart = FlightRecorder::now();
+    record.attempts++;
+    const bool verify = shouldVerify();
+    bool placed = placement.ok();
+    bool landed = placed && (!verify || verifyPlacement(context.address, pixelPos, true));
+    
+    const QVariantMap advanced = m_config->getAdvancedConfig();
+    int retries = advanced.value("retryOnFailure", true).toBool() ? advanced.value("retryCount", 3).toInt() : 0;
+    for (int attempt = 0; !landed && attempt < retries && !isCancelled() && !m_hyprland->deadline().expired();
+         ++attempt) {
+        int delay = m_hyprland->deadline().remainingMs(retryBackoffMs(attempt));
+        logDebug(QString("Retrying placement in %1 ms (%2 attempts left)").arg(delay).arg(retries - attempt));
+        QThread::msleep(delay);
         
-        // Apply the position using floating window commands
-        std::cout << "[DEBUG] Calling moveAndResizeWindow with: " << pixelPos.x << "," << pixelPos.y << "," << pixelPos.width << "," << pixelPos.height << std::endl;
-        if (!m_hyprland->moveAndResizeWindow(pixelPos.x, pixelPos.y, pixelPos.width, pixelPos.height)) {
-            std::cout << "[ERROR] Failed to move and resize window" << std::endl;
-            logError("Failed to move and resize window");
-            return false;
-        } else {
-            std::cout << "[DEBUG] moveAndResizeWindow returned success" << std::endl;
+        m_placementStats.retries++;
+        record.attempts++;
+        Metrics::count("hypr_grid_placement_retries_total");
+        placed = m_hyprland->moveAndResizeWindow(context.address, pixelPos.x, pixelPos.y,
+                                                 pixelPos.width, pixelPos.height);
+        landed = placed && (!verify || verifyPlacement(context.address, pixelPos, false));
+        if (landed && verify) {
+            m_placementStats.corrected++;
         }
     }
     
+    record.endStep(FlightRecord::Verify, stepStart);
+    m_lastPlacement.attempts = record.attempts;
+    record.outcome = !placed ? FlightRecord::Failed : landed ? FlightRecord::Placed : FlightRecord::OffTarget;
+    
+    // Geometry from the monitor cache is the first suspect when a placement
+    // goes wrong: drop the cache and apply once more with fresh monitors
+    if (!landed && context.monitorCached && !isCancelled() && !m_hyprland->deadline().expired()) {
+        logWarning("Placement went wrong with cached monitors, revalidating");
+        m_hyprland->invalidateMonitorCache();
+        m_placementStats.retries++;
+        Metrics::count("hypr_grid_placement_retries_total");
+        return applyGridPosition(position);
+    }
+    
+    if (!placed) {
+        m_placementStats.failed++;
+        std::cout << "[ERROR] Failed to move and resize window" << std::endl;
+        logError("Failed to move and resize window");
+        return false;
+    }
+    
+    // Hyprland may hold a window off the target for reasons of its own
+    // (minimum sizes, rules); the window was still placed
+    if (!landed) {
+        m_placementStats.offTarget++;
+        logWarning("Window did not land on the target geometry");
+    }
+    
+    std::cout << "[DEBUG] applyPlacement returned success" << std::endl;
+    
     // Show notification if enabled
     if (m_config->getAppearanceConfig()["showNotifications"].toBool()) {
         std::cout << "[DEBUG] Sending notification" << std::endl;
+        TRACE_SPAN("apply.notify", "apply");
+        Metrics::Timer notifyTimer("hypr_grid_notification_duration_seconds");
+        stepStart = FlightRecorder::now();
         m_hyprland->sendNotification(
             "Grid Manager", 
             QString("Applying %1×%2 position").arg(position.width).arg(position.height),
             m_config->getAppearanceConfig()["notificationDuration"].toInt()
         );
+        record.endStep(FlightRecord::Notify, stepStart);
     }
     
     std::cout << "[DEBUG] Position application completed successfully" << std::endl;
     
-    // Retry if configured and needed
-    bool success = true;
-    if (!success && m_config->getAdvancedConfig()["retryOnFailure"].toBool()) {
-        int retries = m_config->getAdvancedConfig()["retryCount"].toInt();
-        int delay = m_config->getAdvancedConfig()["retryDelay"].toInt();
-        
-        while (!success && retries > 0) {
-            logDebug(QString("Retrying position application (%1 attempts left)").arg(retries));
-            QThread::msleep(delay);
-            
-            if (useTiling) {
-                success = m_hyprland->positionTiledWindow(pixelPos.x, pixelPos.y, pixelPos.width, pixelPos.height);
-            } else {
-                success = m_hyprland->moveAndResizeWindow(pixelPos.x, pixelPos.y, pixelPos.width, pixelPos.height);
-            }
-            retries--;
+    // Timed from the outermost call, revalidation included
+    emit gridPositionApplied(m_applyPreset, m_applyCode, FlightRecorder::now() - record.startUs);
+    std::cout << "[DEBUG] gridPositionApplied signal emitted" << std::endl;
+    return true;
+}
+
+bool GridManager::shouldVerify() const
+{
+    // "off", "sampled" (one apply in verifySampleEvery) or "always"
+    const QVariantMap advanced = m_config->getAdvancedConfig();
+    const QString mode = advanced.value("verifyPlacement", "sampled").toString();
+    if (mode == "always") {
+        return true;
+    }
+    if (mode == "sampled") {
+        int every = qMax(1, advanced.value("verifySampleEvery", 10).toInt());
+        return QRandomGenerator::global()->bounded(every) == 0;
+    }
+    return false;
+}
+
+bool GridManager::verifyPlacement(const QString &address, const PixelPosition &target, bool firstCheck)
+{
+    Trace::Span span("apply.verify", "apply");
+    m_placementStats.verified++;
+    
+    // One read of the window's geometry
+    WindowInfo window;
+    if (!m_hyprland->getWindowInfo(address, window)) {
+        m_placementStats.unreadable++;
+        Metrics::count("hypr_grid_verifications_total", "result", "unreadable");
+        logWarning(QString("Cannot read back the geometry of %1").arg(address));
+        return false;
+    }
+    
+    const int error = qMax(qMax(qAbs(window.x - target.x), qAbs(window.y - target.y)),
+                           qMax(qAbs(window.width - target.width), qAbs(window.height - target.height)));
+    const int tolerance = m_config->getAdvancedConfig().value("verifyTolerance", 5).toInt();
+    const bool matched = error <= tolerance;
+    Metrics::count("hypr_grid_verifications_total", "result", matched ? "matched" : "mismatched");
+    
+    // First checks measure how accurate placement is before any correction
+    if (firstCheck) {
+        m_placementStats.maxErrorPx = qMax(m_placementStats.maxErrorPx, error);
+        if (matched) {
+            m_placementStats.matched++;
         }
     }
+    if (span.active()) {
+        span.setDetail(QString("%1 error=%2px").arg(matched ? "ok" : "off").arg(error).toStdString());
+    }
     
-    if (success) {
-        emit gridPositionApplied(QString(), QString()); // We don't know the preset/code here
-        std::cout << "[DEBUG] gridPositionApplied signal emitted" << std::endl;
+    if (!matched) {
+        logWarning(QString("Window at %1,%2 %3x%4, expected %5,%6 %7x%8")
+            .arg(window.x).arg(window.y).arg(window.width).arg(window.height)
+            .arg(target.x).arg(target.y).arg(target.width).arg(target.height));
+    }
+    return matched;
+}
+
+int GridManager::retryBackoffMs(int attempt) const
+{
+    // Give Hyprland its usual response time plus four deviations, as TCP
+    // does for retransmits, doubled per attempt; retryDelay is the ceiling
+    double base = 10;
+    if (m_hyprland->responseTimeMs() >= 0) {
+        base = qMax(1.0, m_hyprland->responseTimeMs() + 4 * m_hyprland->responseDeviationMs());
+    }
+    const int ceiling = m_config->getAdvancedConfig().value("retryDelay", 200).toInt();
+    return qMin(ceiling, static_cast<int>(std::ceil(base * (1 << qMin(attempt, 10)))));
+}
+
+std::optional<ApplyContext> GridManager::captureApplyContext()
+{
+    TRACE_SPAN("apply.capture", "apply");
+    if (!ensureHyprland()) {
+        return std::nullopt;
+    }
+    
+    // Window, monitor and workspace state in a single round-trip (or none
+    // with a synced state mirror)
+    PlacementState state = m_hyprland->queryPlacementState();
+    if (!state.valid) {
+        std::cout << "[ERROR] Failed to query Hyprland state" << std::endl;
+        logError("Failed to query Hyprland state");
+        return std::nullopt;
     }
     
-    std::cout << "[DEBUG] applyGridPosition returning: " << (success ? "true" : "false") << std::endl;
-    return success;
+    ApplyContext context;
+    context.address = state.windowAddress();
+    if (context.address.isEmpty()) {
+        std::cout << "[ERROR] No focused window" << std::endl;
+        logError("No focused window");
+        return std::nullopt;
+    }
+    
+    context.screen = screenFromMonitorData(state.monitor);
+    if (context.screen.width <= 0 || context.screen.height <= 0) {
+        std::cout << "[ERROR] Invalid screen dimensions: " << context.screen.width << "x" << context.screen.height << std::endl;
+        logError("Invalid screen dimensions");
+        return std::nullopt;
+    }
+    
+    context.floating = state.window.floating;
+    context.workspaceId = state.workspaceId;
+    context.workspaceWindowCount = state.workspaceWindowCount;
+    context.monitorCached = state.monitorCached;
+    return context;
 }
 
 bool GridManager::resetWindowState()
 {
     logInfo("Resetting window state");
+    DeadlineScope deadline(this, "Reset");
+    if (!ensureHyprland()) {
+        return false;
+    }
     
-    // Toggle floating twice to reset state
-    m_hyprland->toggleFloating();
-    QThread::msleep(100);
-    m_hyprland->toggleFloating();
+    // Toggle floating twice to reset state, waiting for each to land
+    QString address = m_hyprland->activeWindowAddress();
+    if (!address.isEmpty()) {
+        m_hyprland->toggleFloatingAndWait(address, floatingTimeout());
+        m_hyprland->toggleFloatingAndWait(address, floatingTimeout());
+    }
     
     // Clear any window rules
     m_hyprland->clearWindowRules();
@@ -316,85 +728,89 @@ PixelPosition GridManager::gridToPixelPosition(const GridPosition &position, con
     return pixelPos;
 }
 
-bool GridManager::ensureFloating()
+bool GridManager::ensureFloating(const QString &address, bool isFloating)
 {
-    // Check current window state
-    bool isFloating = m_hyprland->isWindowFloating();
+    if (isFloating) {
+        return true;
+    }
     
-    if (!isFloating) {
-        logDebug("Window is not floating, toggling to floating state");
-        if (!m_hyprland->toggleFloating()) {
+    TRACE_SPAN("apply.ensureFloating", "apply");
+    logDebug("Window is not floating, toggling to floating state");
+    const int timeout = floatingTimeout();
+    int retryCount = m_config->getAdvancedConfig()["retryCount"].toInt();
+    
+    // Returns as soon as Hyprland confirms the new state
+    FloatingToggle toggle = m_hyprland->toggleFloatingAndWait(address, timeout);
+    while (!isCancelled()) {
+        if (toggle.status != IpcStatus::Ok) {
             logError("Failed to toggle floating state");
             return false;
         }
+        if (toggle.confirmed && toggle.floating) {
+            return true;
+        }
+        if (retryCount-- <= 0) {
+            break;
+        }
         
-        // Wait a bit and verify
-        QThread::msleep(100);
-        isFloating = m_hyprland->isWindowFloating();
-        
-        if (!isFloating) {
-            int retryCount = m_config->getAdvancedConfig()["retryCount"].toInt();
-            
-            // Try a few more times with longer delays
-            while (!isFloating && retryCount > 0) {
-                logWarning(QString("Window still not floating, retrying (attempts left: %1)").arg(retryCount));
-                
-                // Toggle twice to reset state
-                m_hyprland->toggleFloating();
-                QThread::msleep(200);
-                m_hyprland->toggleFloating();
-                QThread::msleep(200);
-                
-                isFloating = m_hyprland->isWindowFloating();
-                retryCount--;
-            }
+        if (toggle.confirmed) {
+            // The window was already floating and our toggle tiled it
+            logWarning("Window was already floating, toggling back");
+            toggle = m_hyprland->toggleFloatingAndWait(address, timeout);
+        } else {
+            // No confirmation, the state is unknown: toggle twice to reset it
+            logWarning(QString("No floating confirmation within %1 ms, resetting (attempts left: %2)")
+                .arg(timeout).arg(retryCount + 1));
+            m_hyprland->toggleFloatingAndWait(address, timeout);
+            toggle = m_hyprland->toggleFloatingAndWait(address, timeout);
         }
     }
     
-    return isFloating;
+    logError("Failed to make window floating");
+    return false;
 }
 
-bool GridManager::ensureTiled()
+bool GridManager::ensureTiled(const QString &address, bool isFloating)
 {
     // For the grid manager's "tiling" mode, we use floating windows positioned
     // precisely on the grid. This gives us exact control while maintaining the
     // visual grid layout the user expects.
+    if (isFloating) {
+        return true;
+    }
     
-    // Check current window state
-    bool isFloating = m_hyprland->isWindowFloating();
+    TRACE_SPAN("apply.ensureTiled", "apply");
+    logDebug("Window is tiled, making it floating for precise positioning");
+    FloatingToggle toggle = m_hyprland->toggleFloatingAndWait(address, floatingTimeout());
+    if (toggle.status != IpcStatus::Ok) {
+        logError("Failed to toggle floating state");
+        return false;
+    }
     
-    if (!isFloating) {
-        logDebug("Window is tiled, making it floating for precise positioning");
-        if (!m_hyprland->toggleFloating()) {
-            logError("Failed to toggle floating state");
-            return false;
-        }
-        
-        // Wait a bit and verify
-        QThread::msleep(100);
-        isFloating = m_hyprland->isWindowFloating();
-        
-        if (!isFloating) {
-            logError("Failed to make window floating");
-            return false;
-        }
+    if (!toggle.confirmed || !toggle.floating) {
+        logError("Failed to make window floating");
+        return false;
     }
     
     return true;
 }
 
-Screen GridManager::getScreenDimensions() const
+int GridManager::floatingTimeout() const
+{
+    // Configs written before this setting existed fall back to the default
+    return m_config->getAdvancedConfig().value("floatingTimeout", 500).toInt();
+}
+
+Screen GridManager::screenFromMonitorData(const MonitorInfo &monitorData) const
 {
-    QVariantMap monitorData = m_hyprland->getFocusedMonitorData();
-    
     Screen screen;
-    screen.width = monitorData["width"].toInt();
-    screen.height = monitorData["height"].toInt();
+    screen.width = monitorData.width;
+    screen.height = monitorData.height;
     screen.reservedTop = 0;
     screen.reservedBottom = 0;
     screen.reservedLeft = 0;
     screen.reservedRight = 0;
-    screen.scale = monitorData["scale"].toDouble();
+    screen.scale = monitorData.scale;
     
     // Set default scale if not specified
     if (screen.scale <= 0.0) {
@@ -430,98 +846,7 @@ void GridManager::logWarning(const QString &message) const
 
 void GridManager::logError(const QString &message) const
 {
+    Metrics::count("hypr_grid_errors_total");
     qDebug() << "[ERROR]" << message;
     emit const_cast<GridManager*>(this)->errorOccurred(message);
 }
-
-bool GridManager::hasMultipleWindowsInWorkspace() const
-{
-    // Get current workspace ID
-    int currentWorkspace = m_hyprland->getCurrentWorkspaceId();
-    if (currentWorkspace < 0) {
-        logError("Failed to get current workspace ID");
-        return false; // Assume single window on error
-    }
-    
-    // Get all windows using hyprctl
-    QProcess process;
-    process.start("hyprctl", QStringList() << "clients" << "-j");
-    process.waitForFinished();
-    
-    if (process.exitCode() != 0) {
-        logError("Failed to get window list from hyprctl");
-        return false; // Assume single window on error
-    }
-    
-    QString output = process.readAllStandardOutput();
-    QJsonDocument doc = QJsonDocument::fromJson(output.toUtf8());
-    
-    if (!doc.isArray()) {
-        logError("Invalid JSON response from hyprctl clients");
-        return false;
-    }
-    
-    // Count windows in current workspace (excluding special workspaces)
-    int windowCount = 0;
-    QJsonArray windows = doc.array();
-    
-    for (const QJsonValue &val : windows) {
-        if (!val.isObject()) continue;
-        
-        QJsonObject window = val.toObject();
-        int windowWorkspace = window["workspace"].toObject()["id"].toInt();
-        
-        // Only count windows in the current workspace, not special workspaces
-        if (windowWorkspace == currentWorkspace && windowWorkspace > 0) {
-            windowCount++;
-        }
-    }
-    
-    logDebug(QString("Found %1 windows in workspace %2").arg(windowCount).arg(currentWorkspace));
-    return windowCount > 1;
-}
-
-bool GridManager::testAllPositions()
-{
-    logInfo("Starting grid position test - cycling through all available positions");
-    
-    if (!m_config) {
-        logError("Configuration not loaded");
-        return false;
-    }
-    
-    QStringList presets = getPresetNames();
-    if (presets.isEmpty()) {
-        logError("No presets available for testing");
-        return false;
-    }
-    
-    // Use the first preset for testing
-    QString testPreset = presets.first();
-    QStringList positions = getPositionCodesForPreset(testPreset);
-    
-    if (positions.isEmpty()) {
-        logError(QString("No positions available in preset '%1'").arg(testPreset));
-        return false;
-    }
-    
-    logInfo(QString("Testing %1 positions from preset '%2'").arg(positions.size()).arg(testPreset));
-    
-    bool allSuccess = true;
-    for (const QString &positionCode : positions) {
-        logInfo(QString("Testing position: %1:%2").arg(testPreset).arg(positionCode));
-        
-        if (!applyPositionByCode(testPreset, positionCode)) {
-            logError(QString("Failed to apply position: %1:%2").arg(testPreset).arg(positionCode));
-            allSuccess = false;
-        } else {
-            logInfo(QString("✓ Successfully applied position: %1:%2").arg(testPreset).arg(positionCode));
-        }
-        
-        // Wait 2 seconds between positions to see the change
-        QThread::msleep(2000);
-    }
-    
-    logInfo(QString("Grid position test completed. Success: %1").arg(allSuccess ? "Yes" : "No"));
-    return allSuccess;
-}
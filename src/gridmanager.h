@@ -7,7 +7,12 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 
+#include <functional>
+#include <optional>
+
+#include "applyqueue.h"
 #include "hyprlandapi.h"
+#include "hyprlandstate.h"
 #include "config.h"
 
 // Struct to hold grid position data
@@ -39,6 +44,39 @@ struct Screen {
     double scale;
 };
 
+// Everything one apply decides on, captured once before anything changes.
+// Every later step targets `address`, so a focus change mid-apply cannot
+// redirect the operation to another window.
+struct ApplyContext {
+    QString address;
+    bool floating = false;
+    Screen screen;
+    int workspaceId = -1;
+    int workspaceWindowCount = 0;
+    bool monitorCached = false;     // Screen came from the monitor cache
+};
+
+// What the last apply dispatched, for checking where the window ended up
+struct PlacementTarget {
+    QString address;            // Empty if the apply stopped before dispatching
+    PixelPosition geometry = {0, 0, 0, 0};
+    int attempts = 0;
+};
+
+// Placement outcomes since startup, to track how accurately windows land
+struct PlacementStats {
+    quint64 placements = 0;     // Applies that got as far as the dispatch
+    quint64 verified = 0;       // Geometry read-backs, retries included
+    quint64 matched = 0;        // Within tolerance on the first check
+    quint64 corrected = 0;      // Within tolerance after a retry
+    quint64 offTarget = 0;      // Still off after all retries
+    quint64 unreadable = 0;     // Read-backs that failed
+    quint64 retries = 0;
+    quint64 failed = 0;         // Dispatch failed on every attempt
+    int maxErrorPx = 0;         // Worst deviation seen on a first check
+    quint64 overBudget = 0;     // Applies that ran out of their deadline
+};
+
 class GridManager : public QObject
 {
     Q_OBJECT
@@ -49,10 +87,41 @@ public:
     
     // Core functionality
     bool initialize();
-    bool applyPositionByCode(const QString &preset, const QString &code);
+    bool enableStateMirror();
+    bool publishStateSnapshot();
+    // `context` is the one the request was queued under; captured here if absent
+    bool applyPositionByCode(const QString &preset, const QString &code,
+                             const std::optional<ApplyContext> &context = std::nullopt);
     bool applyGridPosition(const GridPosition &position);
     bool resetWindowState();
-    bool testAllPositions();
+    
+    // Cooperative cancellation, checked between IPC steps of an apply
+    void setCancellationCheck(std::function<bool()> check) { m_cancellationCheck = std::move(check); }
+    bool isCancelled() const { return m_cancellationCheck && m_cancellationCheck(); }
+    
+    // Apply through the shared queue: waits for its turn, is dropped or cut
+    // short once a newer request for the same window arrives. `poll` runs
+    // at every cancellation point so a daemon can take in new requests
+    // meanwhile. Without a `context` it is captured when the ticket runs.
+    // A context captured at enqueue time is refreshed first when
+    // `refreshContext` is set (ApplyQueue::enqueue's followsSameTarget).
+    ApplyQueue::Outcome runQueuedApply(ApplyQueue &queue, uint64_t ticket, const QString &preset,
+                                       const QString &code, std::function<void()> poll = {},
+                                       const std::optional<ApplyContext> &context = std::nullopt,
+                                       bool refreshContext = false);
+    
+    // Focused window and everything an apply decides on, in one round trip
+    // (none with a synced state mirror); nothing if there is no window
+    std::optional<ApplyContext> captureApplyContext();
+    
+    // Window a request made now would target; empty if unknown. May run
+    // inside another apply's cancellation check without counting toward
+    // that apply's deadline or flight record.
+    QString focusedWindowAddress();
+    
+    const PlacementStats &placementStats() const { return m_placementStats; }
+    const PlacementTarget &lastPlacement() const { return m_lastPlacement; }
+    const HyprlandAPI *hyprland() const { return m_hyprland; }
     
     // Configuration
     void printConfig() const;
@@ -64,20 +133,45 @@ public:
     GridPosition getGridPosition(const QString &preset, const QString &code) const;
     void saveGridPosition(const QString &preset, const QString &code, const GridPosition &position);
     
+    // Window geometry for a grid position on `screen`; no Hyprland involved
+    PixelPosition gridToPixelPosition(const GridPosition &position, const Screen &screen) const;
+    
 signals:
-    void gridPositionApplied(const QString &preset, const QString &code);
+    // A window was placed; `elapsedUs` is from the request to the placement
+    void gridPositionApplied(const QString &preset, const QString &code, qint64 elapsedUs);
     void errorOccurred(const QString &message);
     
 private:
     HyprlandAPI *m_hyprland;
+    HyprlandState *m_state;
     Config *m_config;
+    std::function<bool()> m_cancellationCheck;
+    PlacementStats m_placementStats;
+    PlacementTarget m_lastPlacement;
+    
+    // Sets the deadline of one apply on the Hyprland API (advanced
+    // "applyBudgetMs") and logs how much of it was used
+    class DeadlineScope;
+    
+    // Records one apply in the flight recorder, with the requests it made
+    class RecordScope;
+    QString m_applyPreset;
+    QString m_applyCode;
+    std::optional<ApplyContext> m_applyContext;
     
     // Helper methods
-    PixelPosition gridToPixelPosition(const GridPosition &position, const Screen &screen) const;
-    bool ensureFloating();
-    bool ensureTiled();
-    bool hasMultipleWindowsInWorkspace() const;
-    Screen getScreenDimensions() const;
+    bool ensureHyprland();
+    bool refreshApplyContext(ApplyContext &context);
+    bool ensureFloating(const QString &address, bool isFloating);
+    bool ensureTiled(const QString &address, bool isFloating);
+    
+    // Post-apply verification policy (advanced "verifyPlacement") and the
+    // retry delay derived from Hyprland's measured response time
+    bool shouldVerify() const;
+    bool verifyPlacement(const QString &address, const PixelPosition &target, bool firstCheck);
+    int retryBackoffMs(int attempt) const;
+    int floatingTimeout() const;
+    Screen screenFromMonitorData(const MonitorInfo &monitorData) const;
     
     // Logging
     void logDebug(const QString &message) const;
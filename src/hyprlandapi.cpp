@@ -1,57 +1,91 @@
 #include "hyprlandapi.h"
+#include "hyprlandstate.h"
+#include "notifier.h"
+#include "daemonprotocol.h"
+#include "statesnapshot.h"
+#include "monitorcache.h"
+#include "metrics.h"
+#include "flightrecorder.h"
+#include "trace.h"
 
 #include <QProcess>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonArray>
 #include <QDebug>
-#include <QUuid>
 #include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
 #include <QRegularExpression>
-#include <QStandardPaths>
 #include <QDir>
-#include <iostream>
+#include <QStandardPaths>
+#include <cmath>
+
+namespace {
+
+// Longest any single request may take, deadline or not
+const int RequestTimeoutMs = 3000;
+
+// Metric label of a request: the query or dispatcher, never its arguments
+std::string commandLabel(const QString &command)
+{
+    const QStringList words = command.split(' ', Qt::SkipEmptyParts);
+    if (words.size() > 1 && (words[0] == "dispatch" || words[0] == "keyword")) {
+        return (words[0] + " " + words[1]).toStdString();
+    }
+    return words.value(0).toStdString();
+}
+
+void countIpcError(IpcStatus status)
+{
+    if (status != IpcStatus::Ok) {
+        Metrics::count("hypr_grid_ipc_errors_total", "status", ipcStatusName(status));
+    }
+}
+
+std::string_view jsonView(const QByteArray &data)
+{
+    return std::string_view(data.constData(), static_cast<size_t>(data.size()));
+}
+
+} // namespace
 
 HyprlandAPI::HyprlandAPI(QObject *parent) 
-    : QObject(parent), m_initialized(false)
+    : QObject(parent), m_state(nullptr), m_notifier(nullptr), m_snapshot(nullptr), m_snapshotOpened(false),
+      m_monitorCacheDisabled(false),
+      m_responseTimeMs(-1), m_responseDeviationMs(0), m_expiredRequests(0),
+      m_flightRecord(nullptr), m_initialized(false)
 {
     // No additional initialization needed
 }
 
 HyprlandAPI::~HyprlandAPI()
 {
-    // Clean up any outstanding rules
-    if (m_initialized && !m_currentWindowRuleIdentifier.isEmpty()) {
+    // Remove the rules we installed, leaving the user's own untouched
+    if (m_initialized && !m_windowRules.isEmpty()) {
         clearWindowRules();
     }
+    delete m_snapshot;
 }
 
 bool HyprlandAPI::initialize()
 {
-    // Check if Hyprland is running
-    QProcess process;
-    process.start("pgrep", QStringList() << "-x" << "Hyprland");
-    process.waitForFinished();
-    
-    if (process.exitCode() != 0) {
-        emit errorOccurred("Hyprland is not running");
-        return false;
-    }
-    
-    // Get current window information
-    QVariantMap windowData = getFocusedWindowData();
-    if (windowData.isEmpty()) {
-        qDebug() << "No focused window found, but continuing initialization";
-    } else {
-        m_currentWindowAddress = windowData["address"].toString();
-        qDebug() << "Current window address:" << m_currentWindowAddress;
+    TRACE_SPAN("hyprland.initialize", "init");
+    
+    // Hyprland runs exactly while its instance socket exists
+    if (!m_ipc.isAvailable()) {
+        // hyprctl may still find an instance we cannot, so only give up
+        // when there is no instance signature or no hyprctl either
+        if (qEnvironmentVariableIsEmpty("HYPRLAND_INSTANCE_SIGNATURE") ||
+            QStandardPaths::findExecutable("hyprctl").isEmpty()) {
+            emit errorOccurred("Hyprland is not running");
+            return false;
+        }
+        qWarning() << "Hyprland socket not found, requests will go through hyprctl";
     }
     
     m_initialized = true;
     return true;
 }
 
-bool HyprlandAPI::moveAndResizeWindow(int x, int y, int width, int height)
+bool HyprlandAPI::moveAndResizeWindow(const QString &address, int x, int y, int width, int height)
 {
     // Make sure we're initialized
     if (!m_initialized) {
@@ -59,92 +93,94 @@ bool HyprlandAPI::moveAndResizeWindow(int x, int y, int width, int height)
         return false;
     }
     
-    // Update current window information
-    QVariantMap windowData = getFocusedWindowData();
-    if (windowData.isEmpty()) {
-        emit errorOccurred("No focused window");
-        return false;
-    }
-    
-    m_currentWindowAddress = windowData["address"].toString();
-    std::cout << "[DEBUG] moveAndResizeWindow: address=" << m_currentWindowAddress.toStdString() << std::endl;
-    
-    // Execute the move and resize commands
-    QString moveCmd = QString("movewindowpixel exact %1 %2,address:%3")
-        .arg(x).arg(y).arg(m_currentWindowAddress);
-    
-    QString resizeCmd = QString("resizewindowpixel exact %1 %2,address:%3")
-        .arg(width).arg(height).arg(m_currentWindowAddress);
-    
-    std::cout << "[DEBUG] moveAndResizeWindow: moveCmd=" << moveCmd.toStdString() << std::endl;
-    std::cout << "[DEBUG] moveAndResizeWindow: resizeCmd=" << resizeCmd.toStdString() << std::endl;
-    
-    QString moveResult = executeHyprlandCommand(moveCmd);
-    QString resizeResult = executeHyprlandCommand(resizeCmd);
-    
-    std::cout << "[DEBUG] moveAndResizeWindow: moveResult='" << moveResult.toStdString() << "'" << std::endl;
-    std::cout << "[DEBUG] moveAndResizeWindow: resizeResult='" << resizeResult.toStdString() << "'" << std::endl;
+    // Move and resize in one batched dispatch
+    PlacementResult result = applyPlacement(address, x, y, width, height, false);
     
-    // Check for success - Hyprland returns "ok" for successful commands, or empty/error messages
-    bool moveSuccess = moveResult.trimmed().isEmpty() || 
-                       moveResult.trimmed() == "ok" ||
-                       (!moveResult.contains("error", Qt::CaseInsensitive) && 
-                        !moveResult.contains("failed", Qt::CaseInsensitive));
-                        
-    bool resizeSuccess = resizeResult.trimmed().isEmpty() || 
-                         resizeResult.trimmed() == "ok" ||
-                         (!resizeResult.contains("error", Qt::CaseInsensitive) && 
-                          !resizeResult.contains("failed", Qt::CaseInsensitive));
-    
-    std::cout << "[DEBUG] moveAndResizeWindow: moveSuccess=" << (moveSuccess ? "true" : "false") << " resizeSuccess=" << (resizeSuccess ? "true" : "false") << std::endl;
+    bool moveSuccess = result.moveStatus == IpcStatus::Ok;
+    bool resizeSuccess = result.resizeStatus == IpcStatus::Ok;
     
     return moveSuccess && resizeSuccess;
 }
 
-bool HyprlandAPI::toggleFloating()
+FloatingToggle HyprlandAPI::toggleFloatingAndWait(const QString &address, int timeoutMs)
 {
-    // Make sure we're initialized
-    if (!m_initialized) {
-        emit errorOccurred("HyprlandAPI not initialized");
-        return false;
+    TRACE_SPAN("floating.toggle", "apply");
+    FloatingToggle toggle;
+    const QString command = QString("togglefloating address:%1").arg(address);
+    Metrics::count("hypr_grid_floating_toggles_total");
+    
+    // The state mirror already reads the event socket. Take the serial only
+    // after it has applied what is queued, or an earlier event for this
+    // window would confirm the toggle.
+    if (m_state && m_state->isSynced()) {
+        quint64 since = m_state->floatingSerial();
+        toggle.status = executeHyprlandCommand(command).status;
+        if (toggle.status == IpcStatus::Ok) {
+            std::optional<bool> floating = m_state->waitForFloating(address, since, m_deadline.remainingMs(timeoutMs));
+            toggle.confirmed = floating.has_value();
+            toggle.floating = floating.value_or(false);
+        }
+        return toggle;
     }
     
-    // Update window address first
-    QVariantMap windowData = getFocusedWindowData();
-    if (windowData.isEmpty()) {
-        emit errorOccurred("No focused window");
-        return false;
+    // Otherwise subscribe for just this dispatch. Events carry the address
+    // without its 0x prefix.
+    HyprlandEventWatch watch;
+    toggle.status = executeHyprlandCommand(command).status;
+    if (toggle.status != IpcStatus::Ok) {
+        return toggle;
     }
     
-    m_currentWindowAddress = windowData["address"].toString();
+    if (watch.isConnected()) {
+        QByteArray prefix = address.toLatin1();
+        if (prefix.startsWith("0x")) {
+            prefix = prefix.mid(2);
+        }
+        QByteArray data;
+        if (watch.waitFor("changefloatingmode", prefix + ",", m_deadline.remainingMs(timeoutMs), &data)) {
+            toggle.confirmed = true;
+            toggle.floating = data.endsWith(",1");
+        }
+        return toggle;
+    }
     
-    // Toggle floating state
-    QString result = executeHyprlandCommand("togglefloating");
-    // hyprctl dispatch commands typically return empty on success
-    // or contain error messages on failure
-    return !result.contains("error", Qt::CaseInsensitive) && !result.contains("failed", Qt::CaseInsensitive);
+    // No event socket (hyprctl fallback): Hyprland applies dispatches before
+    // replying, so a single query reflects the toggle
+    WindowInfo window;
+    if (getWindowInfo(address, window)) {
+        toggle.confirmed = true;
+        toggle.floating = window.floating;
+    }
+    return toggle;
 }
 
-bool HyprlandAPI::isWindowFloating()
+QList<IpcReply> HyprlandAPI::queryBatch(const QStringList &queries, int timeoutMs) const
 {
-    // Make sure we're initialized
-    if (!m_initialized) {
-        emit errorOccurred("HyprlandAPI not initialized");
-        return false;
-    }
-    
-    // Get current window data
-    QVariantMap windowData = getFocusedWindowData();
-    if (windowData.isEmpty()) {
-        emit errorOccurred("No focused window");
+    return sendBatch(queries, IpcFormat::Json, timeoutMs);
+}
+
+bool HyprlandAPI::getWindowInfo(const QString &address, WindowInfo &window)
+{
+    // Hyprland has no per-address query, scan the clients reply for it
+    IpcReply reply = executeRequest("clients", IpcFormat::Json);
+    if (!reply.ok()) {
         return false;
     }
     
-    // Check if floating
-    return windowData["floating"].toBool();
+    TRACE_SPAN("json.clients", "json");
+    Metrics::Timer parseTimer("hypr_grid_json_parse_duration_seconds", "reply", "clients");
+    const uint64_t target = HyprlandJson::parseAddress(jsonView(address.toLatin1()));
+    bool found = false;
+    HyprlandJson::forEachClient(jsonView(reply.data), [&](const WindowInfo &client) {
+        if (client.address == target) {
+            window = client;
+            found = true;
+        }
+    }, HyprlandJson::WindowGeometry);
+    return found;
 }
 
-bool HyprlandAPI::applyWindowRules(int x, int y, int width, int height)
+bool HyprlandAPI::clearWindowRules()
 {
     // Make sure we're initialized
     if (!m_initialized) {
@@ -152,327 +188,475 @@ bool HyprlandAPI::applyWindowRules(int x, int y, int width, int height)
         return false;
     }
     
-    // Update window data
-    QVariantMap windowData = getFocusedWindowData();
-    if (windowData.isEmpty()) {
-        emit errorOccurred("No focused window");
-        return false;
+    // Unset only our own rules, never reload the user's config
+    m_windowRules.removeAll();
+    return syncWindowRules();
+}
+
+bool HyprlandAPI::syncWindowRules()
+{
+    if (!m_windowRules.hasPendingChanges()) {
+        return true;
     }
     
-    // Clear any existing rules
-    clearWindowRules();
+    const QStringList commands = m_windowRules.pendingCommands();
+    QList<IpcReply> replies = executeBatch(commands, IpcFormat::Ack);
     
-    // Generate a new identifier
-    m_currentWindowRuleIdentifier = generateWindowRuleIdentifier();
-    
-    // Get window class and title
-    QString windowClass = windowData["class"].toString();
-    QString windowTitle = windowData["title"].toString();
+    bool success = true;
+    for (int i = 0; i < commands.size(); ++i) {
+        IpcStatus status = i < replies.size() ? replies[i].status : IpcStatus::IoError;
+        if (status != IpcStatus::Ok) {
+            qWarning() << "Window rule update failed" << commands[i] << "(" << ipcStatusName(status) << ")";
+            success = false;
+        }
+    }
     
-    if (windowClass.isEmpty()) {
-        emit errorOccurred("Window class is empty");
-        return false;
+    // Hyprland applies batches command by command, so on failure the
+    // installed set is unknown; keep the changes pending for the next sync
+    if (success) {
+        m_windowRules.markSynced();
     }
+    return success;
+}
+
+PlacementState HyprlandAPI::queryPlacementState()
+{
+    PlacementState state;
     
-    // Create the rules
-    QStringList rules;
+    // A synced state mirror answers without any IPC
+    if (m_state) {
+        state = m_state->placementState();
+        if (state.valid) {
+            return state;
+        }
+    } else if (readSnapshot(state)) {
+        // Published by a running daemon that mirrors the event socket
+        return state;
+    }
     
-    // Position and size rule
-    QString positionRule = QString("windowrulev2=float,class:%1,title:%2")
-        .arg(windowClass).arg(windowTitle);
+    // Monitors of this session cached by an earlier invocation leave the
+    // largest reply out of the batch
+    std::vector<MonitorInfo> monitors;
+    const std::string session = monitorCacheSession();
+    const bool cached = !m_monitorCacheDisabled && MonitorCache().load(session, monitors);
+    
+    // Fetch everything in a single [[BATCH]] round-trip. activeworkspace
+    // already carries the window count, so the clients list is not needed.
+    QStringList commands = QStringList() << "activewindow" << "activeworkspace";
+    if (!cached) {
+        commands << "monitors";
+    }
+    QList<IpcReply> replies = executeBatch(commands, IpcFormat::Json);
     
-    QString dimensionsRule = QString("windowrulev2=move %1 %2,class:%3,title:%4")
-        .arg(x).arg(y).arg(windowClass).arg(windowTitle);
+    for (const IpcReply &reply : replies) {
+        if (!reply.ok()) {
+            emit errorOccurred(QString("Failed to query Hyprland state (%1)").arg(ipcStatusName(reply.status)));
+            return state;
+        }
+    }
     
-    QString sizeRule = QString("windowrulev2=size %1 %2,class:%3,title:%4")
-        .arg(width).arg(height).arg(windowClass).arg(windowTitle);
+    // Decode straight from the reply bytes into typed structs
+    WorkspaceInfo workspace;
+    bool decoded;
+    {
+        TRACE_SPAN("json.placementState", "json");
+        Metrics::Timer parseTimer("hypr_grid_json_parse_duration_seconds", "reply", "placementState");
+        decoded = HyprlandJson::decodeWindow(jsonView(replies[0].data), state.window, HyprlandJson::WindowGeometry) &&
+                  HyprlandJson::decodeWorkspace(jsonView(replies[1].data), workspace) &&
+                  (cached || HyprlandJson::decodeMonitors(jsonView(replies[2].data), monitors));
+    }
+    if (!decoded) {
+        emit errorOccurred("Failed to parse Hyprland state");
+        return state;
+    }
     
-    // Apply the rules
-    QProcess process;
-    process.start("hyprctl", QStringList() << "keyword" << positionRule);
-    process.waitForFinished();
+    // The active workspace names the focused monitor. A name the cache does
+    // not know means the layout changed: query the monitors after all.
+    const MonitorInfo *monitor = nullptr;
+    bool fromCache = cached;
+    if (cached) {
+        for (const MonitorInfo &candidate : monitors) {
+            if (candidate.name == workspace.monitor) {
+                monitor = &candidate;
+            }
+        }
+        if (!monitor) {
+            qDebug() << "Monitor cache has no" << QString::fromStdString(workspace.monitor) << ", revalidating";
+            invalidateMonitorCache();
+            IpcReply reply = executeRequest("monitors", IpcFormat::Json);
+            if (!reply.ok() || !HyprlandJson::decodeMonitors(jsonView(reply.data), monitors)) {
+                emit errorOccurred("Failed to query Hyprland monitors");
+                return state;
+            }
+            monitor = HyprlandJson::focusedMonitor(monitors);
+            MonitorCache().store(session, monitors);
+            fromCache = false;
+        }
+    } else {
+        monitor = HyprlandJson::focusedMonitor(monitors);
+        if (monitor && !m_monitorCacheDisabled) {
+            MonitorCache().store(session, monitors);
+        }
+    }
+    if (!monitor) {
+        return state;
+    }
     
-    process.start("hyprctl", QStringList() << "keyword" << dimensionsRule);
-    process.waitForFinished();
+    state.monitor = *monitor;
+    state.monitor.activeWorkspaceId = workspace.id;
+    state.monitor.focused = true;
+    state.monitorCached = fromCache;
+    state.workspaceId = workspace.id;
     
-    process.start("hyprctl", QStringList() << "keyword" << sizeRule);
-    process.waitForFinished();
+    // Special workspaces have negative ids and are never counted
+    if (workspace.id > 0) {
+        state.workspaceWindowCount = workspace.windows;
+    }
     
-    return true;
+    state.valid = true;
+    return state;
 }
 
-bool HyprlandAPI::clearWindowRules()
+PlacementResult HyprlandAPI::applyPlacement(const QString &address, int x, int y, int width, int height,
+                                            bool makeFloating)
 {
-    // Make sure we're initialized
-    if (!m_initialized) {
-        emit errorOccurred("HyprlandAPI not initialized");
-        return false;
+    TRACE_SPAN("apply.placement", "apply");
+    PlacementResult result;
+    
+    // setfloating rather than togglefloating: the floating state may come
+    // from a daemon's snapshot that has not seen our last change yet, and
+    // floating an already floating window is harmless
+    QStringList commands;
+    if (makeFloating) {
+        commands << QString("setfloating address:%1").arg(address);
+    }
+    commands << QString("movewindowpixel exact %1 %2,address:%3").arg(x).arg(y).arg(address);
+    commands << QString("resizewindowpixel exact %1 %2,address:%3").arg(width).arg(height).arg(address);
+    
+    // Hyprland runs the whole batch before rendering, so the window never
+    // shows up moved but not yet resized
+    QList<IpcReply> replies = executeBatch(commands, IpcFormat::Ack);
+    
+    int index = 0;
+    if (makeFloating) {
+        result.toggled = true;
+        result.toggleStatus = replies[index++].status;
+        Metrics::count("hypr_grid_floating_toggles_total");
     }
+    result.moveStatus = replies[index++].status;
+    result.resizeStatus = replies[index++].status;
     
-    // Execute the reload command to clear all rules
-    QString result = executeHyprctlCommand(QStringList() << "reload");
+    // Hyprland reports the toggle on the event socket later; record it now so
+    // an immediate follow-up apply does not toggle back
+    if (m_state && result.toggled && result.toggleStatus == IpcStatus::Ok) {
+        m_state->noteFloating(address, true);
+    }
     
-    m_currentWindowRuleIdentifier.clear();
+    if (!result.ok()) {
+        qWarning() << "Batched placement failed: toggle" << ipcStatusName(result.toggleStatus)
+                   << "move" << ipcStatusName(result.moveStatus)
+                   << "resize" << ipcStatusName(result.resizeStatus);
+    }
     
-    return result.trimmed().isEmpty() || !result.contains("error", Qt::CaseInsensitive);
-}
-
-QVariantMap HyprlandAPI::getFocusedWindowData()
-{
-    QString output = executeHyprctlCommand(QStringList() << "activewindow" << "-j");
-    return parseJsonOutput(output);
+    return result;
 }
 
-QVariantMap HyprlandAPI::getFocusedMonitorData()
+// Address only; answered without IPC by a synced state mirror or a
+// daemon's snapshot
+QString HyprlandAPI::activeWindowAddress()
 {
-    // Get the active monitor
-    QString output = executeHyprctlCommand(QStringList() << "monitors" << "-j");
-    QJsonDocument doc = QJsonDocument::fromJson(output.toUtf8());
-    
-    if (!doc.isArray()) {
-        emit errorOccurred("Failed to parse monitor data");
-        return QVariantMap();
+    if (m_state && m_state->isSynced()) {
+        return m_state->activeWindowAddress();
     }
     
-    QJsonArray monitors = doc.array();
-    
-    // Find the focused monitor
-    for (const QJsonValue &val : monitors) {
-        if (!val.isObject()) continue;
-        
-        QJsonObject monitor = val.toObject();
-        if (monitor["focused"].toBool()) {
-            return monitor.toVariantMap();
-        }
+    PlacementState state;
+    if (!m_state && readSnapshot(state)) {
+        return state.windowAddress();
     }
     
-    // If no focused monitor found, return the first one
-    if (!monitors.isEmpty() && monitors.first().isObject()) {
-        return monitors.first().toObject().toVariantMap();
+    IpcReply reply = executeRequest("activewindow", IpcFormat::Json);
+    WindowInfo window;
+    if (!reply.ok() || !HyprlandJson::decodeWindow(jsonView(reply.data), window, HyprlandJson::WindowGeometry)
+        || !window.valid()) {
+        return QString();
     }
-    
-    return QVariantMap();
+    return QString::fromStdString(HyprlandJson::formatAddress(window.address));
 }
 
-QVariantMap HyprlandAPI::getWorkspaceData()
+bool HyprlandAPI::sendNotification(const QString &title, const QString &message, int timeout)
 {
-    QString output = executeHyprctlCommand(QStringList() << "workspaces" << "-j");
-    QJsonDocument doc = QJsonDocument::fromJson(output.toUtf8());
-    
-    if (!doc.isArray()) {
-        emit errorOccurred("Failed to parse workspace data");
-        return QVariantMap();
+    // Fire and forget; the D-Bus connection is only opened on first use
+    if (!m_notifier) {
+        m_notifier = new Notifier(this);
+    }
+    return m_notifier->notify(title, message, timeout);
+}
+
+IpcReply HyprlandAPI::executeRequest(const QString &command, IpcFormat format) const
+{
+    IpcReply reply = sendRequest(command, format);
+    if (m_flightRecord) {
+        const QByteArray text = command.toUtf8();
+        m_flightRecord->appendRequest(text.constData(), text.size(), ipcStatusName(reply.status));
+    }
+    return reply;
+}
+
+IpcReply HyprlandAPI::sendRequest(const QString &command, IpcFormat format) const
+{
+    IpcReply reply;
+    int timeoutMs;
+    if (!admitRequest(timeoutMs, reply.status)) {
+        qWarning() << "Not sending" << command << "(" << ipcStatusName(reply.status) << ")";
+        countIpcError(reply.status);
+        return reply;
     }
     
-    QJsonArray workspaces = doc.array();
-    
-    // Find the focused workspace
-    for (const QJsonValue &val : workspaces) {
-        if (!val.isObject()) continue;
-        
-        QJsonObject workspace = val.toObject();
-        if (workspace["id"].toInt() == workspace["lastwindow"].toInt()) {
-            return workspace.toVariantMap();
+    Metrics::Timer metricsTimer("hypr_grid_ipc_request_duration_seconds", "command",
+                                Metrics::enabled() ? commandLabel(command) : std::string());
+    if (m_ipc.isAvailable()) {
+        QElapsedTimer timer;
+        timer.start();
+        reply = m_ipc.request(command, format, timeoutMs);
+        if (reply.ok()) {
+            noteResponseTime(timer.nsecsElapsed());
+        }
+        if (reply.status != IpcStatus::NoSocket) {
+            noteOutcome(reply.status, timeoutMs);
+            countIpcError(reply.status);
+            return reply;
         }
+        qWarning() << "Hyprland socket unavailable, falling back to hyprctl for:" << command;
     }
     
-    // If no workspace with last window found, return the first one
-    if (!workspaces.isEmpty() && workspaces.first().isObject()) {
-        return workspaces.first().toObject().toVariantMap();
+    reply = executeHyprctlCommand(command, format, timeoutMs);
+    noteOutcome(reply.status, timeoutMs);
+    countIpcError(reply.status);
+    return reply;
+}
+
+bool HyprlandAPI::admitRequest(int &timeoutMs, IpcStatus &refusal, int maxTimeoutMs) const
+{
+    timeoutMs = m_deadline.remainingMs(maxTimeoutMs > 0 ? qMin(maxTimeoutMs, RequestTimeoutMs) : RequestTimeoutMs);
+    if (m_deadline.isSet() && timeoutMs == 0) {
+        m_expiredRequests++;
+        refusal = IpcStatus::Expired;
+        return false;
     }
     
-    return QVariantMap();
+    const CircuitBreaker::State before = m_breaker.state();
+    if (!m_breaker.allow()) {
+        refusal = IpcStatus::CircuitOpen;
+        return false;
+    }
+    if (m_breaker.state() != before) {
+        qWarning() << "Hyprland circuit breaker half-open, probing";
+    }
+    return true;
 }
 
-QStringList HyprlandAPI::getMonitors()
+void HyprlandAPI::noteOutcome(IpcStatus status, int timeoutMs) const
 {
-    QString output = executeHyprctlCommand(QStringList() << "monitors" << "-j");
-    QJsonDocument doc = QJsonDocument::fromJson(output.toUtf8());
-    
-    if (!doc.isArray()) {
-        emit errorOccurred("Failed to parse monitor data");
-        return QStringList();
+    const CircuitBreaker::State before = m_breaker.state();
+    if (status == IpcStatus::Timeout) {
+        // A request the deadline left little time says nothing about
+        // Hyprland; one that had a fair share of the budget and still got
+        // no answer does, or a hung compositor would never trip the breaker
+        const int fairWaitMs = qMin(RequestTimeoutMs, m_deadline.budgetMs() / 2);
+        if (m_deadline.isSet() && m_deadline.expired() && timeoutMs < fairWaitMs) {
+            m_expiredRequests++;
+            qWarning() << "Request ran out of the apply's" << m_deadline.budgetMs() << "ms deadline";
+            return;
+        }
+        m_breaker.recordTimeout();
+    } else if (status == IpcStatus::Ok || status == IpcStatus::CommandError) {
+        m_breaker.recordSuccess();
     }
     
-    QStringList result;
-    QJsonArray monitors = doc.array();
-    
-    for (const QJsonValue &val : monitors) {
-        if (!val.isObject()) continue;
-        
-        QJsonObject monitor = val.toObject();
-        result.append(monitor["name"].toString());
+    const CircuitBreaker::State after = m_breaker.state();
+    if (after == CircuitBreaker::Open && before != CircuitBreaker::Open) {
+        Metrics::count("hypr_grid_breaker_trips_total");
+        qWarning() << "Hyprland is not answering, failing requests fast (circuit breaker open)";
+    } else if (after == CircuitBreaker::Closed && before != CircuitBreaker::Closed) {
+        qWarning() << "Hyprland answers again (circuit breaker closed)";
     }
-    
-    return result;
 }
 
-bool HyprlandAPI::sendNotification(const QString &title, const QString &message, int timeout)
+IpcReply HyprlandAPI::executeHyprctlCommand(const QString &command, IpcFormat format, int timeoutMs) const
 {
-    QProcess process;
+    // hyprctl joins its arguments with spaces, so the verb and the rest of
+    // the command can be passed through unchanged
     QStringList args;
-    
-    // Try to use notify-send if available
-    QString notifySendPath = QStandardPaths::findExecutable("notify-send");
-    if (!notifySendPath.isEmpty()) {
-        args << "-a" << "Hypr Grid Manager" << title << message << "-t" << QString::number(timeout);
-        process.start(notifySendPath, args);
+    int space = command.indexOf(' ');
+    if (space < 0) {
+        args << command;
     } else {
-        // Fall back to using zenity
-        QString zenityPath = QStandardPaths::findExecutable("zenity");
-        if (!zenityPath.isEmpty()) {
-            args << "--notification" << "--text" << QString("%1: %2").arg(title, message);
-            process.start(zenityPath, args);
-        } else {
-            // No notification method available
-            return false;
-        }
+        args << command.left(space) << command.mid(space + 1);
+    }
+    if (format == IpcFormat::Json) {
+        args << "-j";
     }
     
-    process.waitForFinished(1000);
-    return process.exitCode() == 0;
+    IpcReply reply = runHyprctl(args, timeoutMs);
+    if (reply.ok()) {
+        reply.status = HyprlandIPC::classifyReply(reply.data, format);
+    }
+    return reply;
 }
 
-QString HyprlandAPI::executeHyprctlCommand(const QStringList &args) const
+IpcReply HyprlandAPI::runHyprctl(const QStringList &args, int timeoutMs) const
 {
+    Trace::Span span("hyprctl", "ipc");
+    if (span.active()) {
+        span.setDetail(args.join(' ').toStdString());
+    }
+    
+    // Starting and running share the request's timeout
+    QElapsedTimer timer;
+    timer.start();
     QProcess process;
     process.start("hyprctl", args);
-    process.waitForFinished(3000);
     
-    QString output = process.readAllStandardOutput();
-    QString errorOutput = process.readAllStandardError();
+    IpcReply reply;
+    if (!process.waitForStarted(timeoutMs)) {
+        process.kill();
+        process.waitForFinished(100);
+        reply.status = IpcStatus::NoSocket;
+        return reply;
+    }
+    if (!process.waitForFinished(qMax(1, timeoutMs - static_cast<int>(timer.elapsed())))) {
+        process.kill();
+        process.waitForFinished(100);
+        reply.status = IpcStatus::Timeout;
+        return reply;
+    }
     
     if (process.exitCode() != 0) {
-        qWarning() << "hyprctl error (exit code" << process.exitCode() << "):" << errorOutput;
-        return errorOutput; // Return error output so we can check for error patterns
+        reply.data = process.readAllStandardError();
+        qWarning() << "hyprctl error (exit code" << process.exitCode() << "):" << reply.data;
+        reply.status = IpcStatus::CommandError;
+        return reply;
     }
     
-    return output;
+    reply.data = process.readAllStandardOutput();
+    reply.status = IpcStatus::Ok;
+    return reply;
 }
 
-QString HyprlandAPI::executeHyprlandCommand(const QString &command) const
+IpcReply HyprlandAPI::executeHyprlandCommand(const QString &command) const
 {
-    return executeHyprctlCommand(QStringList() << "dispatch" << command);
+    return executeRequest(QString("dispatch %1").arg(command), IpcFormat::Ack);
 }
 
-QVariantMap HyprlandAPI::parseJsonOutput(const QString &output) const
+QList<IpcReply> HyprlandAPI::executeBatch(const QStringList &commands, IpcFormat format) const
 {
-    QJsonDocument doc = QJsonDocument::fromJson(output.toUtf8());
+    QList<IpcReply> replies = sendBatch(commands, format);
+    if (m_flightRecord) {
+        const QByteArray text = commands.join(';').toUtf8();
+        std::string statuses;
+        for (const IpcReply &reply : replies) {
+            if (!statuses.empty()) {
+                statuses += ',';
+            }
+            statuses += ipcStatusName(reply.status);
+        }
+        m_flightRecord->appendRequest(text.constData(), text.size(), statuses.c_str());
+    }
+    return replies;
+}
+
+QList<IpcReply> HyprlandAPI::sendBatch(const QStringList &commands, IpcFormat format, int maxTimeoutMs) const
+{
+    IpcReply reply;
+    int timeoutMs;
+    if (!admitRequest(timeoutMs, reply.status, maxTimeoutMs)) {
+        qWarning() << "Not sending a batch of" << commands.size() << "(" << ipcStatusName(reply.status) << ")";
+        countIpcError(reply.status);
+        return HyprlandIPC::splitBatchReply(reply, commands.size(), format);
+    }
     
-    if (doc.isObject()) {
-        return doc.object().toVariantMap();
+    Metrics::Timer metricsTimer("hypr_grid_ipc_request_duration_seconds", "command", "batch");
+    if (m_ipc.isAvailable()) {
+        QElapsedTimer timer;
+        timer.start();
+        QList<IpcReply> replies = m_ipc.batch(commands, format, timeoutMs);
+        if (!replies.isEmpty() && replies.first().ok()) {
+            noteResponseTime(timer.nsecsElapsed());
+        }
+        if (replies.isEmpty() || replies.first().status != IpcStatus::NoSocket) {
+            noteOutcome(replies.isEmpty() ? IpcStatus::IoError : replies.first().status, timeoutMs);
+            countIpcError(replies.isEmpty() ? IpcStatus::IoError : replies.first().status);
+            return replies;
+        }
+        qWarning() << "Hyprland socket unavailable, falling back to hyprctl --batch";
     }
     
-    return QVariantMap();
+    reply = runHyprctl(QStringList() << "--batch" << QString::fromUtf8(HyprlandIPC::batchBody(commands, format)),
+                       timeoutMs);
+    noteOutcome(reply.status, timeoutMs);
+    countIpcError(reply.status);
+    return HyprlandIPC::splitBatchReply(reply, commands.size(), format);
 }
 
-QString HyprlandAPI::generateWindowRuleIdentifier() const
+std::string HyprlandAPI::monitorCacheSession() const
 {
-    // Generate a unique identifier for window rules
-    return QString("gridmgr_%1").arg(QUuid::createUuid().toString(QUuid::WithoutBraces).left(8));
+    // Only for instances reached over the socket; its identity is part of the key
+    if (!m_ipc.isAvailable()) {
+        return std::string();
+    }
+    return MonitorCache::sessionKey(qEnvironmentVariable("HYPRLAND_INSTANCE_SIGNATURE").toStdString(),
+                                    QFile::encodeName(m_ipc.socketPath()).toStdString());
 }
 
-bool HyprlandAPI::positionTiledWindow(int x, int y, int width, int height)
+void HyprlandAPI::invalidateMonitorCache()
 {
-    // Make sure we're initialized
-    if (!m_initialized) {
-        emit errorOccurred("HyprlandAPI not initialized");
-        return false;
+    // Not trusted again by this process, even if another one rewrites it
+    m_monitorCacheDisabled = true;
+    MonitorCache().invalidate();
+}
+
+bool HyprlandAPI::readSnapshot(PlacementState &state)
+{
+    // Mapped once per process; every read after that is plain memory access
+    if (!m_snapshotOpened) {
+        m_snapshotOpened = true;
+        m_snapshot = new StateSnapshotReader;
+        if (!m_snapshot->open(DaemonProtocol::runtimeFilePath(".state"))) {
+            delete m_snapshot;
+            m_snapshot = nullptr;
+        }
     }
-    
-    // Update current window information and get initial state
-    QVariantMap windowData = getFocusedWindowData();
-    if (windowData.isEmpty()) {
-        emit errorOccurred("No focused window");
+    if (!m_snapshot) {
         return false;
     }
     
-    m_currentWindowAddress = windowData["address"].toString();
-    
-    // Log initial window state
-    QJsonObject at = windowData["at"].toJsonObject();
-    QJsonObject size = windowData["size"].toJsonObject();
-    qDebug() << "BEFORE positioning:";
-    qDebug() << "  Position: [" << at["x"].toInt() << "," << at["y"].toInt() << "]";
-    qDebug() << "  Size: [" << size["x"].toInt() << "," << size["y"].toInt() << "]";
-    qDebug() << "  Floating:" << windowData["floating"].toBool();
-    
-    // For precise positioning in tiling mode, we need to temporarily make the window floating
-    // and then use exact positioning. The window will remain functionally "tiled" from the 
-    // user's perspective but use floating for exact positioning.
-    
-    // First, ensure window is floating for precise positioning
-    bool wasFloating = isWindowFloating();
-    if (!wasFloating) {
-        if (!toggleFloating()) {
-            emit errorOccurred("Failed to make window floating for positioning");
-            return false;
-        }
-    }
-    
-    // Apply the exact position using floating window commands
-    QString moveCmd = QString("movewindowpixel exact %1 %2,address:%3")
-        .arg(x).arg(y).arg(m_currentWindowAddress);
-    
-    QString resizeCmd = QString("resizewindowpixel exact %1 %2,address:%3")
-        .arg(width).arg(height).arg(m_currentWindowAddress);
-    
-    QString moveResult = executeHyprlandCommand(moveCmd);
-    QString resizeResult = executeHyprlandCommand(resizeCmd);
-    
-    // Check for errors
-    bool moveSuccess = moveResult.trimmed().isEmpty() || 
-                       (!moveResult.contains("error", Qt::CaseInsensitive) && 
-                        !moveResult.contains("failed", Qt::CaseInsensitive));
-    bool resizeSuccess = resizeResult.trimmed().isEmpty() || 
-                         (!resizeResult.contains("error", Qt::CaseInsensitive) && 
-                          !resizeResult.contains("failed", Qt::CaseInsensitive));
-    
-    // Get final window state to verify the changes
-    QVariantMap finalWindowData = getFocusedWindowData();
-    if (!finalWindowData.isEmpty()) {
-        QJsonObject finalAt = finalWindowData["at"].toJsonObject();
-        QJsonObject finalSize = finalWindowData["size"].toJsonObject();
-        qDebug() << "AFTER positioning:";
-        qDebug() << "  Position: [" << finalAt["x"].toInt() << "," << finalAt["y"].toInt() << "]";
-        qDebug() << "  Size: [" << finalSize["x"].toInt() << "," << finalSize["y"].toInt() << "]";
-        qDebug() << "  Floating:" << finalWindowData["floating"].toBool();
-        qDebug() << "  Target was: [" << x << "," << y << "] size [" << width << "," << height << "]";
-        
-        // Check if position changed as expected
-        int actualX = finalAt["x"].toInt();
-        int actualY = finalAt["y"].toInt();
-        int actualW = finalSize["x"].toInt();
-        int actualH = finalSize["y"].toInt();
-        
-        bool positionMatch = (abs(actualX - x) <= 5) && (abs(actualY - y) <= 5);
-        bool sizeMatch = (abs(actualW - width) <= 10) && (abs(actualH - height) <= 10);
-        
-        if (positionMatch && sizeMatch) {
-            qDebug() << "✓ Window positioning successful!";
-        } else {
-            qDebug() << "⚠ Window positioning may have issues:";
-            if (!positionMatch) {
-                qDebug() << "  Position mismatch: got [" << actualX << "," << actualY << "] expected [" << x << "," << y << "]";
-            }
-            if (!sizeMatch) {
-                qDebug() << "  Size mismatch: got [" << actualW << "," << actualH << "] expected [" << width << "," << height << "]";
-            }
-        }
+    TRACE_SPAN("state.snapshot", "state");
+    SnapshotState snapshot;
+    StateSnapshotReader::Result result = m_snapshot->read(snapshot);
+    if (result != StateSnapshotReader::Fresh) {
+        qDebug() << "State snapshot not used:" << StateSnapshotReader::resultName(result);
+        return false;
     }
     
-    return moveSuccess && resizeSuccess;
+    state.window = snapshot.window;
+    state.monitor = snapshot.monitor;
+    state.workspaceId = snapshot.workspaceId;
+    state.workspaceWindowCount = snapshot.workspaceWindowCount;
+    state.valid = state.window.valid();
+    return state.valid;
 }
 
-int HyprlandAPI::getCurrentWorkspaceId()
+void HyprlandAPI::noteResponseTime(qint64 elapsedNs) const
 {
-    QString output = executeHyprctlCommand(QStringList() << "activeworkspace" << "-j");
-    QJsonDocument doc = QJsonDocument::fromJson(output.toUtf8());
-    
-    if (!doc.isObject()) {
-        emit errorOccurred("Failed to parse active workspace data");
-        return -1;
+    const double sample = elapsedNs / 1e6;
+    if (m_responseTimeMs < 0) {
+        m_responseTimeMs = sample;
+        m_responseDeviationMs = sample / 2;
+        return;
     }
     
-    return doc.object()["id"].toInt();
+    // Gains of 1/8 and 1/4, as in RFC 6298
+    m_responseDeviationMs += (std::abs(m_responseTimeMs - sample) - m_responseDeviationMs) / 4;
+    m_responseTimeMs += (sample - m_responseTimeMs) / 8;
 }
+
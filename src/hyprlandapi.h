@@ -2,12 +2,54 @@
 #define HYPRLANDAPI_H
 
 #include <QObject>
-#include <QProcess>
-#include <QVariantMap>
-#include <QJsonObject>
-#include <QJsonArray>
 #include <QTemporaryFile>
 
+#include "hyprlandipc.h"
+#include "hyprlandjson.h"
+#include "windowrules.h"
+#include "deadline.h"
+
+class HyprlandState;
+class Notifier;
+class StateSnapshotReader;
+struct FlightRecord;
+
+// Everything one placement needs to know, fetched in a single batched query
+struct PlacementState {
+    WindowInfo window;              // Focused window (activewindow)
+    MonitorInfo monitor;            // Focused monitor
+    int workspaceId = -1;           // Active workspace
+    int workspaceWindowCount = 0;   // Windows on the active workspace
+    bool monitorCached = false;     // Monitor geometry came from the monitor cache
+    bool valid = false;
+    
+    QString windowAddress() const
+    {
+        return window.valid() ? QString::fromStdString(HyprlandJson::formatAddress(window.address)) : QString();
+    }
+};
+
+// Outcome of a batched placement, one status per dispatch
+struct PlacementResult {
+    bool toggled = false;                           // A togglefloating was part of the batch
+    IpcStatus toggleStatus = IpcStatus::Ok;
+    IpcStatus moveStatus = IpcStatus::NoSocket;
+    IpcStatus resizeStatus = IpcStatus::NoSocket;
+    
+    bool ok() const
+    {
+        return toggleStatus == IpcStatus::Ok && moveStatus == IpcStatus::Ok
+            && resizeStatus == IpcStatus::Ok;
+    }
+};
+
+// Outcome of a floating toggle that waits for Hyprland's confirmation
+struct FloatingToggle {
+    IpcStatus status = IpcStatus::NoSocket;   // Status of the togglefloating dispatch
+    bool confirmed = false;                   // Hyprland reported the new state in time
+    bool floating = false;                    // Confirmed floating state
+};
+
 class HyprlandAPI : public QObject
 {
     Q_OBJECT
@@ -16,44 +58,111 @@ public:
     explicit HyprlandAPI(QObject *parent = nullptr);
     ~HyprlandAPI();
     
-    // Initialization
+    // Initialization: checks that Hyprland is reachable, without any IPC
     bool initialize();
+    bool isInitialized() const { return m_initialized; }
+    
+    // Answer state queries from an event-driven mirror when it can
+    void setStateMirror(HyprlandState *state) { m_state = state; }
+    
+    // Core window management functions. They target one window by address,
+    // never whichever window happens to be focused when they run.
+    bool moveAndResizeWindow(const QString &address, int x, int y, int width, int height);
     
-    // Core window management functions
-    bool moveAndResizeWindow(int x, int y, int width, int height);
-    bool positionTiledWindow(int x, int y, int width, int height);
-    bool toggleFloating();
-    bool isWindowFloating();
-    bool applyWindowRules(int x, int y, int width, int height);
+    // Toggle floating for one window and wait, up to timeoutMs, for the
+    // changefloatingmode event instead of sleeping and polling
+    FloatingToggle toggleFloatingAndWait(const QString &address, int timeoutMs);
+    
+    // Batched placement pipeline: one query round-trip, one dispatch round-trip
+    PlacementState queryPlacementState();
+    PlacementResult applyPlacement(const QString &address, int x, int y, int width, int height,
+                                   bool makeFloating);
     bool clearWindowRules();
     
+    // Mismatch signal for the monitor cache: drop it and query the monitors
+    // for the rest of this process
+    void invalidateMonitorCache();
+    
     // Hyprland information functions
-    QVariantMap getFocusedWindowData();
-    QVariantMap getFocusedMonitorData();
-    QVariantMap getWorkspaceData();
-    int getCurrentWorkspaceId();
-    QStringList getMonitors();
+    QString activeWindowAddress();
+    bool getWindowInfo(const QString &address, WindowInfo &window);
+    
+    // Batched JSON queries outside any apply, such as the state mirror's
+    // reload. Held to the breaker like every other request and to at most
+    // `timeoutMs`, since the caller runs on the event loop.
+    QList<IpcReply> queryBatch(const QStringList &queries, int timeoutMs) const;
+    
+    // Smoothed round-trip time of successful requests and its mean
+    // deviation, estimated like TCP's RTT (RFC 6298). Negative until the
+    // first request completed.
+    double responseTimeMs() const { return m_responseTimeMs; }
+    double responseDeviationMs() const { return m_responseDeviationMs; }
+    
+    // Deadline of the current apply. Every request, hyprctl run and event
+    // wait is bounded by what is left of it; none is set outside an apply.
+    void setDeadline(const Deadline &deadline) { m_deadline = deadline; }
+    const Deadline &deadline() const { return m_deadline; }
+    
+    // Fail fast after `threshold` timeouts in a row, for `cooldownMs`
+    void configureBreaker(int threshold, int cooldownMs) { m_breaker.configure(threshold, cooldownMs); }
+    const CircuitBreaker &breaker() const { return m_breaker; }
     
-    // Notification function
+    // Requests not sent or cut short because the deadline ran out
+    quint64 expiredRequests() const { return m_expiredRequests; }
+    
+    // Flight record of the current apply; every request made while it is
+    // set is appended to it with its reply status
+    void setFlightRecord(FlightRecord *record) { m_flightRecord = record; }
+    FlightRecord *flightRecord() const { return m_flightRecord; }
+    
+    // Desktop notification, sent asynchronously; rapid calls update one bubble
     bool sendNotification(const QString &title, const QString &message, int timeout = 3000);
     
 signals:
     void errorOccurred(const QString &message);
     
 private:
-    // Helper methods for executing Hyprland commands
-    QString executeHyprctlCommand(const QStringList &args) const;
-    QString executeHyprlandCommand(const QString &command) const;
+    // Helper methods for executing Hyprland commands. Requests go over the
+    // control socket; hyprctl is only spawned when the socket is unusable.
+    IpcReply executeRequest(const QString &command, IpcFormat format) const;
+    IpcReply executeHyprctlCommand(const QString &command, IpcFormat format, int timeoutMs) const;
+    IpcReply runHyprctl(const QStringList &args, int timeoutMs) const;
+    IpcReply executeHyprlandCommand(const QString &command) const;
+    QList<IpcReply> executeBatch(const QStringList &commands, IpcFormat format) const;
+    IpcReply sendRequest(const QString &command, IpcFormat format) const;
+    QList<IpcReply> sendBatch(const QStringList &commands, IpcFormat format, int maxTimeoutMs = -1) const;
+    
+    // Placement state published by a running daemon, if it is fresh
+    bool readSnapshot(PlacementState &state);
+    std::string monitorCacheSession() const;
+    void noteResponseTime(qint64 elapsedNs) const;
+    
+    // Deadline and breaker around every request: the timeout to use, or
+    // false with the status of a request that must not go out.
+    // `maxTimeoutMs` shortens the usual per-request limit.
+    bool admitRequest(int &timeoutMs, IpcStatus &refusal, int maxTimeoutMs = -1) const;
+    void noteOutcome(IpcStatus status, int timeoutMs) const;
+    
+    // Send pending rule changes as one batched keyword update
+    bool syncWindowRules();
+    WindowRuleSet m_windowRules;
+    
+    // Control socket client
+    HyprlandIPC m_ipc;
+    HyprlandState *m_state;
+    Notifier *m_notifier;
+    StateSnapshotReader *m_snapshot;
+    bool m_snapshotOpened;
+    bool m_monitorCacheDisabled;
     
-    // Parse JSON results from hyprctl
-    QVariantMap parseJsonOutput(const QString &output) const;
+    mutable double m_responseTimeMs;
+    mutable double m_responseDeviationMs;
     
-    // Generate unique window rules
-    QString generateWindowRuleIdentifier() const;
-    QString m_currentWindowRuleIdentifier;
+    Deadline m_deadline;
+    mutable CircuitBreaker m_breaker;
+    mutable quint64 m_expiredRequests;
+    FlightRecord *m_flightRecord;
     
-    // Store current window information
-    QString m_currentWindowAddress;
     bool m_initialized;
 };
 
@@ -0,0 +1,341 @@
+#include "hyprlandipc.h"
+#include "trace.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <QDebug>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+namespace {
+
+// Wait until the socket is ready for the given events or the deadline passes
+bool waitForSocket(int fd, short events, const QElapsedTimer &timer, int timeoutMs)
+{
+    while (true) {
+        int remaining = timeoutMs - static_cast<int>(timer.elapsed());
+        if (remaining <= 0) {
+            return false;
+        }
+        
+        pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = events;
+        pfd.revents = 0;
+        
+        int ready = ::poll(&pfd, 1, remaining);
+        if (ready > 0) {
+            return true;
+        }
+        if (ready < 0 && errno != EINTR) {
+            return false;
+        }
+    }
+}
+
+} // namespace
+
+const char *ipcStatusName(IpcStatus status)
+{
+    switch (status) {
+    case IpcStatus::Ok:           return "ok";
+    case IpcStatus::CommandError: return "command error";
+    case IpcStatus::NoSocket:     return "no socket";
+    case IpcStatus::Timeout:      return "timeout";
+    case IpcStatus::IoError:      return "io error";
+    case IpcStatus::Expired:      return "deadline expired";
+    case IpcStatus::CircuitOpen:  return "circuit open";
+    }
+    return "unknown";
+}
+
+HyprlandIPC::HyprlandIPC()
+    : m_socketPath(instanceSocketPath(".socket.sock"))
+{
+}
+
+QString HyprlandIPC::instanceSocketPath(const QString &socketName)
+{
+    const QString signature = qEnvironmentVariable("HYPRLAND_INSTANCE_SIGNATURE");
+    if (signature.isEmpty()) {
+        return QString();
+    }
+    
+    QStringList candidates;
+    const QString runtimeDir = qEnvironmentVariable("XDG_RUNTIME_DIR");
+    if (!runtimeDir.isEmpty()) {
+        candidates << QString("%1/hypr/%2/%3").arg(runtimeDir, signature, socketName);
+    }
+    // Hyprland before 0.40 kept its sockets under /tmp
+    candidates << QString("/tmp/hypr/%1/%2").arg(signature, socketName);
+    
+    for (const QString &path : candidates) {
+        if (QFileInfo::exists(path)) {
+            return path;
+        }
+    }
+    
+    return QString();
+}
+
+int HyprlandIPC::connectSocket(const QString &path)
+{
+    const QByteArray encoded = QFile::encodeName(path);
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (encoded.isEmpty() || static_cast<size_t>(encoded.size()) >= sizeof(addr.sun_path)) {
+        qWarning() << "Invalid socket path:" << path;
+        return -1;
+    }
+    memcpy(addr.sun_path, encoded.constData(), encoded.size());
+    
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    
+    if (::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    
+    return fd;
+}
+
+IpcStatus HyprlandIPC::classifyReply(const QByteArray &data, IpcFormat format)
+{
+    const QByteArray trimmed = data.trimmed();
+    
+    if (format == IpcFormat::Json) {
+        bool isJson = trimmed.startsWith('{') || trimmed.startsWith('[');
+        return isJson ? IpcStatus::Ok : IpcStatus::CommandError;
+    }
+    
+    return trimmed == "ok" ? IpcStatus::Ok : IpcStatus::CommandError;
+}
+
+IpcReply HyprlandIPC::request(const QString &command, IpcFormat format, int timeoutMs) const
+{
+    QByteArray payload = command.toUtf8();
+    if (format == IpcFormat::Json) {
+        payload.prepend("j/");
+    }
+    
+    IpcReply reply = requestRaw(payload, timeoutMs);
+    if (reply.status == IpcStatus::Ok) {
+        reply.status = classifyReply(reply.data, format);
+    }
+    
+    return reply;
+}
+
+QList<IpcReply> HyprlandIPC::batch(const QStringList &commands, IpcFormat format, int timeoutMs) const
+{
+    if (commands.isEmpty()) {
+        return QList<IpcReply>();
+    }
+    
+    IpcReply reply = requestRaw("[[BATCH]]" + batchBody(commands, format), timeoutMs);
+    return splitBatchReply(reply, commands.size(), format);
+}
+
+QByteArray HyprlandIPC::batchBody(const QStringList &commands, IpcFormat format)
+{
+    QByteArray body;
+    for (const QString &command : commands) {
+        if (!body.isEmpty()) {
+            body.append(';');
+        }
+        if (format == IpcFormat::Json) {
+            body.append("j/");
+        }
+        body.append(command.toUtf8());
+    }
+    return body;
+}
+
+QList<IpcReply> HyprlandIPC::splitBatchReply(const IpcReply &reply, int count, IpcFormat format)
+{
+    QList<IpcReply> replies;
+    replies.reserve(count);
+    
+    // A failed transfer fails every command in the batch
+    if (reply.status != IpcStatus::Ok) {
+        for (int i = 0; i < count; ++i) {
+            IpcReply failed;
+            failed.status = reply.status;
+            failed.data = reply.data;
+            replies.append(failed);
+        }
+        return replies;
+    }
+    
+    // Hyprland separates the individual replies with three newlines
+    static const QByteArray delimiter("\n\n\n");
+    qsizetype start = 0;
+    while (replies.size() < count) {
+        qsizetype end = reply.data.indexOf(delimiter, start);
+        
+        IpcReply part;
+        if (start <= reply.data.size()) {
+            part.data = reply.data.mid(start, end < 0 ? -1 : end - start);
+            part.status = classifyReply(part.data, format);
+        } else {
+            // Fewer replies than commands, Hyprland did not run the rest
+            part.status = IpcStatus::CommandError;
+        }
+        replies.append(part);
+        
+        start = end < 0 ? reply.data.size() + 1 : end + delimiter.size();
+    }
+    
+    return replies;
+}
+
+IpcReply HyprlandIPC::requestRaw(const QByteArray &payload, int timeoutMs) const
+{
+    Trace::Span span("ipc.request", "ipc");
+    if (span.active()) {
+        span.setDetail(payload.toStdString());
+    }
+    
+    IpcReply reply;
+    
+    if (m_socketPath.isEmpty()) {
+        reply.status = IpcStatus::NoSocket;
+        return reply;
+    }
+    
+    int fd = connectSocket(m_socketPath);
+    if (fd < 0) {
+        reply.status = IpcStatus::NoSocket;
+        return reply;
+    }
+    
+    // Switch to non-blocking so a stuck compositor cannot hang us past the timeout
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+    
+    QElapsedTimer timer;
+    timer.start();
+    
+    qsizetype written = 0;
+    while (written < payload.size()) {
+        ssize_t n = ::write(fd, payload.constData() + written, payload.size() - written);
+        if (n > 0) {
+            written += n;
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+            if (!waitForSocket(fd, POLLOUT, timer, timeoutMs)) {
+                ::close(fd);
+                reply.status = IpcStatus::Timeout;
+                return reply;
+            }
+            continue;
+        }
+        ::close(fd);
+        reply.status = IpcStatus::IoError;
+        return reply;
+    }
+    
+    // Hyprland closes the connection once the full reply is written
+    char buffer[8192];
+    while (true) {
+        ssize_t n = ::read(fd, buffer, sizeof(buffer));
+        if (n > 0) {
+            reply.data.append(buffer, n);
+            continue;
+        }
+        if (n == 0) {
+            break;
+        }
+        if (errno == EAGAIN || errno == EINTR) {
+            if (!waitForSocket(fd, POLLIN, timer, timeoutMs)) {
+                ::close(fd);
+                reply.status = IpcStatus::Timeout;
+                return reply;
+            }
+            continue;
+        }
+        ::close(fd);
+        reply.status = IpcStatus::IoError;
+        return reply;
+    }
+    
+    ::close(fd);
+    reply.status = IpcStatus::Ok;
+    return reply;
+}
+
+HyprlandEventWatch::HyprlandEventWatch()
+    : m_fd(-1)
+{
+    QString path = HyprlandIPC::instanceSocketPath(".socket2.sock");
+    if (!path.isEmpty()) {
+        m_fd = HyprlandIPC::connectSocket(path);
+    }
+    if (m_fd >= 0) {
+        ::fcntl(m_fd, F_SETFL, ::fcntl(m_fd, F_GETFL) | O_NONBLOCK);
+    }
+}
+
+HyprlandEventWatch::~HyprlandEventWatch()
+{
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+}
+
+bool HyprlandEventWatch::waitFor(const QByteArray &name, const QByteArray &dataPrefix, int timeoutMs, QByteArray *data)
+{
+    if (m_fd < 0) {
+        return false;
+    }
+    
+    TRACE_SPAN("ipc.waitEvent", "ipc");
+    const QByteArray prefix = name + ">>" + dataPrefix;
+    QElapsedTimer timer;
+    timer.start();
+    
+    while (true) {
+        // Check complete lines first, anything else that arrived is dropped
+        qsizetype newline;
+        while ((newline = m_buffer.indexOf('\n')) >= 0) {
+            const QByteArray line = m_buffer.left(newline);
+            m_buffer.remove(0, newline + 1);
+            if (line.startsWith(prefix)) {
+                if (data) {
+                    *data = line.mid(name.size() + 2);
+                }
+                return true;
+            }
+        }
+        
+        // A steady stream of other events must not outlast the timeout
+        if (timer.elapsed() >= timeoutMs) {
+            return false;
+        }
+        
+        char chunk[4096];
+        ssize_t n = ::read(m_fd, chunk, sizeof(chunk));
+        if (n > 0) {
+            m_buffer.append(chunk, n);
+            continue;
+        }
+        if (n == 0 || (errno != EAGAIN && errno != EINTR)) {
+            return false;
+        }
+        if (errno == EAGAIN && !waitForSocket(m_fd, POLLIN, timer, timeoutMs)) {
+            return false;
+        }
+    }
+}
@@ -0,0 +1,96 @@
+#ifndef HYPRLANDIPC_H
+#define HYPRLANDIPC_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+// Expected shape of a reply from the Hyprland control socket
+enum class IpcFormat {
+    Json,   // "j/<command>" queries, reply is a JSON document
+    Ack     // dispatch/keyword/reload, reply is "ok" on success
+};
+
+// Outcome of a single request
+enum class IpcStatus {
+    Ok,             // Hyprland accepted the request
+    CommandError,   // Hyprland answered with an error message
+    NoSocket,       // Instance socket missing or refused the connection
+    Timeout,        // No complete reply before the timeout
+    IoError,        // Socket read/write failure
+    Expired,        // Not sent: the apply's deadline had passed
+    CircuitOpen     // Not sent: Hyprland stopped answering recently
+};
+
+struct IpcReply {
+    IpcStatus status = IpcStatus::NoSocket;
+    QByteArray data;
+    
+    bool ok() const { return status == IpcStatus::Ok; }
+};
+
+const char *ipcStatusName(IpcStatus status);
+
+// Minimal client for Hyprland's request socket
+// ($XDG_RUNTIME_DIR/hypr/$HYPRLAND_INSTANCE_SIGNATURE/.socket.sock).
+// Each request opens a connection, writes the command and reads until
+// Hyprland closes the socket, exactly like hyprctl does.
+class HyprlandIPC
+{
+public:
+    HyprlandIPC();
+    
+    bool isAvailable() const { return !m_socketPath.isEmpty(); }
+    QString socketPath() const { return m_socketPath; }
+    
+    // Send a command, prefixing "j/" for JSON queries
+    IpcReply request(const QString &command, IpcFormat format, int timeoutMs = 3000) const;
+    
+    // Send several commands of one format as a single [[BATCH]] request.
+    // Returns one reply per command, in order.
+    QList<IpcReply> batch(const QStringList &commands, IpcFormat format, int timeoutMs = 3000) const;
+    
+    // Send a raw payload and return whatever Hyprland wrote back
+    IpcReply requestRaw(const QByteArray &payload, int timeoutMs = 3000) const;
+    
+    // Join commands into the body of a batch request (without the [[BATCH]] tag)
+    static QByteArray batchBody(const QStringList &commands, IpcFormat format);
+    
+    // Split a batch reply into per-command replies
+    static QList<IpcReply> splitBatchReply(const IpcReply &reply, int count, IpcFormat format);
+    
+    // Resolve a socket of the running instance, empty if it does not exist
+    static QString instanceSocketPath(const QString &socketName);
+    
+    // Open a blocking, close-on-exec connection to a Unix socket, -1 on failure
+    static int connectSocket(const QString &path);
+    
+    // Classify a reply according to the expected format
+    static IpcStatus classifyReply(const QByteArray &data, IpcFormat format);
+    
+private:
+    QString m_socketPath;
+};
+
+// Short-lived subscription to the event socket (.socket2.sock), used to
+// wait for the consequence of a single dispatch. Construct it before
+// sending the dispatch so the event cannot be missed.
+class HyprlandEventWatch
+{
+public:
+    HyprlandEventWatch();
+    ~HyprlandEventWatch();
+    
+    bool isConnected() const { return m_fd >= 0; }
+    
+    // Wait for an event named `name` whose data starts with `dataPrefix`.
+    // Returns false when the deadline passes or the socket closes first.
+    bool waitFor(const QByteArray &name, const QByteArray &dataPrefix, int timeoutMs, QByteArray *data = nullptr);
+    
+private:
+    int m_fd;
+    QByteArray m_buffer;
+};
+
+#endif // HYPRLANDIPC_H
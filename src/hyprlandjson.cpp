@@ -0,0 +1,576 @@
+#include "hyprlandjson.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+// Forward-only cursor over a JSON reply. Every read method consumes one
+// value and returns false on malformed input; nothing is buffered, so
+// values we do not care about cost one pass over their bytes.
+class Reader
+{
+public:
+    explicit Reader(std::string_view json)
+        : m_pos(json.data()), m_end(json.data() + json.size())
+    {
+    }
+    
+    void skipWhitespace()
+    {
+        while (m_pos < m_end && (*m_pos == ' ' || *m_pos == '\n' || *m_pos == '\r' || *m_pos == '\t')) {
+            ++m_pos;
+        }
+    }
+    
+    bool consume(char c)
+    {
+        skipWhitespace();
+        if (m_pos < m_end && *m_pos == c) {
+            ++m_pos;
+            return true;
+        }
+        return false;
+    }
+    
+    bool peek(char c)
+    {
+        skipWhitespace();
+        return m_pos < m_end && *m_pos == c;
+    }
+    
+    // Raw bytes between the quotes; escapes are left as they are
+    bool readRawString(std::string_view &out)
+    {
+        if (!consume('"')) {
+            return false;
+        }
+        const char *begin = m_pos;
+        while (true) {
+            const void *quote = memchr(m_pos, '"', static_cast<size_t>(m_end - m_pos));
+            if (!quote) {
+                m_pos = m_end;
+                return false;
+            }
+            m_pos = static_cast<const char *>(quote);
+            
+            // Escaped when preceded by an odd number of backslashes
+            const char *backslash = m_pos;
+            while (backslash > begin && backslash[-1] == '\\') {
+                --backslash;
+            }
+            if ((m_pos - backslash) % 2 == 0) {
+                break;
+            }
+            ++m_pos;
+        }
+        out = std::string_view(begin, static_cast<size_t>(m_pos - begin));
+        ++m_pos;
+        return true;
+    }
+    
+    bool readString(std::string &out)
+    {
+        std::string_view raw;
+        if (!readRawString(raw)) {
+            return false;
+        }
+        out.clear();
+        if (memchr(raw.data(), '\\', raw.size()) == nullptr) {
+            out.assign(raw.data(), raw.size());
+            return true;
+        }
+        return unescape(raw, out);
+    }
+    
+    bool readInt(int &out)
+    {
+        long long value = 0;
+        if (!readInteger(value)) {
+            return false;
+        }
+        out = static_cast<int>(value);
+        return true;
+    }
+    
+    // Hyprland prints floats with a fixed number of decimals. Parsed by hand
+    // because strtod follows LC_NUMERIC, which Qt sets from the environment.
+    bool readDouble(double &out)
+    {
+        skipWhitespace();
+        bool negative = m_pos < m_end && *m_pos == '-';
+        if (negative) {
+            ++m_pos;
+        }
+        if (m_pos >= m_end || *m_pos < '0' || *m_pos > '9') {
+            return false;
+        }
+        
+        double value = 0.0;
+        while (m_pos < m_end && *m_pos >= '0' && *m_pos <= '9') {
+            value = value * 10.0 + (*m_pos++ - '0');
+        }
+        if (m_pos < m_end && *m_pos == '.') {
+            ++m_pos;
+            double scale = 0.1;
+            while (m_pos < m_end && *m_pos >= '0' && *m_pos <= '9') {
+                value += (*m_pos++ - '0') * scale;
+                scale *= 0.1;
+            }
+        }
+        if (m_pos < m_end && (*m_pos == 'e' || *m_pos == 'E')) {
+            ++m_pos;
+            bool negativeExponent = m_pos < m_end && *m_pos == '-';
+            if (m_pos < m_end && (*m_pos == '-' || *m_pos == '+')) {
+                ++m_pos;
+            }
+            int exponent = 0;
+            while (m_pos < m_end && *m_pos >= '0' && *m_pos <= '9') {
+                exponent = exponent * 10 + (*m_pos++ - '0');
+            }
+            for (int i = 0; i < exponent; ++i) {
+                value = negativeExponent ? value / 10.0 : value * 10.0;
+            }
+        }
+        
+        out = negative ? -value : value;
+        return true;
+    }
+    
+    bool readBool(bool &out)
+    {
+        skipWhitespace();
+        if (matchLiteral("true")) {
+            out = true;
+            return true;
+        }
+        if (matchLiteral("false")) {
+            out = false;
+            return true;
+        }
+        return false;
+    }
+    
+    // Skip one value of any type, including nested objects and arrays
+    bool skipValue()
+    {
+        skipWhitespace();
+        if (m_pos >= m_end) {
+            return false;
+        }
+        
+        switch (*m_pos) {
+        case '"': {
+            std::string_view ignored;
+            return readRawString(ignored);
+        }
+        case '{':
+        case '[': {
+            int depth = 0;
+            while (m_pos < m_end) {
+                char c = *m_pos;
+                if (c == '"') {
+                    std::string_view ignored;
+                    if (!readRawString(ignored)) {
+                        return false;
+                    }
+                    continue;
+                }
+                ++m_pos;
+                if (c == '{' || c == '[') {
+                    ++depth;
+                } else if ((c == '}' || c == ']') && --depth == 0) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        case 't':
+        case 'f': {
+            bool ignored;
+            return readBool(ignored);
+        }
+        case 'n':
+            return matchLiteral("null");
+        default: {
+            const char *begin = m_pos;
+            while (m_pos < m_end && (*m_pos == '-' || *m_pos == '+' || *m_pos == '.' ||
+                                     *m_pos == 'e' || *m_pos == 'E' || (*m_pos >= '0' && *m_pos <= '9'))) {
+                ++m_pos;
+            }
+            return m_pos != begin;
+        }
+        }
+    }
+    
+    // Call onField(key) for every member; it must consume the value
+    template<typename Handler>
+    bool readObject(Handler &&onField)
+    {
+        if (!consume('{')) {
+            return false;
+        }
+        if (consume('}')) {
+            return true;
+        }
+        do {
+            std::string_view key;
+            if (!readRawString(key) || !consume(':') || !onField(key)) {
+                return false;
+            }
+        } while (consume(','));
+        return consume('}');
+    }
+    
+    // Call onElement() for every element; it must consume the value
+    template<typename Handler>
+    bool readArray(Handler &&onElement)
+    {
+        if (!consume('[')) {
+            return false;
+        }
+        if (consume(']')) {
+            return true;
+        }
+        do {
+            if (!onElement()) {
+                return false;
+            }
+        } while (consume(','));
+        return consume(']');
+    }
+    
+    // Two-element arrays such as "at" and "size"
+    bool readIntPair(int &first, int &second)
+    {
+        return consume('[') && readInt(first) && consume(',') && readInt(second) && consume(']');
+    }
+    
+    // Nested {"id": N, ...} objects such as a client's "workspace"
+    bool readIdObject(int &id)
+    {
+        return readObject([&](std::string_view key) {
+            return key == "id" ? readInt(id) : skipValue();
+        });
+    }
+    
+    bool atEnd()
+    {
+        skipWhitespace();
+        return m_pos >= m_end;
+    }
+    
+private:
+    bool readInteger(long long &out)
+    {
+        skipWhitespace();
+        bool negative = m_pos < m_end && *m_pos == '-';
+        if (negative) {
+            ++m_pos;
+        }
+        if (m_pos >= m_end || *m_pos < '0' || *m_pos > '9') {
+            return false;
+        }
+        long long value = 0;
+        while (m_pos < m_end && *m_pos >= '0' && *m_pos <= '9') {
+            value = value * 10 + (*m_pos++ - '0');
+        }
+        // Tolerate a fractional part where an integer was expected
+        if (m_pos < m_end && *m_pos == '.') {
+            ++m_pos;
+            while (m_pos < m_end && *m_pos >= '0' && *m_pos <= '9') {
+                ++m_pos;
+            }
+        }
+        out = negative ? -value : value;
+        return true;
+    }
+    
+    bool matchLiteral(std::string_view literal)
+    {
+        if (static_cast<size_t>(m_end - m_pos) < literal.size() ||
+            std::string_view(m_pos, literal.size()) != literal) {
+            return false;
+        }
+        m_pos += literal.size();
+        return true;
+    }
+    
+    static int hexValue(char c)
+    {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+    
+    static bool readHex4(std::string_view raw, size_t at, unsigned &out)
+    {
+        if (at + 4 > raw.size()) {
+            return false;
+        }
+        out = 0;
+        for (size_t i = at; i < at + 4; ++i) {
+            int digit = hexValue(raw[i]);
+            if (digit < 0) {
+                return false;
+            }
+            out = (out << 4) | static_cast<unsigned>(digit);
+        }
+        return true;
+    }
+    
+    static void appendUtf8(std::string &out, unsigned codepoint)
+    {
+        if (codepoint < 0x80) {
+            out += static_cast<char>(codepoint);
+        } else if (codepoint < 0x800) {
+            out += static_cast<char>(0xC0 | (codepoint >> 6));
+            out += static_cast<char>(0x80 | (codepoint & 0x3F));
+        } else if (codepoint < 0x10000) {
+            out += static_cast<char>(0xE0 | (codepoint >> 12));
+            out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codepoint & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (codepoint >> 18));
+            out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codepoint & 0x3F));
+        }
+    }
+    
+    static bool unescape(std::string_view raw, std::string &out)
+    {
+        out.reserve(raw.size());
+        for (size_t i = 0; i < raw.size(); ++i) {
+            if (raw[i] != '\\') {
+                out += raw[i];
+                continue;
+            }
+            if (++i >= raw.size()) {
+                return false;
+            }
+            switch (raw[i]) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                unsigned codepoint;
+                if (!readHex4(raw, i + 1, codepoint)) {
+                    return false;
+                }
+                i += 4;
+                // Surrogate pair
+                unsigned low;
+                if (codepoint >= 0xD800 && codepoint < 0xDC00 && i + 2 < raw.size() &&
+                    raw[i + 1] == '\\' && raw[i + 2] == 'u' && readHex4(raw, i + 3, low) &&
+                    low >= 0xDC00 && low < 0xE000) {
+                    codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                    i += 6;
+                }
+                appendUtf8(out, codepoint);
+                break;
+            }
+            default:
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    const char *m_pos;
+    const char *m_end;
+};
+
+bool readWindow(Reader &reader, WindowInfo &window, int fields)
+{
+    const bool geometry = fields & HyprlandJson::WindowGeometry;
+    const bool strings = fields & HyprlandJson::WindowStrings;
+    
+    // Reset in place so reused strings keep their capacity
+    window.address = 0;
+    window.x = window.y = window.width = window.height = 0;
+    window.workspaceId = 0;
+    window.monitorId = -1;
+    window.floating = false;
+    window.mapped = false;
+    window.windowClass.clear();
+    window.title.clear();
+    
+    return reader.readObject([&](std::string_view key) {
+        if (key == "address") {
+            std::string_view address;
+            if (!reader.readRawString(address)) {
+                return false;
+            }
+            window.address = HyprlandJson::parseAddress(address);
+            return true;
+        }
+        if (key == "workspace") {
+            return reader.readIdObject(window.workspaceId);
+        }
+        if (key == "floating") {
+            return reader.readBool(window.floating);
+        }
+        if (key == "mapped") {
+            return reader.readBool(window.mapped);
+        }
+        if (geometry) {
+            if (key == "at") {
+                return reader.readIntPair(window.x, window.y);
+            }
+            if (key == "size") {
+                return reader.readIntPair(window.width, window.height);
+            }
+            if (key == "monitor" && !reader.peek('"')) {
+                return reader.readInt(window.monitorId);
+            }
+        }
+        if (strings) {
+            if (key == "class") {
+                return reader.readString(window.windowClass);
+            }
+            if (key == "title") {
+                return reader.readString(window.title);
+            }
+        }
+        return reader.skipValue();
+    });
+}
+
+bool readMonitor(Reader &reader, MonitorInfo &monitor)
+{
+    monitor = MonitorInfo();
+    return reader.readObject([&](std::string_view key) {
+        if (key == "id") return reader.readInt(monitor.id);
+        if (key == "name") return reader.readString(monitor.name);
+        if (key == "x") return reader.readInt(monitor.x);
+        if (key == "y") return reader.readInt(monitor.y);
+        if (key == "width") return reader.readInt(monitor.width);
+        if (key == "height") return reader.readInt(monitor.height);
+        if (key == "scale") return reader.readDouble(monitor.scale);
+        if (key == "focused") return reader.readBool(monitor.focused);
+        if (key == "activeWorkspace") return reader.readIdObject(monitor.activeWorkspaceId);
+        if (key == "reserved") {
+            int index = 0;
+            return reader.readArray([&]() {
+                int value = 0;
+                if (!reader.readInt(value)) {
+                    return false;
+                }
+                switch (index++) {
+                case 0: monitor.reservedLeft = value; break;
+                case 1: monitor.reservedTop = value; break;
+                case 2: monitor.reservedRight = value; break;
+                case 3: monitor.reservedBottom = value; break;
+                }
+                return true;
+            });
+        }
+        return reader.skipValue();
+    });
+}
+
+bool readWorkspace(Reader &reader, WorkspaceInfo &workspace)
+{
+    workspace = WorkspaceInfo();
+    return reader.readObject([&](std::string_view key) {
+        if (key == "id") return reader.readInt(workspace.id);
+        if (key == "name") return reader.readString(workspace.name);
+        if (key == "monitor") return reader.readString(workspace.monitor);
+        if (key == "windows") return reader.readInt(workspace.windows);
+        return reader.skipValue();
+    });
+}
+
+} // namespace
+
+namespace HyprlandJson {
+
+bool decodeWindow(std::string_view json, WindowInfo &window, int fields)
+{
+    // activewindow replies with an empty object when nothing is focused
+    Reader reader(json);
+    return readWindow(reader, window, fields) && reader.atEnd();
+}
+
+bool decodeWorkspace(std::string_view json, WorkspaceInfo &workspace)
+{
+    Reader reader(json);
+    return readWorkspace(reader, workspace) && reader.atEnd();
+}
+
+bool decodeMonitors(std::string_view json, std::vector<MonitorInfo> &monitors)
+{
+    monitors.clear();
+    Reader reader(json);
+    return reader.readArray([&]() {
+        monitors.emplace_back();
+        return readMonitor(reader, monitors.back());
+    }) && reader.atEnd();
+}
+
+bool decodeWorkspaces(std::string_view json, std::vector<WorkspaceInfo> &workspaces)
+{
+    workspaces.clear();
+    Reader reader(json);
+    return reader.readArray([&]() {
+        workspaces.emplace_back();
+        return readWorkspace(reader, workspaces.back());
+    }) && reader.atEnd();
+}
+
+bool forEachClient(std::string_view json, const std::function<void(const WindowInfo &)> &callback, int fields)
+{
+    Reader reader(json);
+    WindowInfo window;
+    return reader.readArray([&]() {
+        if (!readWindow(reader, window, fields)) {
+            return false;
+        }
+        callback(window);
+        return true;
+    }) && reader.atEnd();
+}
+
+const MonitorInfo *focusedMonitor(const std::vector<MonitorInfo> &monitors)
+{
+    for (const MonitorInfo &monitor : monitors) {
+        if (monitor.focused) {
+            return &monitor;
+        }
+    }
+    return monitors.empty() ? nullptr : &monitors.front();
+}
+
+uint64_t parseAddress(std::string_view text)
+{
+    if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+        text.remove_prefix(2);
+    }
+    
+    uint64_t address = 0;
+    for (char c : text) {
+        int digit;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+        else return 0;
+        address = (address << 4) | static_cast<uint64_t>(digit);
+    }
+    return address;
+}
+
+std::string formatAddress(uint64_t address)
+{
+    char buffer[24];
+    snprintf(buffer, sizeof(buffer), "0x%llx", static_cast<unsigned long long>(address));
+    return buffer;
+}
+
+} // namespace HyprlandJson
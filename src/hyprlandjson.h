@@ -0,0 +1,84 @@
+#ifndef HYPRLANDJSON_H
+#define HYPRLANDJSON_H
+
+// Typed decoders for Hyprland's JSON replies. They read straight from the
+// reply bytes into plain structs, skip every field we do not use and walk
+// arrays one element at a time instead of building a document. Plain C++
+// so they can be benchmarked and reused outside Qt.
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct WindowInfo {
+    uint64_t address = 0;       // 0 when there is no window
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+    int workspaceId = 0;
+    int monitorId = -1;
+    bool floating = false;
+    bool mapped = false;
+    std::string windowClass;    // Only filled with WindowStrings
+    std::string title;          // Only filled with WindowStrings
+    
+    bool valid() const { return address != 0; }
+};
+
+struct MonitorInfo {
+    int id = -1;
+    std::string name;
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+    double scale = 1.0;
+    int reservedLeft = 0;
+    int reservedTop = 0;
+    int reservedRight = 0;
+    int reservedBottom = 0;
+    int activeWorkspaceId = -1;
+    bool focused = false;
+};
+
+struct WorkspaceInfo {
+    int id = 0;
+    std::string name;
+    std::string monitor;
+    int windows = 0;
+};
+
+namespace HyprlandJson {
+
+// Which window fields to decode; strings are the only part that allocates
+enum WindowFields {
+    WindowGeometry = 0x1,
+    WindowStrings = 0x2,
+    AllWindowFields = WindowGeometry | WindowStrings
+};
+
+// Single objects (activewindow, activeworkspace)
+bool decodeWindow(std::string_view json, WindowInfo &window, int fields = AllWindowFields);
+bool decodeWorkspace(std::string_view json, WorkspaceInfo &workspace);
+
+// Arrays (monitors, workspaces)
+bool decodeMonitors(std::string_view json, std::vector<MonitorInfo> &monitors);
+bool decodeWorkspaces(std::string_view json, std::vector<WorkspaceInfo> &workspaces);
+
+// Stream over a clients reply, reusing one WindowInfo for every element
+bool forEachClient(std::string_view json, const std::function<void(const WindowInfo &)> &callback,
+                   int fields = AllWindowFields);
+
+// Focused monitor, or the first one, or nullptr for an empty list
+const MonitorInfo *focusedMonitor(const std::vector<MonitorInfo> &monitors);
+
+// Window addresses: "0x55d9ab5b1c90" in replies, bare hex in events
+uint64_t parseAddress(std::string_view text);
+std::string formatAddress(uint64_t address);
+
+} // namespace HyprlandJson
+
+#endif // HYPRLANDJSON_H
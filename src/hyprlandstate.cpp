@@ -0,0 +1,599 @@
+#include "hyprlandstate.h"
+#include "eventreader.h"
+#include "statesnapshot.h"
+#include "monitorcache.h"
+#include "trace.h"
+
+#include <QSocketNotifier>
+#include <QFile>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QDebug>
+
+#include <poll.h>
+#include <unistd.h>
+
+namespace {
+
+// Longest a model reload may hold up the event loop
+const int ResyncTimeoutMs = 1000;
+
+std::string_view jsonView(const QByteArray &data)
+{
+    return std::string_view(data.constData(), static_cast<size_t>(data.size()));
+}
+
+QString addressString(uint64_t address)
+{
+    return address ? QString::fromStdString(HyprlandJson::formatAddress(address)) : QString();
+}
+
+QString fieldString(const EventRecord &record, int index)
+{
+    const std::string_view field = record.field(index);
+    return QString::fromUtf8(field.data(), static_cast<qsizetype>(field.size()));
+}
+
+} // namespace
+
+HyprlandState::HyprlandState(HyprlandAPI *api, QObject *parent)
+    : QObject(parent), m_api(api), m_reader(nullptr), m_notifier(nullptr), m_synced(false), m_resyncPending(false),
+      m_floatingSerial(0), m_overflowsSeen(0), m_snapshot(nullptr), m_heartbeat(nullptr), m_publishPending(false)
+{
+}
+
+HyprlandState::~HyprlandState()
+{
+    disconnectEvents();
+    delete m_snapshot;
+}
+
+bool HyprlandState::start()
+{
+    disconnectEvents();
+    
+    QString path = HyprlandIPC::instanceSocketPath(".socket2.sock");
+    int eventFd = HyprlandIPC::connectSocket(path);
+    if (eventFd < 0) {
+        qWarning() << "Cannot connect to Hyprland event socket, state mirror disabled";
+        return false;
+    }
+    
+    // The socket is read on the reader's thread; we only hear about records
+    m_reader = new EventReader;
+    if (!m_reader->start(eventFd)) {
+        qWarning() << "Cannot start the event reader, state mirror disabled";
+        ::close(eventFd);
+        delete m_reader;
+        m_reader = nullptr;
+        return false;
+    }
+    m_overflowsSeen = 0;
+    m_notifier = new QSocketNotifier(m_reader->notifyFd(), QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &HyprlandState::onEventsReadable);
+    
+    // Subscribe first so no event between the snapshot and now is lost
+    return resync();
+}
+
+void HyprlandState::disconnectEvents()
+{
+    // May run from inside the notifier's own activated() signal
+    if (m_notifier) {
+        m_notifier->setEnabled(false);
+        m_notifier->deleteLater();
+        m_notifier = nullptr;
+    }
+    
+    if (m_reader) {
+        m_reader->stop();
+        delete m_reader;
+        m_reader = nullptr;
+    }
+    
+    m_synced = false;
+}
+
+bool HyprlandState::resync()
+{
+    TRACE_SPAN("state.resync", "state");
+    m_resyncPending = false;
+    m_eventStats.resyncs++;
+    
+    // Anything still queued predates the snapshot we are about to take
+    if (m_reader && !m_reader->discardQueued(1000)) {
+        qWarning() << "Event reader did not drop its queue in time";
+    }
+    
+    // Runs on the event loop: a hung Hyprland costs at most ResyncTimeoutMs
+    // per reload, and once the breaker opens nothing at all
+    QList<IpcReply> replies = m_api->queryBatch(
+        QStringList() << "monitors" << "workspaces" << "clients" << "activewindow",
+        ResyncTimeoutMs);
+    
+    for (const IpcReply &reply : replies) {
+        if (!reply.ok()) {
+            qWarning() << "State resync failed:" << ipcStatusName(reply.status);
+            m_synced = false;
+            return false;
+        }
+    }
+    
+    // Decode first so a malformed reply leaves the current model untouched
+    std::vector<MonitorInfo> monitors;
+    std::vector<WorkspaceInfo> workspaces;
+    WindowInfo activeWindow;
+    if (!HyprlandJson::decodeMonitors(jsonView(replies[0].data), monitors) ||
+        !HyprlandJson::decodeWorkspaces(jsonView(replies[1].data), workspaces) ||
+        !HyprlandJson::decodeWindow(jsonView(replies[3].data), activeWindow, 0)) {
+        qWarning() << "State resync failed: malformed reply";
+        m_synced = false;
+        return false;
+    }
+    
+    m_monitors.clear();
+    m_workspaces.clear();
+    m_clients.clear();
+    m_workspaceWindows.clear();
+    m_focusedMonitor.clear();
+    
+    for (const MonitorInfo &info : monitors) {
+        Monitor monitor;
+        monitor.name = QString::fromStdString(info.name);
+        monitor.activeWorkspaceId = info.activeWorkspaceId;
+        monitor.info = info;
+        m_monitors.insert(monitor.name, monitor);
+        
+        if (info.focused || m_focusedMonitor.isEmpty()) {
+            m_focusedMonitor = monitor.name;
+        }
+    }
+    
+    for (const WorkspaceInfo &info : workspaces) {
+        Workspace workspace;
+        workspace.id = info.id;
+        workspace.name = QString::fromStdString(info.name);
+        workspace.monitor = QString::fromStdString(info.monitor);
+        m_workspaces.insert(workspace.id, workspace);
+    }
+    
+    // Clients are streamed, the reply is never held as a document
+    bool clientsOk = HyprlandJson::forEachClient(jsonView(replies[2].data), [this](const WindowInfo &info) {
+        Client client;
+        client.address = QString::fromStdString(HyprlandJson::formatAddress(info.address));
+        client.workspaceId = info.workspaceId;
+        client.floating = info.floating;
+        client.floatingKnown = true;
+        client.windowClass = QString::fromStdString(info.windowClass);
+        client.title = QString::fromStdString(info.title);
+        addClient(client);
+    }, HyprlandJson::WindowStrings);
+    
+    if (!clientsOk) {
+        qWarning() << "State resync failed: malformed clients reply";
+        m_synced = false;
+        return false;
+    }
+    
+    m_activeWindow = activeWindow.valid()
+        ? QString::fromStdString(HyprlandJson::formatAddress(activeWindow.address)) : QString();
+    
+    m_synced = !m_monitors.isEmpty();
+    storeMonitorCache();
+    qDebug() << "State mirror synced:" << m_monitors.size() << "monitors," << m_workspaces.size()
+             << "workspaces," << m_clients.size() << "clients";
+    
+    emit stateChanged();
+    return m_synced;
+}
+
+void HyprlandState::scheduleResync()
+{
+    m_synced = false;
+    if (m_resyncPending) {
+        return;
+    }
+    emit stateChanged();
+    
+    // Coalesce bursts of events we cannot apply into a single reload
+    m_resyncPending = true;
+    QTimer::singleShot(50, this, [this]() {
+        if (m_resyncPending) {
+            resync();
+        }
+    });
+}
+
+void HyprlandState::onEventsReadable()
+{
+    if (!m_reader) {
+        return;
+    }
+    
+    m_reader->clearNotification();
+    EventRecord record;
+    while (m_reader && m_reader->pop(record)) {
+        m_eventStats.events += record.lines;
+        if (Trace::enabled()) {
+            Trace::instant("state.event", "state", std::string(eventTypeName(record.type)) + " " +
+                           HyprlandJson::formatAddress(record.address));
+        }
+        handleEvent(record);
+    }
+    if (!m_reader) {
+        return;
+    }
+    
+    const EventReader::Stats stats = m_reader->stats();
+    m_eventStats.coalesced = stats.coalesced;
+    m_eventStats.overflows = stats.overflows;
+    m_eventStats.maxQueued = qMax(m_eventStats.maxQueued, static_cast<quint64>(stats.maxQueued));
+    m_eventStats.maxBuffered = qMax(m_eventStats.maxBuffered, static_cast<qsizetype>(stats.maxBuffered));
+    
+    // Records were lost on a full ring, the model cannot be trusted
+    if (stats.overflows != m_overflowsSeen) {
+        m_overflowsSeen = stats.overflows;
+        qWarning() << "State mirror fell behind the event stream, reloading";
+        scheduleResync();
+    }
+    
+    if (m_reader->isClosed()) {
+        // Hyprland went away, drop the model and try again later
+        qWarning() << "Hyprland event socket closed";
+        disconnectEvents();
+        QTimer::singleShot(1000, this, [this]() { start(); });
+    }
+}
+
+void HyprlandState::applyQueuedEvents()
+{
+    // Whatever Hyprland wrote before this call is on the ring afterwards
+    if (m_reader && !m_reader->isClosed()) {
+        m_reader->catchUp(100);
+    }
+    onEventsReadable();
+}
+
+void HyprlandState::handleEvent(const EventRecord &record)
+{
+    const QString address = addressString(record.address);
+    
+    switch (record.type) {
+    case EventType::ActiveWindow:
+        if (!address.isEmpty() && !m_clients.contains(address)) {
+            scheduleResync();
+            return;
+        }
+        m_activeWindow = address;
+        emit activeWindowChanged(address);
+        break;
+    
+    case EventType::OpenWindow: {
+        // Fields: workspace name, class, title
+        int workspaceId = workspaceIdByName(fieldString(record, 0));
+        if (address.isEmpty() || workspaceId == -1) {
+            scheduleResync();
+            return;
+        }
+        
+        Client client;
+        client.address = address;
+        client.workspaceId = workspaceId;
+        client.windowClass = fieldString(record, 1);
+        client.title = fieldString(record, 2);
+        removeClient(client.address);
+        addClient(client);
+        break;
+    }
+    
+    case EventType::CloseWindow:
+        removeClient(address);
+        if (m_activeWindow == address) {
+            m_activeWindow.clear();
+        }
+        break;
+    
+    case EventType::MoveWindow:
+        if (!m_clients.contains(address)) {
+            scheduleResync();
+            return;
+        }
+        moveClient(address, record.workspaceId);
+        break;
+    
+    case EventType::FloatingMode: {
+        if (!m_clients.contains(address)) {
+            scheduleResync();
+            return;
+        }
+        bool floating = record.flag != 0;
+        noteFloating(address, floating);
+        m_clients[address].floatingSerial = ++m_floatingSerial;
+        emit floatingModeChanged(address, floating);
+        break;
+    }
+    
+    case EventType::WindowTitle: {
+        auto it = m_clients.find(address);
+        if (it != m_clients.end()) {
+            it->title = fieldString(record, 0);
+        }
+        return;
+    }
+    
+    case EventType::Workspace: {
+        // On the focused monitor
+        auto it = m_monitors.find(m_focusedMonitor);
+        if (it == m_monitors.end()) {
+            scheduleResync();
+            return;
+        }
+        it->activeWorkspaceId = record.workspaceId;
+        break;
+    }
+    
+    case EventType::FocusedMonitor:
+    case EventType::FocusedMonitorByName: {
+        auto it = m_monitors.find(fieldString(record, 0));
+        int workspaceId = record.type == EventType::FocusedMonitor
+            ? record.workspaceId : workspaceIdByName(fieldString(record, 1));
+        if (it == m_monitors.end() || workspaceId == -1) {
+            scheduleResync();
+            return;
+        }
+        m_focusedMonitor = it->name;
+        it->activeWorkspaceId = workspaceId;
+        break;
+    }
+    
+    case EventType::CreateWorkspace: {
+        Workspace workspace;
+        workspace.id = record.workspaceId;
+        workspace.name = fieldString(record, 0);
+        workspace.monitor = m_focusedMonitor;
+        m_workspaces.insert(workspace.id, workspace);
+        break;
+    }
+    
+    case EventType::DestroyWorkspace:
+        m_workspaces.remove(record.workspaceId);
+        m_workspaceWindows.remove(record.workspaceId);
+        break;
+    
+    case EventType::MoveWorkspace: {
+        // Fields: workspace name, monitor name
+        auto it = m_workspaces.find(record.workspaceId);
+        if (it == m_workspaces.end()) {
+            scheduleResync();
+            return;
+        }
+        it->monitor = fieldString(record, 1);
+        break;
+    }
+    
+    case EventType::MonitorRemoved: {
+        const QString monitor = fieldString(record, 0);
+        m_monitors.remove(monitor);
+        if (m_focusedMonitor == monitor) {
+            scheduleResync();
+            return;
+        }
+        storeMonitorCache();
+        break;
+    }
+    
+    case EventType::MonitorsChanged:
+        // Geometry, scale and reserved areas are not part of the event
+        scheduleResync();
+        return;
+    
+    case EventType::None:
+        return;
+    }
+    
+    emit stateChanged();
+}
+
+QString HyprlandState::activeWindowAddress()
+{
+    // A focus change may still sit unread on the event socket
+    applyQueuedEvents();
+    return m_activeWindow;
+}
+
+PlacementState HyprlandState::placementState()
+{
+    // Apply whatever Hyprland has reported since the event loop last ran
+    applyQueuedEvents();
+    
+    PlacementState state;
+    if (!m_synced) {
+        return state;
+    }
+    
+    auto monitor = m_monitors.constFind(m_focusedMonitor);
+    auto client = m_clients.constFind(m_activeWindow);
+    if (monitor == m_monitors.constEnd() || client == m_clients.constEnd() || !client->floatingKnown) {
+        return state;
+    }
+    
+    state.window.address = HyprlandJson::parseAddress(jsonView(client->address.toLatin1()));
+    state.window.workspaceId = client->workspaceId;
+    state.window.floating = client->floating;
+    state.window.mapped = true;
+    state.monitor = monitor->info;
+    state.workspaceId = monitor->activeWorkspaceId;
+    state.workspaceWindowCount = windowCount(state.workspaceId);
+    state.valid = true;
+    return state;
+}
+
+int HyprlandState::windowCount(int workspaceId) const
+{
+    // Special workspaces have negative ids and are never counted
+    if (workspaceId <= 0) {
+        return 0;
+    }
+    return m_workspaceWindows.value(workspaceId);
+}
+
+int HyprlandState::activeWorkspaceId() const
+{
+    return m_monitors.value(m_focusedMonitor).activeWorkspaceId;
+}
+
+void HyprlandState::noteFloating(const QString &address, bool floating)
+{
+    auto it = m_clients.find(address);
+    if (it != m_clients.end() && (it->floating != floating || !it->floatingKnown)) {
+        it->floating = floating;
+        it->floatingKnown = true;
+        emit stateChanged();
+    }
+}
+
+bool HyprlandState::publishSnapshot(const std::string &path)
+{
+    if (m_snapshot) {
+        return true;
+    }
+    
+    m_snapshot = new StateSnapshotWriter;
+    if (!m_snapshot->open(path)) {
+        qWarning() << "Cannot publish the state snapshot at" << QString::fromStdString(path);
+        delete m_snapshot;
+        m_snapshot = nullptr;
+        return false;
+    }
+    
+    // Readers consider the snapshot stale without a recent heartbeat
+    m_heartbeat = new QTimer(this);
+    connect(m_heartbeat, &QTimer::timeout, this, [this]() { m_snapshot->heartbeat(); });
+    m_heartbeat->start(1000);
+    
+    connect(this, &HyprlandState::stateChanged, this, &HyprlandState::schedulePublish);
+    publishNow();
+    storeMonitorCache();
+    return true;
+}
+
+void HyprlandState::storeMonitorCache()
+{
+    // A publishing mirror resyncs whenever monitors come or get reconfigured,
+    // which keeps the cache of one-shot invocations current
+    if (!m_snapshot || !m_synced) {
+        return;
+    }
+    
+    std::vector<MonitorInfo> monitors;
+    for (const Monitor &monitor : std::as_const(m_monitors)) {
+        monitors.push_back(monitor.info);
+    }
+    const std::string session = MonitorCache::sessionKey(
+        qEnvironmentVariable("HYPRLAND_INSTANCE_SIGNATURE").toStdString(),
+        QFile::encodeName(m_ipc.socketPath()).toStdString());
+    MonitorCache().store(session, monitors);
+}
+
+void HyprlandState::schedulePublish()
+{
+    // A burst of events is published once, after the last of them
+    if (m_publishPending) {
+        return;
+    }
+    m_publishPending = true;
+    QTimer::singleShot(0, this, &HyprlandState::publishNow);
+}
+
+void HyprlandState::publishNow()
+{
+    TRACE_SPAN("state.publish", "state");
+    m_publishPending = false;
+    
+    PlacementState state = placementState();
+    if (!state.valid) {
+        m_snapshot->publish(nullptr);
+        return;
+    }
+    
+    SnapshotState snapshot;
+    snapshot.window = state.window;
+    snapshot.monitor = state.monitor;
+    snapshot.workspaceId = state.workspaceId;
+    snapshot.workspaceWindowCount = state.workspaceWindowCount;
+    m_snapshot->publish(&snapshot);
+}
+
+quint64 HyprlandState::floatingSerial()
+{
+    // A changefloatingmode event from before the toggle may still be queued
+    applyQueuedEvents();
+    return m_floatingSerial;
+}
+
+std::optional<bool> HyprlandState::waitForFloating(const QString &address, quint64 since, int timeoutMs)
+{
+    TRACE_SPAN("state.waitFloating", "state");
+    QElapsedTimer timer;
+    timer.start();
+    
+    while (true) {
+        onEventsReadable();
+        
+        auto it = m_clients.constFind(address);
+        if (it != m_clients.constEnd() && it->floatingSerial > since) {
+            return it->floating;
+        }
+        
+        int remaining = timeoutMs - static_cast<int>(timer.elapsed());
+        if (!m_reader || remaining <= 0) {
+            return std::nullopt;
+        }
+        
+        // Block until the reader hands over records rather than sleeping
+        pollfd pfd;
+        pfd.fd = m_reader->notifyFd();
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        ::poll(&pfd, 1, remaining);
+    }
+}
+
+void HyprlandState::addClient(const Client &client)
+{
+    m_clients.insert(client.address, client);
+    m_workspaceWindows[client.workspaceId]++;
+}
+
+void HyprlandState::removeClient(const QString &address)
+{
+    auto it = m_clients.find(address);
+    if (it == m_clients.end()) {
+        return;
+    }
+    
+    m_workspaceWindows[it->workspaceId]--;
+    m_clients.erase(it);
+}
+
+void HyprlandState::moveClient(const QString &address, int workspaceId)
+{
+    auto it = m_clients.find(address);
+    if (it == m_clients.end() || it->workspaceId == workspaceId) {
+        return;
+    }
+    
+    m_workspaceWindows[it->workspaceId]--;
+    m_workspaceWindows[workspaceId]++;
+    it->workspaceId = workspaceId;
+}
+
+int HyprlandState::workspaceIdByName(const QString &name) const
+{
+    for (const Workspace &workspace : m_workspaces) {
+        if (workspace.name == name) {
+            return workspace.id;
+        }
+    }
+    return -1;
+}
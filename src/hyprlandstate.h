@@ -0,0 +1,148 @@
+#ifndef HYPRLANDSTATE_H
+#define HYPRLANDSTATE_H
+
+#include <QObject>
+#include <QHash>
+#include <QString>
+#include <QByteArray>
+
+#include <optional>
+
+#include "hyprlandapi.h"
+#include "hyprlandipc.h"
+
+class QSocketNotifier;
+class QTimer;
+class StateSnapshotWriter;
+class EventReader;
+struct EventRecord;
+
+// How the mirror keeps up with the event stream
+struct EventStats {
+    quint64 events = 0;             // Lines taken off the event socket and applied or coalesced
+    quint64 resyncs = 0;            // Model loads, the first included; each drops what was queued
+    qsizetype maxBuffered = 0;      // Largest backlog read in one go, bytes
+    quint64 maxQueued = 0;          // Most records waiting for this thread at once
+    quint64 coalesced = 0;          // Records made redundant by a later one, this connection
+    quint64 overflows = 0;          // Records lost while this thread lagged, this connection
+};
+
+// In-memory mirror of monitors, workspaces and clients, kept current from
+// Hyprland's event socket (.socket2.sock). Long-lived processes use it to
+// answer placement questions without any IPC; the model is reloaded from
+// the request socket only on startup or when an event cannot be applied.
+// The socket is read and parsed by an EventReader thread, so a busy event
+// loop here never holds up the compositor.
+class HyprlandState : public QObject
+{
+    Q_OBJECT
+    
+public:
+    // The model is reloaded through `api`, under its circuit breaker
+    explicit HyprlandState(HyprlandAPI *api, QObject *parent = nullptr);
+    ~HyprlandState();
+    
+    // Connect to the event socket and load the initial model
+    bool start();
+    bool isSynced() const { return m_synced; }
+    
+    // Placement state from the model after applying queued events. Invalid
+    // when the model cannot answer (not synced, unknown floating state).
+    PlacementState placementState();
+    
+    // Model queries
+    int windowCount(int workspaceId) const;
+    int activeWorkspaceId() const;
+    QString activeWindowAddress();
+    
+    // Record a change we caused ourselves before Hyprland reports it
+    void noteFloating(const QString &address, bool floating);
+    
+    // Wait for a changefloatingmode event for the window that arrived after
+    // floatingSerial() returned `since`. Returns the confirmed floating
+    // state, or nothing when the deadline passes first. floatingSerial()
+    // applies the events already queued, so none of them can confirm a
+    // toggle dispatched after it.
+    quint64 floatingSerial();
+    std::optional<bool> waitForFloating(const QString &address, quint64 since, int timeoutMs);
+    
+    // Reload the whole model from the request socket
+    bool resync();
+    
+    // Publish the placement state to a shared-memory snapshot that one-shot
+    // processes read instead of querying Hyprland (see statesnapshot.h)
+    bool publishSnapshot(const std::string &path);
+    
+    const EventStats &eventStats() const { return m_eventStats; }
+    
+signals:
+    void stateChanged();
+    void activeWindowChanged(const QString &address);
+    void floatingModeChanged(const QString &address, bool floating);
+    
+private slots:
+    void onEventsReadable();
+    
+private:
+    struct Monitor {
+        QString name;
+        int activeWorkspaceId = -1;
+        MonitorInfo info;   // Last monitors -j entry
+    };
+    
+    struct Workspace {
+        int id = -1;
+        QString name;
+        QString monitor;
+    };
+    
+    struct Client {
+        QString address;
+        int workspaceId = -1;
+        bool floating = false;
+        bool floatingKnown = false;   // False for windows we only saw in openwindow
+        quint64 floatingSerial = 0;   // Serial of the last changefloatingmode event
+        QString windowClass;
+        QString title;
+    };
+    
+    // Event handling
+    void handleEvent(const EventRecord &record);
+    void applyQueuedEvents();
+    void scheduleResync();
+    void disconnectEvents();
+    void schedulePublish();
+    void publishNow();
+    void storeMonitorCache();
+    
+    // Model updates
+    void addClient(const Client &client);
+    void removeClient(const QString &address);
+    void moveClient(const QString &address, int workspaceId);
+    int workspaceIdByName(const QString &name) const;
+    
+    HyprlandAPI *m_api;
+    HyprlandIPC m_ipc;
+    EventReader *m_reader;
+    QSocketNotifier *m_notifier;
+    bool m_synced;
+    bool m_resyncPending;
+    
+    // Model
+    QHash<QString, Monitor> m_monitors;     // By monitor name
+    QHash<int, Workspace> m_workspaces;     // By workspace id
+    QHash<QString, Client> m_clients;       // By window address
+    QHash<int, int> m_workspaceWindows;     // Window count per workspace id
+    QString m_focusedMonitor;
+    QString m_activeWindow;
+    quint64 m_floatingSerial;
+    EventStats m_eventStats;
+    quint64 m_overflowsSeen;
+    
+    // Snapshot publishing, coalesced per event loop iteration
+    StateSnapshotWriter *m_snapshot;
+    QTimer *m_heartbeat;
+    bool m_publishPending;
+};
+
+#endif // HYPRLANDSTATE_H
@@ -1,34 +1,101 @@
-#include <QApplication>
+#include <QCoreApplication>
 #include <QCommandLineParser>
 #include <QCommandLineOption>
-#include <QProcess>
+#include <QFile>
+#include <QDebug>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <string>
+
+#include <unistd.h>
 
-#include "mainwindow.h"
 #include "gridmanager.h"
+#include "daemonserver.h"
+#include "metrics.h"
+#include "applyqueue.h"
+#include "trace.h"
+#include "flightrecorder.h"
+#include "daemonprotocol.h"
+#include "conformance.h"
 
-void ensureGridManagerFloating()
+// --trace=<file> or HYPR_GRID_TRACE=<file>. Read before QCoreApplication is
+// constructed so cold start shows up in the trace too.
+std::string traceFileFromArguments(int argc, char *argv[])
 {
-    // Apply a window rule to keep the grid manager floating
-    QProcess process;
-    QStringList args;
-    args << "keyword" << "windowrulev2" << "float,class:^(hypr-grid-manager)$";
-    process.start("hyprctl", args);
-    process.waitForFinished(1000);
-    
-    // Also set it to be always on top for better accessibility
-    args.clear();
-    args << "keyword" << "windowrulev2" << "stayfocused,class:^(hypr-grid-manager)$";
-    process.start("hyprctl", args);
-    process.waitForFinished(1000);
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--trace=", 8) == 0) {
+            return argv[i] + 8;
+        }
+        if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            return argv[i + 1];
+        }
+    }
+    
+    const char *env = std::getenv("HYPR_GRID_TRACE");
+    return env ? env : "";
+}
+
+// Writes the trace on every return path out of main()
+struct TraceSession {
+    ~TraceSession() { Trace::finish(); }
+};
+
+// The UI is hypr-grid-manager-ui, so this binary links only Qt Core and
+// DBus and keybinding launches never load the widget libraries. The one
+// next to this binary wins over PATH, which keeps build trees working.
+int launchUi()
+{
+    const QByteArray local = QFile::encodeName(QCoreApplication::applicationDirPath() + "/hypr-grid-manager-ui");
+    char *const args[] = {const_cast<char *>("hypr-grid-manager-ui"), nullptr};
+    ::execv(local.constData(), args);
+    ::execvp(args[0], args);
+    qCritical() << "Cannot start hypr-grid-manager-ui:" << std::strerror(errno);
+    return 1;
+}
+
+// One-shot apply through the queue shared with other invocations and the
+// daemon. A request superseded by a newer one for the same window is not an
+// error: the newer request decides where the window goes. The context is
+// captured once, so the queue is keyed on the window that gets placed.
+int runApply(GridManager &gridManager, const QString &preset, const QString &code)
+{
+    std::optional<ApplyContext> context = gridManager.captureApplyContext();
+    if (!context) {
+        return 1;
+    }
+    
+    ApplyQueue queue;
+    bool followsSameWindow = false;
+    uint64_t ticket = queue.isOpen() ? queue.enqueue(context->address.toStdString(), &followsSameWindow) : 0;
+    if (ticket == 0) {
+        qWarning() << "Apply queue unavailable, applying without coalescing";
+        return gridManager.applyPositionByCode(preset, code, context) ? 0 : 1;
+    }
+    
+    return gridManager.runQueuedApply(queue, ticket, preset, code, nullptr, context, followsSameWindow)
+        == ApplyQueue::Failed ? 1 : 0;
 }
 
 int main(int argc, char *argv[])
 {
-    QApplication app(argc, argv);
+    TraceSession traceSession;
+    const std::string traceFile = traceFileFromArguments(argc, argv);
+    if (!traceFile.empty()) {
+        Trace::start(traceFile);
+    }
+    
+    std::optional<Trace::Span> startupSpan;
+    startupSpan.emplace("startup", "init");
+    
+    QCoreApplication app(argc, argv);
     app.setApplicationName("Hypr Grid Manager");
     app.setOrganizationName("Hyprland");
     app.setApplicationVersion("1.0.0");
-
+    
     QCommandLineParser parser;
     parser.setApplicationDescription("Window grid manager for Hyprland");
     parser.addHelpOption();
@@ -44,25 +111,59 @@ int main(int argc, char *argv[])
     QCommandLineOption uiOption(QStringList() << "u" << "ui", 
         "Show the configuration UI");
     QCommandLineOption testOption(QStringList() << "t" << "test", 
-        "Test all grid positions by cycling through them");
-
+        "Check placement accuracy of every preset on every monitor");
+    QCommandLineOption reportOption("report", 
+        "Write the --test results as JUnit XML (.xml) or JSON", "file");
+    QCommandLineOption daemonOption(QStringList() << "d" << "daemon", 
+        "Stay resident and serve hypr-grid-client requests");
+    QCommandLineOption traceOption("trace", 
+        "Write a Chrome trace of this run (also HYPR_GRID_TRACE)", "file");
+    QCommandLineOption dumpRecentOption("dump-recent", 
+        "Print the flight recorder of recent applies as JSON lines");
+    
     parser.addOption(applyOption);
     parser.addOption(resetOption);
     parser.addOption(configOption);
     parser.addOption(uiOption);
     parser.addOption(testOption);
-
+    parser.addOption(reportOption);
+    parser.addOption(daemonOption);
+    parser.addOption(traceOption);
+    parser.addOption(dumpRecentOption);
+    
     parser.process(app);
-
+    
+    // The UI unless a command is given: -u, or no positional arguments.
+    // Commands win over -u.
+    const bool command = parser.isSet(resetOption) || parser.isSet(applyOption) || parser.isSet(configOption) ||
+                         parser.isSet(testOption) || parser.isSet(daemonOption) || parser.isSet(dumpRecentOption);
+    if (!command && (parser.isSet(uiOption) || parser.positionalArguments().isEmpty())) {
+        return launchUi();
+    }
+    
+    if (parser.isSet(dumpRecentOption)) {
+        if (!FlightRecorder::open()) {
+            qCritical() << "No flight recorder to dump";
+            return 1;
+        }
+        return FlightRecorder::dump(STDOUT_FILENO) ? 0 : 1;
+    }
+    
+    // SIGUSR1 and crashes leave the recent applies next to the ring
+    const std::string dumpSuffix = "-recent-" + std::to_string(getpid()) + ".jsonl";
+    FlightRecorder::installSignalHandlers(DaemonProtocol::runtimeFilePath(dumpSuffix.c_str()));
+    
     // Handle CLI commands
     GridManager gridManager;
     
-    // Initialize the grid manager
+    // Loads the configuration only; Hyprland is contacted by the first
+    // operation that needs it
     if (!gridManager.initialize()) {
         qCritical() << "Failed to initialize grid manager";
         return 1;
     }
-
+    startupSpan.reset();
+    
     // Check if we have CLI commands
     if (parser.isSet(resetOption)) {
         return gridManager.resetWindowState() ? 0 : 1;
@@ -76,22 +177,37 @@ int main(int argc, char *argv[])
             return 1;
         }
         
-        return gridManager.applyPositionByCode(parts[0], parts[1]) ? 0 : 1;
+        return runApply(gridManager, parts[0], parts[1]);
     }
     else if (parser.isSet(configOption)) {
         gridManager.printConfig();
         return 0;
     }
     else if (parser.isSet(testOption)) {
-        return gridManager.testAllPositions() ? 0 : 1;
+        ConformanceSuite suite(gridManager);
+        if (!suite.run()) {
+            qCritical() << "Conformance run failed:" << suite.lastError();
+            return 1;
+        }
+        std::cout << suite.summary().toStdString();
+        if (parser.isSet(reportOption) && !suite.writeReport(parser.value(reportOption))) {
+            qCritical() << "Cannot write the report to" << parser.value(reportOption);
+            return 1;
+        }
+        return suite.failures() == 0 ? 0 : 1;
     }
-    // Show UI if requested or no other commands specified
-    else if (parser.isSet(uiOption)) {
-        // Ensure grid manager window stays floating
-        ensureGridManagerFloating();
+    else if (parser.isSet(daemonOption)) {
+        // Keep config, IPC state and the event mirror warm between keypresses
+        gridManager.enableStateMirror();
+        Metrics::enable();
+        
+        DaemonServer server(gridManager);
+        if (!server.start()) {
+            return 1;
+        }
         
-        MainWindow mainWindow(gridManager);
-        mainWindow.show();
+        // Only once we own the instance: the mirrored state for one-shot runs
+        gridManager.publishStateSnapshot();
         return app.exec();
     }
     
@@ -102,17 +218,7 @@ int main(int argc, char *argv[])
     if (positionalArgs.size() == 2) {
         QString preset = positionalArgs[0];
         QString position = positionalArgs[1];
-        return gridManager.applyPositionByCode(preset, position) ? 0 : 1;
-    }
-    
-    // If no arguments provided or just one argument, show UI
-    if (argc == 1 || positionalArgs.size() == 0) {
-        // Ensure grid manager window stays floating
-        ensureGridManagerFloating();
-        
-        MainWindow mainWindow(gridManager);
-        mainWindow.show();
-        return app.exec();
+        return runApply(gridManager, preset, position);
     }
     
     // Invalid argument format
@@ -14,7 +14,8 @@
 #include <QCheckBox>
 
 MainWindow::MainWindow(GridManager &gridManager, QWidget *parent)
-    : QMainWindow(parent), ui(new Ui::MainWindow), m_gridManager(gridManager), m_isEditingGrid(false)
+    : QMainWindow(parent), ui(new Ui::MainWindow), m_gridManager(gridManager),
+      m_asyncManager(new AsyncGridManager(gridManager, this)), m_isEditingGrid(false)
 {
     ui->setupUi(this);
     
@@ -64,12 +65,32 @@ void MainWindow::setupUI()
     // Set up log level combo
     ui->logLevelCombo->addItems(QStringList() << "debug" << "info" << "warn" << "error");
     ui->logLevelCombo->setCurrentText(m_gridManager.getConfig()->getAdvancedConfig()["logLevel"].toString());
+    
+    // Busy indicator and cancel button for in-flight operations
+    m_busyIndicator = new QProgressBar(this);
+    m_busyIndicator->setRange(0, 0);
+    m_busyIndicator->setMaximumWidth(120);
+    m_busyIndicator->setVisible(false);
+    
+    m_cancelOperationButton = new QPushButton(tr("Cancel"), this);
+    m_cancelOperationButton->setVisible(false);
+    
+    ui->statusbar->addPermanentWidget(m_busyIndicator);
+    ui->statusbar->addPermanentWidget(m_cancelOperationButton);
+    
+    // Start the IPC thread early so the first apply does not pay for it
+    m_asyncManager->start();
 }
 
 void MainWindow::setupConnections()
 {
     // Grid manager connections
     connect(&m_gridManager, &GridManager::errorOccurred, this, &MainWindow::onErrorOccurred);
+    connect(m_asyncManager, &AsyncGridManager::errorOccurred, this, &MainWindow::onErrorOccurred);
+    connect(m_asyncManager, &AsyncGridManager::applyFinished, this, &MainWindow::onApplyFinished);
+    connect(m_asyncManager, &AsyncGridManager::resetFinished, this, &MainWindow::onResetFinished);
+    connect(m_asyncManager, &AsyncGridManager::busyChanged, this, &MainWindow::onBusyChanged);
+    connect(m_cancelOperationButton, &QPushButton::clicked, this, &MainWindow::onCancelOperationClicked);
     
     // Preset selection
     connect(ui->presetComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), 
@@ -274,21 +295,56 @@ void MainWindow::onApplyButtonClicked()
         return;
     }
     
-    // Apply the position
-    bool success = m_gridManager.applyPositionByCode(m_currentPreset, m_currentPositionCode);
+    // Apply the position on the IPC thread, the result arrives in onApplyFinished
+    m_asyncManager->applyPositionAsync(m_currentPreset, m_currentPositionCode);
+    statusBar()->showMessage(tr("Applying %1:%2...").arg(m_currentPreset, m_currentPositionCode));
+}
+
+void MainWindow::onResetButtonClicked()
+{
+    m_asyncManager->resetWindowStateAsync();
+    statusBar()->showMessage(tr("Resetting window state..."));
+}
+
+void MainWindow::onCancelOperationClicked()
+{
+    m_asyncManager->cancel();
+    statusBar()->showMessage(tr("Cancelling..."));
+}
+
+void MainWindow::onApplyFinished(const QString &preset, const QString &code, bool success, bool cancelled)
+{
+    if (cancelled) {
+        statusBar()->showMessage(tr("Apply of %1:%2 cancelled").arg(preset, code), 3000);
+        return;
+    }
     
     if (!success) {
+        statusBar()->clearMessage();
         QMessageBox::warning(this, tr("Error"), tr("Failed to apply position"));
+        return;
     }
+    
+    statusBar()->showMessage(tr("Applied %1:%2").arg(preset, code), 3000);
 }
 
-void MainWindow::onResetButtonClicked()
+void MainWindow::onResetFinished(bool success)
 {
-    bool success = m_gridManager.resetWindowState();
-    
     if (!success) {
+        statusBar()->clearMessage();
         QMessageBox::warning(this, tr("Error"), tr("Failed to reset window state"));
+        return;
     }
+    
+    statusBar()->showMessage(tr("Window state reset"), 3000);
+}
+
+void MainWindow::onBusyChanged(bool busy)
+{
+    m_busyIndicator->setVisible(busy);
+    m_cancelOperationButton->setVisible(busy);
+    ui->applyButton->setEnabled(!busy);
+    ui->resetButton->setEnabled(!busy);
 }
 
 void MainWindow::onSaveButtonClicked()
@@ -4,10 +4,12 @@
 #include <QMainWindow>
 #include <QMap>
 #include <QPushButton>
+#include <QProgressBar>
 
 #include "gridmanager.h"
 #include "gridcell.h"
 #include "gridpreview.h"
+#include "asyncgridmanager.h"
 
 namespace Ui {
 class MainWindow;
@@ -29,6 +31,12 @@ private slots:
     void onApplyButtonClicked();
     void onResetButtonClicked();
     void onSaveButtonClicked();
+    void onCancelOperationClicked();
+    
+    // Asynchronous operation results
+    void onApplyFinished(const QString &preset, const QString &code, bool success, bool cancelled);
+    void onResetFinished(bool success);
+    void onBusyChanged(bool busy);
     
     // Settings handlers
     void onSaveSettingsClicked();
@@ -70,6 +78,11 @@ private:
     // Grid manager reference
     GridManager &m_gridManager;
     
+    // Runs applies off the GUI thread
+    AsyncGridManager *m_asyncManager;
+    QProgressBar *m_busyIndicator;
+    QPushButton *m_cancelOperationButton;
+    
     // Current state
     QString m_currentPreset;
     QString m_currentPositionCode;
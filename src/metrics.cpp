@@ -0,0 +1,309 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include <time.h>
+
+namespace Metrics {
+
+namespace detail {
+std::atomic<bool> enabled{false};
+}
+
+namespace {
+
+// 16 linear buckets per power of two, up to 2^40 us (12 days); larger
+// values land in the last bucket
+const int SubBucketBits = 4;
+const int SubBuckets = 1 << SubBucketBits;
+const int MaxShift = 40 - SubBucketBits;
+const int BucketCount = (MaxShift + 2) * SubBuckets;
+
+const double Quantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+// What the metrics recorded around the code base mean
+struct HelpText {
+    const char *name;
+    const char *text;
+};
+
+const HelpText HelpTexts[] = {
+    {"hypr_grid_apply_duration_seconds", "Time from apply request to placed window, by preset; placed applies only"},
+    {"hypr_grid_apply_failures_total", "Applies that failed, by preset"},
+    {"hypr_grid_apply_over_budget_total", "Applies and resets that ran out of their deadline"},
+    {"hypr_grid_ipc_request_duration_seconds", "Hyprland request round-trips, by command"},
+    {"hypr_grid_ipc_errors_total", "Hyprland requests that did not succeed, by status"},
+    {"hypr_grid_breaker_trips_total", "Times the circuit breaker started failing requests fast"},
+    {"hypr_grid_json_parse_duration_seconds", "Time to decode a Hyprland reply, by reply"},
+    {"hypr_grid_floating_toggles_total", "Floating state changes dispatched"},
+    {"hypr_grid_verifications_total", "Placement read-backs, by result"},
+    {"hypr_grid_placement_retries_total", "Placement dispatches repeated after a failure or miss"},
+    {"hypr_grid_notification_duration_seconds", "Time an apply spends sending its notification"},
+    {"hypr_grid_errors_total", "Errors reported by the grid manager"},
+};
+
+int bucketIndex(int64_t value)
+{
+    if (value < 2 * SubBuckets) {
+        return static_cast<int>(std::max<int64_t>(0, value));
+    }
+    const int shift = 63 - __builtin_clzll(static_cast<uint64_t>(value)) - SubBucketBits;
+    if (shift > MaxShift) {
+        return BucketCount - 1;
+    }
+    return (shift + 1) * SubBuckets + static_cast<int>((value >> shift) - SubBuckets);
+}
+
+// Highest value that falls into the bucket
+int64_t bucketUpperBound(int index)
+{
+    if (index < 2 * SubBuckets) {
+        return index;
+    }
+    const int shift = index / SubBuckets - 1;
+    const int64_t mantissa = index % SubBuckets + SubBuckets;
+    return ((mantissa + 1) << shift) - 1;
+}
+
+struct Histogram {
+    std::vector<uint64_t> buckets = std::vector<uint64_t>(BucketCount);
+    uint64_t count = 0;
+    int64_t sum = 0;
+    int64_t max = 0;
+    
+    int64_t quantile(double q) const
+    {
+        const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * count)));
+        uint64_t seen = 0;
+        for (int i = 0; i < BucketCount; ++i) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                return std::min(bucketUpperBound(i), max);
+            }
+        }
+        return max;
+    }
+};
+
+// Series of one metric, keyed by label value ("" without a label)
+template <typename Value>
+struct Family {
+    const char *labelName = nullptr;
+    std::map<std::string, Value> series;
+};
+
+std::mutex g_mutex;
+std::map<std::string, Family<uint64_t>> g_counters;
+std::map<std::string, Family<Histogram>> g_histograms;
+
+const char *helpText(const std::string &name)
+{
+    for (const HelpText &help : HelpTexts) {
+        if (name == help.name) {
+            return help.text;
+        }
+    }
+    return nullptr;
+}
+
+void appendf(std::string &out, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+void appendf(std::string &out, const char *format, ...)
+{
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int length = std::vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (length > 0) {
+        out.append(buffer, std::min<size_t>(static_cast<size_t>(length), sizeof(buffer) - 1));
+    }
+}
+
+// Both Prometheus label values and JSON strings escape these
+void appendEscaped(std::string &out, const std::string &text, bool json)
+{
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += static_cast<char>(c);
+        } else if (c == '\n') {
+            out += "\\n";
+        } else if (c < 0x20) {
+            if (json) {
+                appendf(out, "\\u%04x", c);
+            }
+        } else {
+            out += static_cast<char>(c);
+        }
+    }
+}
+
+// {label="value"} or {label="value",extra}, nothing when both are empty
+void appendLabels(std::string &out, const char *labelName, const std::string &labelValue,
+                  const char *extra = nullptr)
+{
+    if (!labelName && !extra) {
+        return;
+    }
+    out += '{';
+    if (labelName) {
+        out += labelName;
+        out += "=\"";
+        appendEscaped(out, labelValue, false);
+        out += '"';
+    }
+    if (extra) {
+        if (labelName) {
+            out += ',';
+        }
+        out += extra;
+    }
+    out += '}';
+}
+
+void appendHeader(std::string &out, const std::string &name, const char *type)
+{
+    if (const char *help = helpText(name)) {
+        appendf(out, "# HELP %s %s\n", name.c_str(), help);
+    }
+    appendf(out, "# TYPE %s %s\n", name.c_str(), type);
+}
+
+void appendJsonLabels(std::string &out, const char *labelName, const std::string &labelValue)
+{
+    out += "\"labels\":{";
+    if (labelName) {
+        appendf(out, "\"%s\":\"", labelName);
+        appendEscaped(out, labelValue, true);
+        out += '"';
+    }
+    out += '}';
+}
+
+} // namespace
+
+void enable()
+{
+    detail::enabled.store(true, std::memory_order_relaxed);
+}
+
+int64_t now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+void count(const char *name, const char *labelName, const std::string &labelValue, uint64_t by)
+{
+    if (!enabled()) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(g_mutex);
+    Family<uint64_t> &family = g_counters[name];
+    family.labelName = labelName;
+    family.series[labelName ? labelValue : std::string()] += by;
+}
+
+void observe(const char *name, int64_t micros, const char *labelName, const std::string &labelValue)
+{
+    if (!enabled()) {
+        return;
+    }
+    micros = std::max<int64_t>(0, micros);
+    
+    std::lock_guard<std::mutex> lock(g_mutex);
+    Family<Histogram> &family = g_histograms[name];
+    family.labelName = labelName;
+    Histogram &histogram = family.series[labelName ? labelValue : std::string()];
+    histogram.buckets[bucketIndex(micros)]++;
+    histogram.count++;
+    histogram.sum += micros;
+    histogram.max = std::max(histogram.max, micros);
+}
+
+std::string formatPrometheus()
+{
+    std::lock_guard<std::mutex> lock(g_mutex);
+    std::string out;
+    
+    for (const auto &[name, family] : g_counters) {
+        appendHeader(out, name, "counter");
+        for (const auto &[labelValue, value] : family.series) {
+            out += name;
+            appendLabels(out, family.labelName, labelValue);
+            appendf(out, " %llu\n", static_cast<unsigned long long>(value));
+        }
+    }
+    
+    // Quantiles are computed here, so histograms are exposed as summaries,
+    // with the largest value seen as a gauge next to each
+    for (const auto &[name, family] : g_histograms) {
+        appendHeader(out, name, "summary");
+        for (const auto &[labelValue, histogram] : family.series) {
+            for (double q : Quantiles) {
+                char quantile[32];
+                std::snprintf(quantile, sizeof(quantile), "quantile=\"%g\"", q);
+                out += name;
+                appendLabels(out, family.labelName, labelValue, quantile);
+                appendf(out, " %.9g\n", histogram.quantile(q) / 1e6);
+            }
+            out += name + "_sum";
+            appendLabels(out, family.labelName, labelValue);
+            appendf(out, " %.9g\n", histogram.sum / 1e6);
+            out += name + "_count";
+            appendLabels(out, family.labelName, labelValue);
+            appendf(out, " %llu\n", static_cast<unsigned long long>(histogram.count));
+        }
+        appendf(out, "# TYPE %s_max gauge\n", name.c_str());
+        for (const auto &[labelValue, histogram] : family.series) {
+            out += name + "_max";
+            appendLabels(out, family.labelName, labelValue);
+            appendf(out, " %.9g\n", histogram.max / 1e6);
+        }
+    }
+    return out;
+}
+
+std::string formatJson()
+{
+    std::lock_guard<std::mutex> lock(g_mutex);
+    std::string out = "{\"counters\":[";
+    
+    bool first = true;
+    for (const auto &[name, family] : g_counters) {
+        for (const auto &[labelValue, value] : family.series) {
+            appendf(out, "%s{\"name\":\"%s\",", first ? "" : ",", name.c_str());
+            appendJsonLabels(out, family.labelName, labelValue);
+            appendf(out, ",\"value\":%llu}", static_cast<unsigned long long>(value));
+            first = false;
+        }
+    }
+    
+    out += "],\"histograms\":[";
+    first = true;
+    for (const auto &[name, family] : g_histograms) {
+        for (const auto &[labelValue, histogram] : family.series) {
+            appendf(out, "%s{\"name\":\"%s\",", first ? "" : ",", name.c_str());
+            appendJsonLabels(out, family.labelName, labelValue);
+            appendf(out, ",\"count\":%llu,\"sumMs\":%.3f,\"maxMs\":%.3f",
+                    static_cast<unsigned long long>(histogram.count), histogram.sum / 1e3, histogram.max / 1e3);
+            appendf(out, ",\"p50Ms\":%.3f,\"p90Ms\":%.3f,\"p99Ms\":%.3f,\"p999Ms\":%.3f}",
+                    histogram.quantile(0.5) / 1e3, histogram.quantile(0.9) / 1e3,
+                    histogram.quantile(0.99) / 1e3, histogram.quantile(0.999) / 1e3);
+            first = false;
+        }
+    }
+    out += "]}";
+    return out;
+}
+
+} // namespace Metrics
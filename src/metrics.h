@@ -0,0 +1,77 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+// Running counters and latency histograms of a long-lived process, served
+// by the daemon in Prometheus text or JSON form (hypr-grid-client metrics).
+// Off until enable(): one-shot invocations exit before anyone could read
+// them, and while off recording is a single relaxed atomic load.
+//
+// Histograms are HDR-style: values are microseconds, bucketed with 16
+// linear steps per power of two, so quantiles are within 1/16 of the true
+// value at a fixed size per series. Plain C++ so any module can record.
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+namespace Metrics {
+
+namespace detail {
+extern std::atomic<bool> enabled;
+}
+
+inline bool enabled()
+{
+    return detail::enabled.load(std::memory_order_relaxed);
+}
+
+void enable();
+
+// Microseconds on a monotonic clock
+int64_t now();
+
+// `name` and `labelName` must be string literals. A metric has at most one
+// label, and always the same one.
+void count(const char *name, const char *labelName = nullptr, const std::string &labelValue = std::string(),
+           uint64_t by = 1);
+void observe(const char *name, int64_t micros, const char *labelName = nullptr,
+             const std::string &labelValue = std::string());
+
+// Observes the time from construction to destruction of the scope
+class Timer
+{
+public:
+    explicit Timer(const char *name, const char *labelName = nullptr, std::string labelValue = std::string())
+        : m_name(name), m_labelName(labelName), m_labelValue(std::move(labelValue)),
+          m_begin(enabled() ? now() : -1)
+    {
+    }
+    
+    ~Timer()
+    {
+        if (m_begin >= 0) {
+            observe(m_name, now() - m_begin, m_labelName, m_labelValue);
+        }
+    }
+    
+    Timer(const Timer &) = delete;
+    Timer &operator=(const Timer &) = delete;
+    
+    // For labels only known once the work is done
+    void setLabel(std::string labelValue) { m_labelValue = std::move(labelValue); }
+    
+private:
+    const char *m_name;
+    const char *m_labelName;
+    std::string m_labelValue;
+    int64_t m_begin;
+};
+
+// Prometheus text exposition format 0.0.4; histograms become summaries
+std::string formatPrometheus();
+std::string formatJson();
+
+} // namespace Metrics
+
+#endif // METRICS_H
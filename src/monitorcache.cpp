@@ -0,0 +1,114 @@
+#include "monitorcache.h"
+#include "daemonprotocol.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char *const Header = "hypr-grid-monitors 1";
+
+} // namespace
+
+MonitorCache::MonitorCache()
+    : MonitorCache(DaemonProtocol::runtimeFilePath(".monitors"))
+{
+}
+
+MonitorCache::MonitorCache(const std::string &path)
+    : m_path(path)
+{
+}
+
+std::string MonitorCache::sessionKey(const std::string &signature, const std::string &socketPath)
+{
+    // A new session recreates the socket, so its identity changes even if
+    // the signature does not
+    struct stat info;
+    if (signature.empty() || socketPath.empty() || ::stat(socketPath.c_str(), &info) != 0) {
+        return std::string();
+    }
+    
+    char identity[96];
+    snprintf(identity, sizeof(identity), " %llu:%llu:%lld.%09ld",
+             static_cast<unsigned long long>(info.st_dev), static_cast<unsigned long long>(info.st_ino),
+             static_cast<long long>(info.st_ctim.tv_sec), static_cast<long>(info.st_ctim.tv_nsec));
+    return signature + identity;
+}
+
+// Line format: the header, "session <key>", then one line per monitor:
+// "monitor <id> <name> <x> <y> <width> <height> <scale> <left> <top> <right> <bottom>"
+bool MonitorCache::load(const std::string &session, std::vector<MonitorInfo> &monitors) const
+{
+    monitors.clear();
+    if (session.empty()) {
+        return false;
+    }
+    
+    FILE *file = fopen(m_path.c_str(), "re");
+    if (!file) {
+        return false;
+    }
+    
+    char line[512];
+    bool valid = fgets(line, sizeof(line), file) && strncmp(line, Header, strlen(Header)) == 0 &&
+                 fgets(line, sizeof(line), file) && strcmp(line, ("session " + session + "\n").c_str()) == 0;
+    
+    while (valid && fgets(line, sizeof(line), file)) {
+        MonitorInfo monitor;
+        char name[128];
+        valid = sscanf(line, "monitor %d %127s %d %d %d %d %lf %d %d %d %d", &monitor.id, name,
+                       &monitor.x, &monitor.y, &monitor.width, &monitor.height, &monitor.scale,
+                       &monitor.reservedLeft, &monitor.reservedTop, &monitor.reservedRight,
+                       &monitor.reservedBottom) == 11;
+        monitor.name = name;
+        monitors.push_back(monitor);
+    }
+    fclose(file);
+    
+    if (!valid || monitors.empty()) {
+        monitors.clear();
+        return false;
+    }
+    return true;
+}
+
+bool MonitorCache::store(const std::string &session, const std::vector<MonitorInfo> &monitors) const
+{
+    if (session.empty() || monitors.empty()) {
+        return false;
+    }
+    
+    // Write aside and rename, so a concurrent load never sees half a file
+    const std::string temporary = m_path + "." + std::to_string(::getpid());
+    FILE *file = fopen(temporary.c_str(), "we");
+    if (!file) {
+        return false;
+    }
+    ::fchmod(fileno(file), 0600);
+    
+    bool ok = fprintf(file, "%s\nsession %s\n", Header, session.c_str()) > 0;
+    for (const MonitorInfo &monitor : monitors) {
+        // Names with spaces would not read back; such a layout is not cached
+        ok = ok && !monitor.name.empty() && monitor.name.find_first_of(" \t\n") == std::string::npos &&
+             fprintf(file, "monitor %d %s %d %d %d %d %.17g %d %d %d %d\n", monitor.id, monitor.name.c_str(),
+                     monitor.x, monitor.y, monitor.width, monitor.height, monitor.scale,
+                     monitor.reservedLeft, monitor.reservedTop, monitor.reservedRight,
+                     monitor.reservedBottom) > 0;
+    }
+    ok = fclose(file) == 0 && ok;
+    
+    if (!ok || ::rename(temporary.c_str(), m_path.c_str()) != 0) {
+        ::unlink(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+void MonitorCache::invalidate() const
+{
+    ::unlink(m_path.c_str());
+}
@@ -0,0 +1,45 @@
+#ifndef MONITORCACHE_H
+#define MONITORCACHE_H
+
+// Monitor geometry, scale and reserved areas cached between invocations,
+// so a one-shot apply can leave the monitors query out of its round-trip.
+// Monitor layouts rarely change; callers revalidate only on a mismatch
+// signal (the focused monitor is not in the cache, a placement failed or
+// landed elsewhere) by invalidating and querying again.
+//
+// The file lives in the runtime directory next to the daemon socket. It is
+// tied to one compositor session by the instance signature and the
+// identity of the instance's request socket, so a cache of an earlier
+// session is never served even if a signature came back.
+//
+// Plain C++ so the benchmarks can use it without Qt.
+
+#include "hyprlandjson.h"
+
+#include <string>
+#include <vector>
+
+class MonitorCache
+{
+public:
+    // Defaults to hypr-grid-manager[-<signature>].monitors in the runtime directory
+    MonitorCache();
+    explicit MonitorCache(const std::string &path);
+    
+    // Identifies the running compositor session: signature plus device,
+    // inode and change time of its request socket. Empty when there is none.
+    static std::string sessionKey(const std::string &signature, const std::string &socketPath);
+    
+    // Monitors stored for this session; false when missing or foreign
+    bool load(const std::string &session, std::vector<MonitorInfo> &monitors) const;
+    
+    // Replace the cache atomically; readers see the old or the new file
+    bool store(const std::string &session, const std::vector<MonitorInfo> &monitors) const;
+    
+    void invalidate() const;
+    
+private:
+    std::string m_path;
+};
+
+#endif // MONITORCACHE_H
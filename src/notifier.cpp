@@ -0,0 +1,131 @@
+#include "notifier.h"
+#include "trace.h"
+
+#include <QDBusMessage>
+#include <QDBusPendingCall>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QVariantMap>
+#include <QDebug>
+
+namespace {
+
+const char *const Service = "org.freedesktop.Notifications";
+const char *const Path = "/org/freedesktop/Notifications";
+const char *const Interface = "org.freedesktop.Notifications";
+
+// A notification daemon that does not answer in time is treated as gone
+const int CallTimeoutMs = 500;
+
+} // namespace
+
+Notifier::Notifier(QObject *parent)
+    : Notifier(QDBusConnection::sessionBus(), parent)
+{
+}
+
+Notifier::Notifier(const QDBusConnection &connection, QObject *parent)
+    : QObject(parent), m_connection(connection), m_serviceAvailable(connection.isConnected()),
+      m_inFlight(nullptr), m_replacesId(0), m_hasQueued(false), m_queuedTimeout(0),
+      m_fallbackResolved(false)
+{
+    // Forget the bubble once it is gone, otherwise the next notification
+    // would replace a closed one
+    if (m_serviceAvailable) {
+        m_connection.connect(Service, Path, Interface, "NotificationClosed",
+                             this, SLOT(onNotificationClosed(uint,uint)));
+    }
+}
+
+Notifier::~Notifier()
+{
+    if (m_inFlight) {
+        m_inFlight->waitForFinished();
+    }
+}
+
+bool Notifier::notify(const QString &title, const QString &message, int timeoutMs)
+{
+    if (!m_serviceAvailable) {
+        return spawnFallback(title, message, timeoutMs);
+    }
+    
+    // Coalesce: the call in flight will send the newest message when it returns
+    if (m_inFlight) {
+        m_hasQueued = true;
+        m_queuedTitle = title;
+        m_queuedMessage = message;
+        m_queuedTimeout = timeoutMs;
+        return true;
+    }
+    
+    sendNotify(title, message, timeoutMs);
+    return true;
+}
+
+void Notifier::sendNotify(const QString &title, const QString &message, int timeoutMs)
+{
+    TRACE_SPAN("notify.dbus", "notify");
+    
+    QDBusMessage call = QDBusMessage::createMethodCall(Service, Path, Interface, "Notify");
+    
+    // Transient: the bubble is not kept in the notification history
+    QVariantMap hints;
+    hints["transient"] = true;
+    hints["desktop-entry"] = QString("hypr-grid-manager");
+    
+    call << QString("Hypr Grid Manager") << m_replacesId << QString("hypr-grid-manager")
+         << title << message << QStringList() << hints << timeoutMs;
+    
+    m_inFlight = new QDBusPendingCallWatcher(m_connection.asyncCall(call, CallTimeoutMs), this);
+    connect(m_inFlight, &QDBusPendingCallWatcher::finished, this, &Notifier::onNotifyFinished);
+}
+
+void Notifier::onNotifyFinished(QDBusPendingCallWatcher *watcher)
+{
+    QDBusPendingReply<uint> reply = *watcher;
+    watcher->deleteLater();
+    m_inFlight = nullptr;
+    
+    if (reply.isError()) {
+        qWarning() << "Notification failed:" << reply.error().message();
+        m_replacesId = 0;
+        
+        // No notification service on the bus; use notify-send from now on
+        if (reply.error().type() == QDBusError::ServiceUnknown) {
+            m_serviceAvailable = false;
+        }
+    } else {
+        m_replacesId = reply.value();
+    }
+    
+    if (m_hasQueued) {
+        m_hasQueued = false;
+        notify(m_queuedTitle, m_queuedMessage, m_queuedTimeout);
+    }
+}
+
+void Notifier::onNotificationClosed(uint id, uint reason)
+{
+    Q_UNUSED(reason);
+    if (id == m_replacesId) {
+        m_replacesId = 0;
+    }
+}
+
+bool Notifier::spawnFallback(const QString &title, const QString &message, int timeoutMs)
+{
+    if (!m_fallbackResolved) {
+        m_fallbackPath = QStandardPaths::findExecutable("notify-send");
+        m_fallbackResolved = true;
+    }
+    if (m_fallbackPath.isEmpty()) {
+        return false;
+    }
+    
+    TRACE_SPAN("notify.spawn", "notify");
+    return QProcess::startDetached(m_fallbackPath, QStringList()
+        << "-a" << "Hypr Grid Manager" << "-t" << QString::number(timeoutMs) << title << message);
+}
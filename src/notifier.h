@@ -0,0 +1,62 @@
+#ifndef NOTIFIER_H
+#define NOTIFIER_H
+
+#include <QObject>
+#include <QDBusConnection>
+#include <QString>
+
+class QDBusPendingCallWatcher;
+
+// Desktop notifications through org.freedesktop.Notifications. Calls are
+// asynchronous, so an apply never waits for the notification daemon.
+// Consecutive notifications reuse the id of the previous bubble
+// (replaces_id), so rapid applies update one bubble instead of stacking.
+// While a call is in flight only the newest message is kept and sent once
+// the id is known.
+//
+// The connection is injectable so tests can point it at a stand-in bus;
+// by default the session bus (DBUS_SESSION_BUS_ADDRESS) is used. Without a
+// notification service, notify-send is started detached as a fallback.
+class Notifier : public QObject
+{
+    Q_OBJECT
+    
+public:
+    explicit Notifier(QObject *parent = nullptr);
+    Notifier(const QDBusConnection &connection, QObject *parent = nullptr);
+    
+    // Waits briefly for a call still in flight, so one-shot processes do
+    // not exit before the message was delivered
+    ~Notifier();
+    
+    // Returns false only when no notification mechanism is available
+    bool notify(const QString &title, const QString &message, int timeoutMs);
+    
+    // Id of the bubble the next notification replaces, 0 for a new one
+    uint replacesId() const { return m_replacesId; }
+    
+private slots:
+    void onNotifyFinished(QDBusPendingCallWatcher *watcher);
+    void onNotificationClosed(uint id, uint reason);
+    
+private:
+    void sendNotify(const QString &title, const QString &message, int timeoutMs);
+    bool spawnFallback(const QString &title, const QString &message, int timeoutMs);
+    
+    QDBusConnection m_connection;
+    bool m_serviceAvailable;
+    QDBusPendingCallWatcher *m_inFlight;
+    uint m_replacesId;
+    
+    // Newest message that arrived while a call was in flight
+    bool m_hasQueued;
+    QString m_queuedTitle;
+    QString m_queuedMessage;
+    int m_queuedTimeout;
+    
+    // notify-send, looked up once
+    bool m_fallbackResolved;
+    QString m_fallbackPath;
+};
+
+#endif // NOTIFIER_H
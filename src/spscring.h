@@ -0,0 +1,59 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+// Bounded single-producer, single-consumer ring of fixed-size items. One
+// thread pushes and one other thread pops; neither takes a lock or
+// allocates, and a full ring refuses the item rather than blocking the
+// producer. The two indices live on separate cache lines so the threads
+// do not contend for one.
+//
+// Plain C++, header only.
+
+#include <atomic>
+#include <cstddef>
+
+template <typename T, size_t Capacity>
+class SpscRing
+{
+    static_assert(Capacity > 1 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+    
+public:
+    // Producer side. False when the ring is full.
+    bool push(const T &item)
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        m_items[head & (Capacity - 1)] = item;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Consumer side. False when the ring is empty.
+    bool pop(T &item)
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = m_items[tail & (Capacity - 1)];
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Exact from either side only while the other one is idle
+    size_t size() const
+    {
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+    }
+    
+    static constexpr size_t capacity() { return Capacity; }
+    
+private:
+    alignas(64) std::atomic<size_t> m_head{0};      // Next slot to write
+    alignas(64) std::atomic<size_t> m_tail{0};      // Next slot to read
+    alignas(64) T m_items[Capacity];
+};
+
+#endif // SPSCRING_H
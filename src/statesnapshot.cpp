@@ -0,0 +1,289 @@
+#include "statesnapshot.h"
+
+#include <atomic>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+const uint32_t Magic = 0x31534748;      // "HGS1"
+const uint32_t LayoutVersion = 1;
+
+// Bounded so a reader never spins on a writer that died mid-write
+const int MaxReadAttempts = 64;
+
+// Fixed-size copy of SnapshotState, moved in and out of the segment word by word
+struct Record {
+    uint64_t windowAddress;
+    int32_t windowX;
+    int32_t windowY;
+    int32_t windowWidth;
+    int32_t windowHeight;
+    int32_t windowWorkspaceId;
+    int32_t windowMonitorId;
+    int32_t windowFloating;
+    int32_t windowMapped;
+    double monitorScale;
+    int32_t monitorId;
+    int32_t monitorX;
+    int32_t monitorY;
+    int32_t monitorWidth;
+    int32_t monitorHeight;
+    int32_t reservedLeft;
+    int32_t reservedTop;
+    int32_t reservedRight;
+    int32_t reservedBottom;
+    int32_t monitorActiveWorkspaceId;
+    int32_t workspaceId;
+    int32_t workspaceWindowCount;
+    int32_t valid;
+    char monitorName[32];
+};
+
+const size_t RecordWords = (sizeof(Record) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+uint32_t monotonicMs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint32_t>(static_cast<uint64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000);
+}
+
+} // namespace
+
+// Shared between processes, so only lock-free atomics of 32 bits: those are
+// plain loads on every platform and work on a read-only mapping
+struct SnapshotSegment {
+    std::atomic<uint32_t> magic;
+    std::atomic<uint32_t> version;
+    std::atomic<uint32_t> publisherPid;     // 0 once withdrawn
+    std::atomic<uint32_t> heartbeatMs;      // CLOCK_MONOTONIC, wraps after 49 days
+    std::atomic<uint32_t> sequence;         // Odd while a write is in progress
+    std::atomic<uint32_t> words[RecordWords];
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "the snapshot needs lock-free atomics");
+
+StateSnapshotWriter::StateSnapshotWriter()
+    : m_segment(nullptr)
+{
+}
+
+StateSnapshotWriter::~StateSnapshotWriter()
+{
+    close();
+}
+
+bool StateSnapshotWriter::open(const std::string &path)
+{
+    close();
+    
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return false;
+    }
+    if (::ftruncate(fd, sizeof(SnapshotSegment)) != 0) {
+        ::close(fd);
+        return false;
+    }
+    void *mapping = ::mmap(nullptr, sizeof(SnapshotSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    
+    // Nothing is readable until the first publish
+    m_segment = static_cast<SnapshotSegment *>(mapping);
+    publish(nullptr);
+    m_segment->version.store(LayoutVersion, std::memory_order_relaxed);
+    m_segment->magic.store(Magic, std::memory_order_relaxed);
+    m_segment->publisherPid.store(static_cast<uint32_t>(::getpid()), std::memory_order_relaxed);
+    heartbeat();
+    return true;
+}
+
+void StateSnapshotWriter::publish(const SnapshotState *state)
+{
+    if (!m_segment) {
+        return;
+    }
+    
+    Record record;
+    memset(&record, 0, sizeof(record));
+    if (state) {
+        record.windowAddress = state->window.address;
+        record.windowX = state->window.x;
+        record.windowY = state->window.y;
+        record.windowWidth = state->window.width;
+        record.windowHeight = state->window.height;
+        record.windowWorkspaceId = state->window.workspaceId;
+        record.windowMonitorId = state->window.monitorId;
+        record.windowFloating = state->window.floating;
+        record.windowMapped = state->window.mapped;
+        record.monitorScale = state->monitor.scale;
+        record.monitorId = state->monitor.id;
+        record.monitorX = state->monitor.x;
+        record.monitorY = state->monitor.y;
+        record.monitorWidth = state->monitor.width;
+        record.monitorHeight = state->monitor.height;
+        record.reservedLeft = state->monitor.reservedLeft;
+        record.reservedTop = state->monitor.reservedTop;
+        record.reservedRight = state->monitor.reservedRight;
+        record.reservedBottom = state->monitor.reservedBottom;
+        record.monitorActiveWorkspaceId = state->monitor.activeWorkspaceId;
+        record.workspaceId = state->workspaceId;
+        record.workspaceWindowCount = state->workspaceWindowCount;
+        record.valid = 1;
+        strncpy(record.monitorName, state->monitor.name.c_str(), sizeof(record.monitorName) - 1);
+    }
+    
+    uint32_t words[RecordWords] = {};
+    memcpy(words, &record, sizeof(record));
+    
+    // Odd sequence first, then the data, then even again
+    const uint32_t sequence = m_segment->sequence.load(std::memory_order_relaxed);
+    m_segment->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < RecordWords; ++i) {
+        m_segment->words[i].store(words[i], std::memory_order_relaxed);
+    }
+    m_segment->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+void StateSnapshotWriter::heartbeat()
+{
+    if (m_segment) {
+        m_segment->heartbeatMs.store(monotonicMs(), std::memory_order_release);
+    }
+}
+
+void StateSnapshotWriter::close()
+{
+    if (!m_segment) {
+        return;
+    }
+    
+    publish(nullptr);
+    m_segment->publisherPid.store(0, std::memory_order_release);
+    ::munmap(m_segment, sizeof(SnapshotSegment));
+    m_segment = nullptr;
+}
+
+StateSnapshotReader::StateSnapshotReader()
+    : m_segment(nullptr)
+{
+}
+
+StateSnapshotReader::~StateSnapshotReader()
+{
+    if (m_segment) {
+        ::munmap(const_cast<SnapshotSegment *>(m_segment), sizeof(SnapshotSegment));
+    }
+}
+
+bool StateSnapshotReader::open(const std::string &path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    
+    // A segment of another size belongs to another layout version
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || info.st_size != static_cast<off_t>(sizeof(SnapshotSegment))) {
+        ::close(fd);
+        return false;
+    }
+    
+    void *mapping = ::mmap(nullptr, sizeof(SnapshotSegment), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    m_segment = static_cast<const SnapshotSegment *>(mapping);
+    return true;
+}
+
+StateSnapshotReader::Result StateSnapshotReader::read(SnapshotState &state, int maxAgeMs) const
+{
+    if (!m_segment || m_segment->magic.load(std::memory_order_relaxed) != Magic ||
+        m_segment->version.load(std::memory_order_relaxed) != LayoutVersion) {
+        return Unavailable;
+    }
+    if (m_segment->publisherPid.load(std::memory_order_acquire) == 0) {
+        return NoPublisher;
+    }
+    const uint32_t age = monotonicMs() - m_segment->heartbeatMs.load(std::memory_order_acquire);
+    if (age > static_cast<uint32_t>(maxAgeMs)) {
+        return Stale;
+    }
+    
+    uint32_t words[RecordWords];
+    bool consistent = false;
+    for (int attempt = 0; attempt < MaxReadAttempts && !consistent; ++attempt) {
+        const uint32_t before = m_segment->sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+        for (size_t i = 0; i < RecordWords; ++i) {
+            words[i] = m_segment->words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        consistent = m_segment->sequence.load(std::memory_order_relaxed) == before;
+    }
+    if (!consistent) {
+        return Contended;
+    }
+    
+    Record record;
+    memcpy(&record, words, sizeof(record));
+    if (!record.valid) {
+        return Invalid;
+    }
+    
+    state.window = WindowInfo();
+    state.window.address = record.windowAddress;
+    state.window.x = record.windowX;
+    state.window.y = record.windowY;
+    state.window.width = record.windowWidth;
+    state.window.height = record.windowHeight;
+    state.window.workspaceId = record.windowWorkspaceId;
+    state.window.monitorId = record.windowMonitorId;
+    state.window.floating = record.windowFloating != 0;
+    state.window.mapped = record.windowMapped != 0;
+    state.monitor = MonitorInfo();
+    state.monitor.id = record.monitorId;
+    state.monitor.name.assign(record.monitorName, strnlen(record.monitorName, sizeof(record.monitorName)));
+    state.monitor.x = record.monitorX;
+    state.monitor.y = record.monitorY;
+    state.monitor.width = record.monitorWidth;
+    state.monitor.height = record.monitorHeight;
+    state.monitor.scale = record.monitorScale;
+    state.monitor.reservedLeft = record.reservedLeft;
+    state.monitor.reservedTop = record.reservedTop;
+    state.monitor.reservedRight = record.reservedRight;
+    state.monitor.reservedBottom = record.reservedBottom;
+    state.monitor.activeWorkspaceId = record.monitorActiveWorkspaceId;
+    state.monitor.focused = true;
+    state.workspaceId = record.workspaceId;
+    state.workspaceWindowCount = record.workspaceWindowCount;
+    return Fresh;
+}
+
+const char *StateSnapshotReader::resultName(Result result)
+{
+    switch (result) {
+    case Fresh: return "fresh";
+    case Unavailable: return "unavailable";
+    case NoPublisher: return "no publisher";
+    case Stale: return "stale";
+    case Invalid: return "invalid";
+    case Contended: return "contended";
+    }
+    return "unknown";
+}
@@ -0,0 +1,89 @@
+#ifndef STATESNAPSHOT_H
+#define STATESNAPSHOT_H
+
+// Placement state published by a long-lived hypr-grid-manager (the daemon,
+// which mirrors Hyprland from its event socket) so one-shot invocations can
+// skip the query round-trip. The segment is a small file in the runtime
+// directory that every process maps. A seqlock keeps it consistent without
+// locking readers out: the writer makes the sequence odd while it writes,
+// and a reader retries when the sequence was odd or changed under it. Once
+// mapped, a read makes no system calls (the clock is read through the vDSO).
+//
+// The publisher refreshes a heartbeat every second. Readers treat the data
+// as stale when the heartbeat is older than maxAgeMs, which covers a
+// publisher that crashed without withdrawing the snapshot.
+//
+// Plain C++ so the benchmarks can use it without Qt.
+
+#include "hyprlandjson.h"
+
+#include <cstdint>
+#include <string>
+
+struct SnapshotSegment;
+
+struct SnapshotState {
+    WindowInfo window;              // Focused window; no class or title
+    MonitorInfo monitor;            // Focused monitor; name cut to 31 bytes
+    int workspaceId = -1;
+    int workspaceWindowCount = 0;
+};
+
+class StateSnapshotWriter
+{
+public:
+    StateSnapshotWriter();
+    ~StateSnapshotWriter();
+    
+    StateSnapshotWriter(const StateSnapshotWriter &) = delete;
+    StateSnapshotWriter &operator=(const StateSnapshotWriter &) = delete;
+    
+    // Create or take over the segment; one publisher per Hyprland instance
+    bool open(const std::string &path);
+    bool isOpen() const { return m_segment != nullptr; }
+    
+    // Publish the current state, or nullptr when there is nothing usable
+    // right now (mirror resyncing, floating state unknown)
+    void publish(const SnapshotState *state);
+    void heartbeat();
+    
+    // Tell readers to fall back to IPC, then unmap
+    void close();
+    
+private:
+    SnapshotSegment *m_segment;
+};
+
+class StateSnapshotReader
+{
+public:
+    enum Result {
+        Fresh,
+        Unavailable,    // No segment, or one of another layout version
+        NoPublisher,    // Withdrawn by a publisher that exited
+        Stale,          // Heartbeat too old
+        Invalid,        // Publisher has no usable state right now
+        Contended       // Kept changing while being read
+    };
+    
+    static constexpr int DefaultMaxAgeMs = 3000;
+    
+    StateSnapshotReader();
+    ~StateSnapshotReader();
+    
+    StateSnapshotReader(const StateSnapshotReader &) = delete;
+    StateSnapshotReader &operator=(const StateSnapshotReader &) = delete;
+    
+    // Map the segment read-only; false when no publisher ever created it
+    bool open(const std::string &path);
+    bool isOpen() const { return m_segment != nullptr; }
+    
+    Result read(SnapshotState &state, int maxAgeMs = DefaultMaxAgeMs) const;
+    
+    static const char *resultName(Result result);
+    
+private:
+    const SnapshotSegment *m_segment;
+};
+
+#endif // STATESNAPSHOT_H
@@ -0,0 +1,145 @@
+#include "trace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+#include <errno.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace Trace {
+
+namespace detail {
+std::atomic<bool> enabled{false};
+}
+
+namespace {
+
+std::mutex g_mutex;
+FILE *g_file = nullptr;
+long g_pid = 0;
+
+// Open spans on this thread; the file is flushed when the outermost one ends
+thread_local int t_depth = 0;
+
+long currentThreadId()
+{
+    thread_local long tid = static_cast<long>(::syscall(SYS_gettid));
+    return tid;
+}
+
+void writeEscaped(FILE *file, const std::string &text)
+{
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            std::fputc('\\', file);
+            std::fputc(c, file);
+        } else if (c < 0x20) {
+            std::fprintf(file, "\\u%04x", c);
+        } else {
+            std::fputc(c, file);
+        }
+    }
+}
+
+// Caller holds g_mutex
+void writeEvent(const char *name, const char *category, int64_t begin, int64_t duration,
+                const std::string &detail)
+{
+    std::fprintf(g_file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"pid\":%ld,\"tid\":%ld,\"ts\":%lld",
+                 name, category, g_pid, currentThreadId(), static_cast<long long>(begin));
+    if (duration >= 0) {
+        std::fprintf(g_file, ",\"ph\":\"X\",\"dur\":%lld", static_cast<long long>(duration));
+    } else {
+        std::fputs(",\"ph\":\"i\",\"s\":\"t\"", g_file);
+    }
+    if (!detail.empty()) {
+        std::fputs(",\"args\":{\"detail\":\"", g_file);
+        writeEscaped(g_file, detail);
+        std::fputs("\"}", g_file);
+    }
+    std::fputc('}', g_file);
+}
+
+} // namespace
+
+bool start(const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (g_file) {
+        return false;
+    }
+    
+    g_file = std::fopen(path.c_str(), "we");
+    if (!g_file) {
+        std::fprintf(stderr, "Cannot write trace to %s: %s\n", path.c_str(), std::strerror(errno));
+        return false;
+    }
+    
+    // Every later event starts with a comma, so the metadata record goes first
+    g_pid = static_cast<long>(::getpid());
+    std::fprintf(g_file, "[{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%ld,\"tid\":%ld,"
+                 "\"args\":{\"name\":\"%s\"}}",
+                 g_pid, currentThreadId(), program_invocation_short_name);
+    detail::enabled.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+void finish()
+{
+    std::lock_guard<std::mutex> lock(g_mutex);
+    detail::enabled.store(false, std::memory_order_relaxed);
+    if (!g_file) {
+        return;
+    }
+    
+    std::fputs("\n]\n", g_file);
+    std::fclose(g_file);
+    g_file = nullptr;
+}
+
+int64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t beginSpan()
+{
+    ++t_depth;
+    return now();
+}
+
+void endSpan(const char *name, const char *category, int64_t begin, std::string detail)
+{
+    const int64_t end = now();
+    const bool outermost = --t_depth == 0;
+    
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (!g_file) {
+        return;
+    }
+    writeEvent(name, category, begin, end - begin, detail);
+    
+    // Keep the file complete up to the last finished operation, so a
+    // daemon killed with SIGTERM still leaves a usable trace
+    if (outermost) {
+        std::fflush(g_file);
+    }
+}
+
+void instant(const char *name, const char *category, const std::string &detail)
+{
+    if (!enabled()) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (g_file) {
+        writeEvent(name, category, now(), -1, detail);
+    }
+}
+
+} // namespace Trace
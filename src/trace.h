@@ -0,0 +1,81 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Scoped latency spans for the apply pipeline, written as Chrome trace-event
+// JSON (chrome://tracing, ui.perfetto.dev). Enabled with --trace=<file> or
+// HYPR_GRID_TRACE=<file>. While disabled a span is a single relaxed atomic
+// load: no clock read, no allocation. Plain C++ so any module can use it.
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace Trace {
+
+namespace detail {
+extern std::atomic<bool> enabled;
+}
+
+inline bool enabled()
+{
+    return detail::enabled.load(std::memory_order_relaxed);
+}
+
+// Start recording into `path`. Events are streamed in the JSON array form,
+// which trace viewers load even when the process was killed before
+// finish(), so a long-running daemon can be traced too.
+bool start(const std::string &path);
+
+// Close the trace file and stop recording
+void finish();
+
+// Microseconds on the trace clock
+int64_t now();
+
+// Used by Span: open a span on this thread and return its start time, then
+// record it as complete. `name` and `category` must be string literals.
+int64_t beginSpan();
+void endSpan(const char *name, const char *category, int64_t begin, std::string detail);
+
+// Record a point in time, e.g. an event received from Hyprland
+void instant(const char *name, const char *category = "app", const std::string &detail = std::string());
+
+class Span
+{
+public:
+    explicit Span(const char *name, const char *category = "app")
+        : m_name(name), m_category(category), m_begin(enabled() ? beginSpan() : -1)
+    {
+    }
+    
+    ~Span()
+    {
+        if (m_begin >= 0) {
+            endSpan(m_name, m_category, m_begin, std::move(m_detail));
+        }
+    }
+    
+    Span(const Span &) = delete;
+    Span &operator=(const Span &) = delete;
+    
+    // True when the span is being recorded; check it before building a detail
+    bool active() const { return m_begin >= 0; }
+    
+    // Shown as args.detail in the trace viewer
+    void setDetail(std::string detail) { m_detail = std::move(detail); }
+    
+private:
+    const char *m_name;
+    const char *m_category;
+    int64_t m_begin;
+    std::string m_detail;
+};
+
+// Records from construction to destruction of the scope, e.g. TRACE_SPAN("config.load")
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SPAN(...) Trace::Span TRACE_CONCAT(traceSpan_, __LINE__)(__VA_ARGS__)
+
+} // namespace Trace
+
+#endif // TRACE_H
@@ -0,0 +1,45 @@
+#include <QApplication>
+#include <QDebug>
+
+#include "mainwindow.h"
+#include "gridmanager.h"
+#include "hyprlandipc.h"
+
+// hypr-grid-manager-ui: the configuration UI. It is a binary of its own so
+// the CLI that keybindings launch links only Qt Core and DBus; running
+// hypr-grid-manager with -u or without arguments starts this one.
+
+void ensureGridManagerFloating()
+{
+    // Keep the grid manager floating and always focused for better
+    // accessibility; both rules go out in one batched request
+    HyprlandIPC ipc;
+    ipc.batch(QStringList()
+        << "keyword windowrulev2 float,class:^(hypr-grid-manager)$"
+        << "keyword windowrulev2 stayfocused,class:^(hypr-grid-manager)$",
+        IpcFormat::Ack);
+}
+
+int main(int argc, char *argv[])
+{
+    QApplication app(argc, argv);
+    app.setApplicationName("Hypr Grid Manager");
+    app.setOrganizationName("Hyprland");
+    app.setApplicationVersion("1.0.0");
+    
+    // The window class the rules above match, not the binary name
+    QGuiApplication::setDesktopFileName("hypr-grid-manager");
+    
+    GridManager gridManager;
+    if (!gridManager.initialize()) {
+        qCritical() << "Failed to initialize grid manager";
+        return 1;
+    }
+    
+    // Ensure grid manager window stays floating
+    ensureGridManagerFloating();
+    
+    MainWindow mainWindow(gridManager);
+    mainWindow.show();
+    return app.exec();
+}
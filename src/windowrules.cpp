@@ -0,0 +1,76 @@
+#include "windowrules.h"
+
+void WindowRuleSet::set(const QString &matcher, const QStringList &effects)
+{
+    if (effects.isEmpty()) {
+        m_desired.remove(matcher);
+    } else {
+        m_desired.insert(matcher, effects);
+    }
+}
+
+void WindowRuleSet::remove(const QString &matcher)
+{
+    m_desired.remove(matcher);
+}
+
+void WindowRuleSet::removeAll()
+{
+    m_desired.clear();
+}
+
+QStringList WindowRuleSet::pendingCommands() const
+{
+    QStringList commands;
+    
+    // "unset" drops every rule for a matcher, so a changed set is removed
+    // and added again
+    for (auto it = m_installed.constBegin(); it != m_installed.constEnd(); ++it) {
+        if (m_desired.value(it.key()) != it.value()) {
+            commands << QString("keyword windowrulev2 unset,%1").arg(it.key());
+        }
+    }
+    
+    for (auto it = m_desired.constBegin(); it != m_desired.constEnd(); ++it) {
+        if (m_installed.value(it.key()) == it.value()) {
+            continue;
+        }
+        for (const QString &effect : it.value()) {
+            commands << QString("keyword windowrulev2 %1,%2").arg(effect, it.key());
+        }
+    }
+    
+    return commands;
+}
+
+QString WindowRuleSet::matcher(const QString &windowClass, const QString &title)
+{
+    QString result = QString("class:^(%1)$").arg(escapeRegex(windowClass));
+    if (!title.isEmpty()) {
+        result += QString(",title:^(%1)$").arg(escapeRegex(title));
+    }
+    return result;
+}
+
+QString WindowRuleSet::escapeRegex(const QString &text)
+{
+    // Regex metacharacters, plus ',' and ':' which Hyprland's rule parser
+    // would otherwise read as field separators
+    static const QString special = QStringLiteral("\\^$.|?*+()[]{},:");
+    
+    QString escaped;
+    escaped.reserve(text.size() * 2);
+    for (const QChar c : text) {
+        if (c == ';' || c == '\n' || c == '\r') {
+            // These split batched commands and cannot be sent at all,
+            // match them with any character instead
+            escaped += '.';
+            continue;
+        }
+        if (special.contains(c)) {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
@@ -0,0 +1,42 @@
+#ifndef WINDOWRULES_H
+#define WINDOWRULES_H
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+// Tracks the windowrulev2 rules this tool has installed in Hyprland and
+// turns changes into keyword commands. Rules are grouped by matcher, since
+// Hyprland removes rules with "windowrulev2 unset,<matcher>". That lets us
+// remove our own rules without reloading the user's whole config.
+class WindowRuleSet
+{
+public:
+    // Replace the rule effects (e.g. "float", "move 10 20") for a matcher
+    void set(const QString &matcher, const QStringList &effects);
+    void remove(const QString &matcher);
+    void removeAll();
+    
+    // True while there are installed rules or unsynced changes
+    bool isEmpty() const { return m_installed.isEmpty() && m_desired.isEmpty(); }
+    bool hasPendingChanges() const { return m_installed != m_desired; }
+    
+    // Keyword commands that bring Hyprland to the desired rules: removals
+    // first, then additions. Meant to be sent as a single batch.
+    QStringList pendingCommands() const;
+    
+    // Record that pendingCommands() were applied
+    void markSynced() { m_installed = m_desired; }
+    
+    // Matcher for a window with the given class and title
+    static QString matcher(const QString &windowClass, const QString &title);
+    
+    // Escape text so a windowrulev2 regex matches it literally
+    static QString escapeRegex(const QString &text);
+    
+private:
+    QMap<QString, QStringList> m_installed;   // Matcher -> effects Hyprland has
+    QMap<QString, QStringList> m_desired;     // Matcher -> effects we want
+};
+
+#endif // WINDOWRULES_H
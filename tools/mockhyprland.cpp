@@ -0,0 +1,1012 @@
+// hypr-grid-mock-hyprland: stands in for a running Hyprland instance so the
+// IPC paths can be exercised without a compositor. It creates
+// hypr/<signature>/.socket.sock and .socket2.sock, keeps a small model of
+// monitors, workspaces and clients, applies dispatchers to it and emits the
+// matching events.
+//
+// Usage:
+//   hypr-grid-mock-hyprland [options]                 serve until SIGINT/SIGTERM
+//   hypr-grid-mock-hyprland [options] -- cmd [args]   run cmd against the mock
+//   hypr-grid-mock-hyprland --hyprctl [hyprctl args]  hyprctl-compatible client
+//
+// Options:
+//   --signature NAME         instance signature (default mock_<pid>)
+//   --runtime-dir DIR        where hypr/<signature>/ is created (default: new temp dir)
+//   --monitors SPEC          NAME:WxH[@SCALE][+X+Y][/L:T:R:B],... (default DP-1:2560x1440)
+//                            /L:T:R:B reserves space on each side like a bar
+//                            does; without it the first monitor reserves 40
+//                            px at the top
+//   --clients N              windows spread over the workspaces (default 4)
+//   --workspaces N           workspaces per monitor (default 2)
+//   --latency MS             delay before every reply (default 0)
+//   --install-hyprctl DIR    write a hyprctl stand-in script into DIR
+//
+// Without a command the environment to use is printed as shell exports.
+// "j/mockstats" returns how many requests and commands were served so far,
+// and when (CLOCK_MONOTONIC, microseconds) the first request since the
+// previous "j/mockstats" arrived, -1 if none did; it is not counted itself.
+// Plain C++ with no Qt so it can run anywhere the tests or benchmarks do.
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+
+volatile sig_atomic_t g_stop = 0;
+
+void onStopSignal(int)
+{
+    g_stop = 1;
+}
+
+// Model
+
+struct Monitor {
+    int id = 0;
+    std::string name;
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+    double scale = 1.0;
+    int activeWorkspace = 1;
+    int reservedLeft = 0;
+    int reservedTop = 0;
+    int reservedRight = 0;
+    int reservedBottom = 0;
+    bool reservedGiven = false;
+};
+
+struct Workspace {
+    int id = 0;
+    int monitor = 0;
+};
+
+struct Client {
+    uint64_t address = 0;
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+    int workspace = 1;
+    bool floating = false;
+    std::string windowClass;
+    std::string title;
+    int pid = 0;
+};
+
+struct Model {
+    std::vector<Monitor> monitors;
+    std::vector<Workspace> workspaces;
+    std::vector<Client> clients;
+    std::vector<std::string> rules;
+    int focusedMonitor = 0;
+    uint64_t activeWindow = 0;
+    uint64_t nextAddress = 0x5a4f3e200000;
+    int nextPid = 4000;
+};
+
+Model g_model;
+std::vector<int> g_eventClients;
+int g_latencyMs = 0;
+
+// Served so far: connections to .socket.sock and commands in them
+long g_requestCount = 0;
+long g_commandCount = 0;
+long long g_firstRequestUs = -1;    // Since the last j/mockstats
+
+long long monotonicUs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<long long>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+std::string format(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+std::string format(const char *fmt, ...)
+{
+    char buffer[1024];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buffer, sizeof(buffer), fmt, args);
+    va_end(args);
+    return buffer;
+}
+
+std::string hexAddress(uint64_t address)
+{
+    return format("%llx", static_cast<unsigned long long>(address));
+}
+
+std::string jsonString(const std::string &text)
+{
+    std::string out = "\"";
+    for (unsigned char c : text) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (c < 0x20) {
+                out += format("\\u%04x", c);
+            } else {
+                out += static_cast<char>(c);
+            }
+        }
+    }
+    return out + "\"";
+}
+
+Monitor *monitorById(int id)
+{
+    for (Monitor &monitor : g_model.monitors) {
+        if (monitor.id == id) {
+            return &monitor;
+        }
+    }
+    return nullptr;
+}
+
+Workspace *workspaceById(int id)
+{
+    for (Workspace &workspace : g_model.workspaces) {
+        if (workspace.id == id) {
+            return &workspace;
+        }
+    }
+    return nullptr;
+}
+
+Client *clientByAddress(uint64_t address)
+{
+    for (Client &client : g_model.clients) {
+        if (client.address == address) {
+            return &client;
+        }
+    }
+    return nullptr;
+}
+
+int windowsOn(int workspace)
+{
+    return static_cast<int>(std::count_if(g_model.clients.begin(), g_model.clients.end(),
+                                          [&](const Client &c) { return c.workspace == workspace; }));
+}
+
+// Tile the non-floating windows of a workspace side by side, like a
+// simplified dwindle layout with 10 px gaps
+void relayout(int workspaceId)
+{
+    Workspace *workspace = workspaceById(workspaceId);
+    Monitor *monitor = workspace ? monitorById(workspace->monitor) : nullptr;
+    if (!monitor) {
+        return;
+    }
+    
+    std::vector<Client *> tiled;
+    for (Client &client : g_model.clients) {
+        if (client.workspace == workspaceId && !client.floating) {
+            tiled.push_back(&client);
+        }
+    }
+    if (tiled.empty()) {
+        return;
+    }
+    
+    const int gap = 10;
+    const int logicalWidth = static_cast<int>(monitor->width / monitor->scale);
+    const int logicalHeight = static_cast<int>(monitor->height / monitor->scale);
+    const int usableWidth = logicalWidth - monitor->reservedLeft - monitor->reservedRight;
+    const int usableHeight = logicalHeight - monitor->reservedTop - monitor->reservedBottom;
+    const int columnWidth = (usableWidth - gap) / static_cast<int>(tiled.size()) - gap;
+    for (size_t i = 0; i < tiled.size(); ++i) {
+        tiled[i]->x = monitor->x + monitor->reservedLeft + gap + static_cast<int>(i) * (columnWidth + gap);
+        tiled[i]->y = monitor->y + monitor->reservedTop + gap;
+        tiled[i]->width = columnWidth;
+        tiled[i]->height = usableHeight - 2 * gap;
+    }
+}
+
+// Events
+
+void emitEvent(const std::string &name, const std::string &data)
+{
+    const std::string line = name + ">>" + data + "\n";
+    for (auto it = g_eventClients.begin(); it != g_eventClients.end();) {
+        // Event sockets are non-blocking; a client that cannot keep up is dropped
+        ssize_t n = send(*it, line.data(), line.size(), MSG_NOSIGNAL);
+        if (n != static_cast<ssize_t>(line.size())) {
+            close(*it);
+            it = g_eventClients.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void focusWindow(uint64_t address)
+{
+    g_model.activeWindow = address;
+    Client *client = clientByAddress(address);
+    if (client) {
+        emitEvent("activewindow", client->windowClass + "," + client->title);
+        emitEvent("activewindowv2", hexAddress(address));
+    } else {
+        emitEvent("activewindow", ",");
+        emitEvent("activewindowv2", "");
+    }
+}
+
+void setFloating(Client &client, bool floating)
+{
+    if (client.floating == floating) {
+        return;
+    }
+    client.floating = floating;
+    
+    if (floating) {
+        // Hyprland centers a freshly floated window at half the monitor size
+        Workspace *workspace = workspaceById(client.workspace);
+        Monitor *monitor = workspace ? monitorById(workspace->monitor) : nullptr;
+        if (monitor) {
+            client.width = static_cast<int>(monitor->width / monitor->scale) / 2;
+            client.height = static_cast<int>(monitor->height / monitor->scale) / 2;
+            client.x = monitor->x + client.width / 2;
+            client.y = monitor->y + client.height / 2;
+        }
+    }
+    relayout(client.workspace);
+    emitEvent("changefloatingmode", hexAddress(client.address) + "," + (floating ? "1" : "0"));
+}
+
+Client &openWindow(const std::string &windowClass, const std::string &title, int workspace)
+{
+    Client client;
+    client.address = g_model.nextAddress;
+    g_model.nextAddress += 0x1f40;
+    client.workspace = workspace;
+    client.windowClass = windowClass;
+    client.title = title;
+    client.pid = g_model.nextPid++;
+    g_model.clients.push_back(client);
+    relayout(workspace);
+    return g_model.clients.back();
+}
+
+// JSON replies, in Hyprland's field order and layout
+
+std::string windowJson(const Client &client)
+{
+    Workspace *workspace = workspaceById(client.workspace);
+    return format("{\n    \"address\": \"0x%s\",\n    \"mapped\": true,\n    \"hidden\": false,\n"
+                  "    \"at\": [%d, %d],\n    \"size\": [%d, %d],\n",
+                  hexAddress(client.address).c_str(), client.x, client.y, client.width, client.height)
+        + format("    \"workspace\": {\n        \"id\": %d,\n        \"name\": \"%d\"\n    },\n"
+                 "    \"floating\": %s,\n    \"pseudo\": false,\n    \"monitor\": %d,\n",
+                 client.workspace, client.workspace, client.floating ? "true" : "false",
+                 workspace ? workspace->monitor : 0)
+        + "    \"class\": " + jsonString(client.windowClass) + ",\n"
+        + "    \"title\": " + jsonString(client.title) + ",\n"
+        + "    \"initialClass\": " + jsonString(client.windowClass) + ",\n"
+        + "    \"initialTitle\": " + jsonString(client.title) + ",\n"
+        + format("    \"pid\": %d,\n    \"xwayland\": false,\n    \"pinned\": false,\n"
+                 "    \"fullscreen\": 0,\n    \"fullscreenClient\": 0,\n    \"grouped\": [],\n"
+                 "    \"tags\": [],\n    \"swallowing\": \"0x0\",\n    \"focusHistoryID\": 0,\n"
+                 "    \"inhibitingIdle\": false\n}", client.pid);
+}
+
+std::string workspaceJson(const Workspace &workspace)
+{
+    Monitor *monitor = monitorById(workspace.monitor);
+    uint64_t last = 0;
+    std::string lastTitle;
+    for (const Client &client : g_model.clients) {
+        if (client.workspace == workspace.id) {
+            last = client.address;
+            lastTitle = client.title;
+        }
+    }
+    return format("{\n    \"id\": %d,\n    \"name\": \"%d\",\n    \"monitor\": %s,\n    \"monitorID\": %d,\n"
+                  "    \"windows\": %d,\n    \"hasfullscreen\": false,\n    \"lastwindow\": \"0x%s\",\n",
+                  workspace.id, workspace.id, jsonString(monitor ? monitor->name : "").c_str(),
+                  workspace.monitor, windowsOn(workspace.id), hexAddress(last).c_str())
+        + "    \"lastwindowtitle\": " + jsonString(lastTitle) + ",\n    \"ispersistent\": false\n}";
+}
+
+std::string monitorJson(const Monitor &monitor)
+{
+    return format("{\n    \"id\": %d,\n    \"name\": %s,\n    \"description\": \"Mock %s\",\n"
+                  "    \"make\": \"Mock\",\n    \"model\": \"Mock\",\n    \"serial\": \"\",\n"
+                  "    \"width\": %d,\n    \"height\": %d,\n    \"refreshRate\": 60.00000,\n"
+                  "    \"x\": %d,\n    \"y\": %d,\n",
+                  monitor.id, jsonString(monitor.name).c_str(), monitor.name.c_str(),
+                  monitor.width, monitor.height, monitor.x, monitor.y)
+        + format("    \"activeWorkspace\": {\n        \"id\": %d,\n        \"name\": \"%d\"\n    },\n"
+                 "    \"specialWorkspace\": {\n        \"id\": 0,\n        \"name\": \"\"\n    },\n"
+                 "    \"reserved\": [%d, %d, %d, %d],\n    \"scale\": %.2f,\n    \"transform\": 0,\n"
+                 "    \"focused\": %s,\n    \"dpmsStatus\": true,\n    \"vrr\": false,\n"
+                 "    \"disabled\": false,\n    \"availableModes\": [\"%dx%d@60.00Hz\"]\n}",
+                 monitor.activeWorkspace, monitor.activeWorkspace, monitor.reservedLeft, monitor.reservedTop,
+                 monitor.reservedRight, monitor.reservedBottom, monitor.scale,
+                 monitor.id == g_model.focusedMonitor ? "true" : "false", monitor.width, monitor.height);
+}
+
+template<typename T, typename F>
+std::string jsonArray(const std::vector<T> &items, F &&toJson)
+{
+    std::string out = "[";
+    for (size_t i = 0; i < items.size(); ++i) {
+        out += (i ? "," : "") + toJson(items[i]);
+    }
+    return out + "]";
+}
+
+// Requests
+
+uint64_t parseHex(const std::string &text)
+{
+    std::string digits = text.compare(0, 2, "0x") == 0 ? text.substr(2) : text;
+    return strtoull(digits.c_str(), nullptr, 16);
+}
+
+std::string trim(const std::string &text)
+{
+    size_t begin = text.find_first_not_of(" \t\n");
+    size_t end = text.find_last_not_of(" \t\n");
+    return begin == std::string::npos ? std::string() : text.substr(begin, end - begin + 1);
+}
+
+// Resolve a window selector ("address:0x...", empty or "active")
+Client *selectWindow(const std::string &selector)
+{
+    std::string trimmed = trim(selector);
+    if (trimmed.compare(0, 8, "address:") == 0) {
+        return clientByAddress(parseHex(trimmed.substr(8)));
+    }
+    return clientByAddress(g_model.activeWindow);
+}
+
+// Split "ARGS,address:0x..." into arguments and window selector
+void splitSelector(const std::string &args, std::string &params, std::string &selector)
+{
+    size_t comma = args.rfind(',');
+    if (comma == std::string::npos) {
+        params = args;
+        selector.clear();
+    } else {
+        params = args.substr(0, comma);
+        selector = args.substr(comma + 1);
+    }
+}
+
+std::string dispatch(const std::string &dispatcher, const std::string &args)
+{
+    if (dispatcher == "togglefloating" || dispatcher == "setfloating" || dispatcher == "settiled") {
+        Client *client = selectWindow(args);
+        if (!client) {
+            return "No such window";
+        }
+        bool floating = dispatcher == "togglefloating" ? !client->floating : dispatcher == "setfloating";
+        setFloating(*client, floating);
+        return "ok";
+    }
+    
+    if (dispatcher == "movewindowpixel" || dispatcher == "resizewindowpixel") {
+        std::string params, selector;
+        splitSelector(args, params, selector);
+        Client *client = selectWindow(selector);
+        if (!client) {
+            return "No such window";
+        }
+        
+        int a = 0, b = 0;
+        bool exact = params.compare(0, 5, "exact") == 0;
+        if (sscanf(params.c_str() + (exact ? 5 : 0), "%d %d", &a, &b) != 2) {
+            return "Invalid arguments";
+        }
+        
+        // Like Hyprland, pixel moves only take effect on floating windows
+        if (client->floating) {
+            if (dispatcher == "movewindowpixel") {
+                client->x = exact ? a : client->x + a;
+                client->y = exact ? b : client->y + b;
+            } else {
+                client->width = exact ? a : client->width + a;
+                client->height = exact ? b : client->height + b;
+            }
+        }
+        return "ok";
+    }
+    
+    if (dispatcher == "focuswindow") {
+        Client *client = selectWindow(args);
+        if (!client) {
+            return "No such window";
+        }
+        focusWindow(client->address);
+        return "ok";
+    }
+    
+    if (dispatcher == "workspace") {
+        int id = atoi(args.c_str());
+        Workspace *workspace = workspaceById(id);
+        if (!workspace) {
+            g_model.workspaces.push_back({id, g_model.focusedMonitor});
+            emitEvent("createworkspacev2", format("%d,%d", id, id));
+            workspace = &g_model.workspaces.back();
+        }
+        Monitor *monitor = monitorById(workspace->monitor);
+        g_model.focusedMonitor = workspace->monitor;
+        monitor->activeWorkspace = id;
+        emitEvent("workspacev2", format("%d,%d", id, id));
+        emitEvent("focusedmonv2", format("%s,%d", monitor->name.c_str(), id));
+        return "ok";
+    }
+    
+    if (dispatcher == "movetoworkspace" || dispatcher == "movetoworkspacesilent") {
+        std::string params, selector;
+        splitSelector(args, params, selector);
+        Client *client = selectWindow(selector);
+        int id = atoi(params.c_str());
+        if (!client || !workspaceById(id)) {
+            return "No such window or workspace";
+        }
+        int previous = client->workspace;
+        client->workspace = id;
+        relayout(previous);
+        relayout(id);
+        emitEvent("movewindowv2", format("%s,%d,%d", hexAddress(client->address).c_str(), id, id));
+        return "ok";
+    }
+    
+    if (dispatcher == "exec") {
+        // Every exec opens one window named after the command
+        Monitor *monitor = monitorById(g_model.focusedMonitor);
+        int workspace = monitor ? monitor->activeWorkspace : 1;
+        std::string name = trim(args);
+        Client &client = openWindow(name, name, workspace);
+        uint64_t address = client.address;
+        emitEvent("openwindow", format("%s,%d,", hexAddress(address).c_str(), workspace) + name + "," + name);
+        focusWindow(address);
+        return "ok";
+    }
+    
+    if (dispatcher == "killactive" || dispatcher == "closewindow") {
+        Client *client = selectWindow(dispatcher == "killactive" ? std::string() : args);
+        if (!client) {
+            return "No such window";
+        }
+        uint64_t address = client->address;
+        int workspace = client->workspace;
+        g_model.clients.erase(g_model.clients.begin() + (client - g_model.clients.data()));
+        relayout(workspace);
+        emitEvent("closewindow", hexAddress(address));
+        if (g_model.activeWindow == address) {
+            focusWindow(0);
+        }
+        return "ok";
+    }
+    
+    return "Invalid dispatcher";
+}
+
+std::string keyword(const std::string &name, const std::string &value)
+{
+    if (name != "windowrulev2") {
+        return "ok";
+    }
+    
+    // "unset,<matcher>" drops the rules with exactly that matcher
+    if (value.compare(0, 6, "unset,") == 0) {
+        const std::string matcher = value.substr(6);
+        g_model.rules.erase(std::remove_if(g_model.rules.begin(), g_model.rules.end(), [&](const std::string &rule) {
+            size_t comma = rule.find(',');
+            return comma != std::string::npos && rule.substr(comma + 1) == matcher;
+        }), g_model.rules.end());
+        return "ok";
+    }
+    
+    g_model.rules.push_back(value);
+    return "ok";
+}
+
+std::string handleCommand(std::string command)
+{
+    command = trim(command);
+    ++g_commandCount;
+    
+    // Flags precede the first '/', e.g. "j/clients"
+    bool json = false;
+    size_t slash = command.find('/');
+    size_t space = command.find(' ');
+    if (slash != std::string::npos && (space == std::string::npos || slash < space)) {
+        json = command.substr(0, slash).find('j') != std::string::npos;
+        command = command.substr(slash + 1);
+    }
+    
+    space = command.find(' ');
+    const std::string verb = command.substr(0, space);
+    const std::string rest = space == std::string::npos ? std::string() : trim(command.substr(space + 1));
+    
+    if (verb == "dispatch") {
+        size_t argSpace = rest.find(' ');
+        return dispatch(rest.substr(0, argSpace), argSpace == std::string::npos ? std::string() : trim(rest.substr(argSpace + 1)));
+    }
+    if (verb == "keyword") {
+        size_t argSpace = rest.find(' ');
+        return keyword(rest.substr(0, argSpace), argSpace == std::string::npos ? std::string() : trim(rest.substr(argSpace + 1)));
+    }
+    if (verb == "reload") {
+        g_model.rules.clear();
+        emitEvent("configreloaded", "");
+        return "ok";
+    }
+    
+    if (!json) {
+        // Only the JSON forms are modelled
+        return "mock: only JSON queries are supported";
+    }
+    if (verb == "clients") {
+        return jsonArray(g_model.clients, windowJson);
+    }
+    if (verb == "monitors") {
+        return jsonArray(g_model.monitors, monitorJson);
+    }
+    if (verb == "workspaces") {
+        return jsonArray(g_model.workspaces, workspaceJson);
+    }
+    if (verb == "activewindow") {
+        Client *client = clientByAddress(g_model.activeWindow);
+        return client ? windowJson(*client) : "{}";
+    }
+    if (verb == "activeworkspace") {
+        Monitor *monitor = monitorById(g_model.focusedMonitor);
+        Workspace *workspace = monitor ? workspaceById(monitor->activeWorkspace) : nullptr;
+        return workspace ? workspaceJson(*workspace) : "{}";
+    }
+    if (verb == "version") {
+        return "{\n    \"branch\": \"mock\",\n    \"commit\": \"\",\n    \"tag\": \"mock\"\n}";
+    }
+    return "unknown request";
+}
+
+std::string handleRequest(const std::string &request)
+{
+    static const std::string batchTag = "[[BATCH]]";
+    if (request.compare(0, batchTag.size(), batchTag) != 0) {
+        return handleCommand(request);
+    }
+    
+    std::string reply;
+    size_t start = batchTag.size();
+    while (start <= request.size()) {
+        size_t end = request.find(';', start);
+        if (end == std::string::npos) {
+            end = request.size();
+        }
+        std::string command = trim(request.substr(start, end - start));
+        if (!command.empty()) {
+            if (!reply.empty()) {
+                reply += "\n\n\n";
+            }
+            reply += handleCommand(command);
+        }
+        start = end + 1;
+    }
+    return reply;
+}
+
+void serveRequest(int fd)
+{
+    // Hyprland reads one request per connection and closes after replying
+    const long long acceptedUs = monotonicUs();
+    std::string request;
+    char buffer[8192];
+    pollfd pfd = {fd, POLLIN, 0};
+    while (poll(&pfd, 1, request.empty() ? 1000 : 0) > 0) {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n <= 0) {
+            break;
+        }
+        request.append(buffer, static_cast<size_t>(n));
+    }
+    
+    std::string reply;
+    if (trim(request) == "j/mockstats") {
+        reply = format("{\"requests\": %ld, \"commands\": %ld, \"firstRequestUs\": %lld}",
+                       g_requestCount, g_commandCount, g_firstRequestUs);
+        g_firstRequestUs = -1;
+    } else {
+        ++g_requestCount;
+        if (g_firstRequestUs < 0) {
+            g_firstRequestUs = acceptedUs;
+        }
+        reply = handleRequest(request);
+    }
+    if (g_latencyMs > 0) {
+        usleep(static_cast<useconds_t>(g_latencyMs) * 1000);
+    }
+    
+    size_t written = 0;
+    while (written < reply.size()) {
+        ssize_t n = send(fd, reply.data() + written, reply.size() - written, MSG_NOSIGNAL);
+        if (n <= 0) {
+            break;
+        }
+        written += static_cast<size_t>(n);
+    }
+    close(fd);
+}
+
+// Setup
+
+int listenOn(const std::string &path)
+{
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "mock: socket path too long: %s\n", path.c_str());
+        return -1;
+    }
+    memcpy(addr.sun_path, path.c_str(), path.size());
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || listen(fd, 64) != 0) {
+        perror("mock: cannot listen");
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    return fd;
+}
+
+int connectTo(const std::string &path)
+{
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        return -1;
+    }
+    memcpy(addr.sun_path, path.c_str(), path.size());
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool parseMonitors(const std::string &spec)
+{
+    g_model.monitors.clear();
+    int nextX = 0;
+    size_t start = 0;
+    while (start < spec.size()) {
+        size_t end = spec.find(',', start);
+        std::string entry = spec.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        start = end == std::string::npos ? spec.size() : end + 1;
+        
+        Monitor monitor;
+        size_t colon = entry.find(':');
+        if (colon == std::string::npos) {
+            return false;
+        }
+        monitor.id = static_cast<int>(g_model.monitors.size());
+        monitor.name = entry.substr(0, colon);
+        monitor.x = -1;
+        
+        const char *geometry = entry.c_str() + colon + 1;
+        int consumed = 0;
+        if (sscanf(geometry, "%dx%d%n", &monitor.width, &monitor.height, &consumed) != 2) {
+            return false;
+        }
+        geometry += consumed;
+        if (*geometry == '@') {
+            monitor.scale = strtod(geometry + 1, const_cast<char **>(&geometry));
+        }
+        if (*geometry == '+') {
+            consumed = 0;
+            sscanf(geometry, "+%d+%d%n", &monitor.x, &monitor.y, &consumed);
+            geometry += consumed;
+        }
+        if (*geometry == '/') {
+            if (sscanf(geometry, "/%d:%d:%d:%d", &monitor.reservedLeft, &monitor.reservedTop,
+                       &monitor.reservedRight, &monitor.reservedBottom) != 4) {
+                return false;
+            }
+            monitor.reservedGiven = true;
+        }
+        if (monitor.x < 0) {
+            monitor.x = nextX;
+        }
+        nextX = monitor.x + static_cast<int>(monitor.width / monitor.scale);
+        g_model.monitors.push_back(monitor);
+    }
+    return !g_model.monitors.empty();
+}
+
+void buildModel(int workspacesPerMonitor, int clientCount)
+{
+    static const char *const names[][2] = {
+        {"kitty", "~/src/hyprgrid"},
+        {"firefox", "Mozilla Firefox"},
+        {"org.gnome.Nautilus", "Downloads"},
+        {"code", "gridmanager.cpp - hyprgrid - Visual Studio Code"},
+        {"discord", "Discord | #general"},
+        {"Spotify", "Spotify Premium"},
+    };
+    
+    int id = 1;
+    for (Monitor &monitor : g_model.monitors) {
+        if (!monitor.reservedGiven) {
+            monitor.reservedTop = monitor.id == 0 ? 40 : 0;
+        }
+        monitor.activeWorkspace = id;
+        for (int i = 0; i < workspacesPerMonitor; ++i) {
+            g_model.workspaces.push_back({id++, monitor.id});
+        }
+    }
+    
+    for (int i = 0; i < clientCount; ++i) {
+        const auto &name = names[i % (sizeof(names) / sizeof(names[0]))];
+        int workspace = g_model.workspaces[static_cast<size_t>(i) % g_model.workspaces.size()].id;
+        openWindow(name[0], name[1], workspace);
+    }
+    
+    // Focus the first window on the focused monitor's active workspace
+    const int active = g_model.monitors.front().activeWorkspace;
+    for (const Client &client : g_model.clients) {
+        if (client.workspace == active) {
+            g_model.activeWindow = client.address;
+            break;
+        }
+    }
+}
+
+bool installHyprctl(const std::string &dir)
+{
+    char self[PATH_MAX];
+    ssize_t length = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (length <= 0) {
+        return false;
+    }
+    self[length] = '\0';
+    
+    const std::string path = dir + "/hyprctl";
+    FILE *script = fopen(path.c_str(), "w");
+    if (!script) {
+        return false;
+    }
+    fprintf(script, "#!/bin/sh\n# hyprctl stand-in talking to hypr-grid-mock-hyprland\nexec '%s' --hyprctl \"$@\"\n", self);
+    fclose(script);
+    return chmod(path.c_str(), 0755) == 0;
+}
+
+// Client mode: the subset of hyprctl's command line that hypr-grid-manager uses
+int runHyprctl(int argc, char *argv[])
+{
+    bool json = false;
+    std::string batch;
+    std::string command;
+    for (int i = 0; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-j") {
+            json = true;
+        } else if (arg == "--batch" && i + 1 < argc) {
+            batch = argv[++i];
+        } else {
+            command += (command.empty() ? "" : " ") + arg;
+        }
+    }
+    
+    std::string request = !batch.empty() ? "[[BATCH]]" + batch : (json ? "j/" : "") + command;
+    
+    const char *runtime = getenv("XDG_RUNTIME_DIR");
+    const char *signature = getenv("HYPRLAND_INSTANCE_SIGNATURE");
+    if (!runtime || !signature) {
+        fprintf(stderr, "HYPRLAND_INSTANCE_SIGNATURE not set! (is hyprland running?)\n");
+        return 1;
+    }
+    
+    int fd = connectTo(std::string(runtime) + "/hypr/" + signature + "/.socket.sock");
+    if (fd < 0 || write(fd, request.data(), request.size()) != static_cast<ssize_t>(request.size())) {
+        fprintf(stderr, "Couldn't connect to the mock Hyprland socket\n");
+        return 1;
+    }
+    
+    char buffer[8192];
+    ssize_t n;
+    char last = '\n';
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+        fwrite(buffer, 1, static_cast<size_t>(n), stdout);
+        last = buffer[n - 1];
+    }
+    if (last != '\n') {
+        fputc('\n', stdout);
+    }
+    close(fd);
+    return 0;
+}
+
+int usage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [--signature NAME] [--runtime-dir DIR] [--monitors SPEC] [--clients N]\n"
+            "          [--workspaces N] [--latency MS] [--install-hyprctl DIR] [-- command args...]\n"
+            "       %s --hyprctl [hyprctl args...]\n",
+            program, program);
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && strcmp(argv[1], "--hyprctl") == 0) {
+        return runHyprctl(argc - 2, argv + 2);
+    }
+    
+    std::string signature = format("mock_%d", static_cast<int>(getpid()));
+    std::string runtimeDir;
+    std::string monitorSpec = "DP-1:2560x1440";
+    std::string hyprctlDir;
+    int clientCount = 4;
+    int workspacesPerMonitor = 2;
+    char **command = nullptr;
+    
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--") {
+            command = argv + i + 1;
+            break;
+        } else if (arg == "--signature" && hasValue) {
+            signature = argv[++i];
+        } else if (arg == "--runtime-dir" && hasValue) {
+            runtimeDir = argv[++i];
+        } else if (arg == "--monitors" && hasValue) {
+            monitorSpec = argv[++i];
+        } else if (arg == "--clients" && hasValue) {
+            clientCount = atoi(argv[++i]);
+        } else if (arg == "--workspaces" && hasValue) {
+            workspacesPerMonitor = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--latency" && hasValue) {
+            g_latencyMs = atoi(argv[++i]);
+        } else if (arg == "--install-hyprctl" && hasValue) {
+            hyprctlDir = argv[++i];
+        } else {
+            return usage(argv[0]);
+        }
+    }
+    
+    if (!parseMonitors(monitorSpec)) {
+        fprintf(stderr, "mock: invalid monitor spec: %s\n", monitorSpec.c_str());
+        return 2;
+    }
+    buildModel(workspacesPerMonitor, clientCount);
+    
+    // A fresh runtime dir keeps the mock away from a real Hyprland session
+    bool ownRuntimeDir = runtimeDir.empty();
+    if (ownRuntimeDir) {
+        char pattern[] = "/tmp/hypr-grid-mock.XXXXXX";
+        if (!mkdtemp(pattern)) {
+            perror("mock: mkdtemp");
+            return 1;
+        }
+        runtimeDir = pattern;
+    }
+    
+    const std::string hyprDir = runtimeDir + "/hypr";
+    const std::string instanceDir = hyprDir + "/" + signature;
+    mkdir(hyprDir.c_str(), 0700);
+    if (mkdir(instanceDir.c_str(), 0700) != 0 && errno != EEXIST) {
+        perror("mock: cannot create instance directory");
+        return 1;
+    }
+    
+    const std::string requestPath = instanceDir + "/.socket.sock";
+    const std::string eventPath = instanceDir + "/.socket2.sock";
+    unlink(requestPath.c_str());
+    unlink(eventPath.c_str());
+    int requestFd = listenOn(requestPath);
+    int eventFd = listenOn(eventPath);
+    if (requestFd < 0 || eventFd < 0) {
+        return 1;
+    }
+    
+    if (!hyprctlDir.empty() && !installHyprctl(hyprctlDir)) {
+        fprintf(stderr, "mock: cannot install hyprctl into %s\n", hyprctlDir.c_str());
+        return 1;
+    }
+    
+    setenv("XDG_RUNTIME_DIR", runtimeDir.c_str(), 1);
+    setenv("HYPRLAND_INSTANCE_SIGNATURE", signature.c_str(), 1);
+    
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = onStopSignal;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    
+    pid_t child = -1;
+    int exitCode = 0;
+    if (command && *command) {
+        child = fork();
+        if (child == 0) {
+            close(requestFd);
+            close(eventFd);
+            execvp(command[0], command);
+            perror("mock: exec");
+            _exit(127);
+        }
+    } else {
+        printf("export XDG_RUNTIME_DIR=%s\nexport HYPRLAND_INSTANCE_SIGNATURE=%s\n",
+               runtimeDir.c_str(), signature.c_str());
+        fflush(stdout);
+    }
+    
+    while (!g_stop) {
+        pollfd fds[2] = {{requestFd, POLLIN, 0}, {eventFd, POLLIN, 0}};
+        int ready = poll(fds, 2, child > 0 ? 20 : 250);
+        
+        if (ready > 0 && (fds[1].revents & POLLIN)) {
+            int fd = accept4(eventFd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+            if (fd >= 0) {
+                g_eventClients.push_back(fd);
+            }
+        }
+        if (ready > 0 && (fds[0].revents & POLLIN)) {
+            int fd = accept4(requestFd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd >= 0) {
+                serveRequest(fd);
+            }
+        }
+        
+        if (child > 0) {
+            int status = 0;
+            if (waitpid(child, &status, WNOHANG) == child) {
+                exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+                break;
+            }
+        }
+    }
+    
+    for (int fd : g_eventClients) {
+        close(fd);
+    }
+    close(requestFd);
+    close(eventFd);
+    unlink(requestPath.c_str());
+    unlink(eventPath.c_str());
+    rmdir(instanceDir.c_str());
+    if (ownRuntimeDir) {
+        rmdir(hyprDir.c_str());
+        rmdir(runtimeDir.c_str());
+    }
+    return exitCode;
+}